@@ -0,0 +1,184 @@
+// Micro-benchmark of the DFG pass hot paths: pattern extraction (handleLoop,
+// buildLoopDFG), dependence enumeration (LoopUnrollAnalysis::checkDependence,
+// which prints the dependent pairs as it finds them) and output emission,
+// timed separately over LLVM IR inputs such as the loop nests generated by
+// script/gen_loop_nest.py.
+//
+//   loop_bench [-repeat=N] nest1.ll nest2.ll ...
+#include "dfg_pass.h"
+
+#include <llvm/ADT/Triple.h>
+#include <llvm/Analysis/AssumptionCache.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <chrono>
+#include <cstdio>
+#include <sys/resource.h>
+
+char DFGPass::ID = 0;
+
+// Shared by all inputs and repetitions, like the kernel cache of the pass
+static DFGJIT jit;
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+                                        cl::desc("<input .ll/.bc files>"));
+static cl::opt<int> Repeat("repeat", cl::init(1),
+                           cl::desc("Number of times each input is analyzed"));
+
+// Sink for the emission phase, so that only formatting is measured
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+};
+
+struct bench_result_t {
+  double extract = 0;  // seconds in handleLoop and buildLoopDFG
+  double depcheck = 0; // seconds in checkDependence, with its pairs
+  double emit = 0;     // seconds in dumpLoopMemPatTree / dumpDependence
+  long long iters = 0;
+  long long acs = 0;
+  long long pairs = 0;
+  int leaf_loops = 0;
+  long long sim_accesses = 0; // with -dfg-cache-sim
+  double sim_time = 0;
+};
+
+static double now() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void collectLeafLoops(LoopMemPatNode *n,
+                             std::vector<LoopMemPatNode *> &leaves) {
+  if (n->getType() == LOOP_NODE && !n->hasLoopChild()) {
+    leaves.push_back(n);
+  }
+  for (auto child : n->getChildren()) {
+    collectLeafLoops(child, leaves);
+  }
+}
+
+static void benchFunction(Function &F, DataLayout *DL, bench_result_t &r) {
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+  TargetLibraryInfoImpl TLII(Triple(F.getParent()->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  AssumptionCache AC(F);
+  ScalarEvolution SE(F, TLI, AC, DT, LI);
+
+  DFGPass pass;
+  LoopMemPatNode *func_node = new LoopMemPatNode(FUNC_NODE, F.getName().str());
+
+  double t0 = now();
+  for (LoopInfo::iterator LL = LI.begin(), LEnd = LI.end(); LL != LEnd; ++LL) {
+    pass.handleLoop(*LL, LI, DL, SE, &F, func_node);
+  }
+  for (Loop *L : LI) {
+    pass.buildLoopDFG(L, LI);
+  }
+  double t1 = now();
+  r.extract += t1 - t0;
+
+  std::vector<LoopMemPatNode *> leaves;
+  collectLeafLoops(func_node, leaves);
+  std::vector<LoopUnrollAnalysis *> analyses;
+  NullBuffer null_buffer;
+  std::ostream null_stream(&null_buffer);
+  for (auto leaf : leaves) {
+    LoopUnrollAnalysis *a = new LoopUnrollAnalysis(leaf);
+    a->setOutput(&null_stream);
+    a->setPrescreen(DFGPrescreen);
+    a->setDenseLimit((long long)DFGDenseTableLimit << 20);
+    a->setWindow(DFGWindowed, DFGWindow);
+    a->setSpecialize(DFGSpecialize);
+    a->setSpill(DFGSpillDir, (long long)DFGSpillThreshold << 20,
+                DFGSpillPartitions);
+    if (DFGUseJIT) {
+      a->setJIT(&jit, DFGJITMinIters);
+    }
+    a->checkDependence();
+    analyses.push_back(a);
+  }
+  double t2 = now();
+  r.depcheck += t2 - t1;
+  if (DFGCacheSim) {
+    cache_config_t cache = getCacheConfig();
+    for (auto a : analyses) {
+      cache_sim_report_t sim = a->simulateCache(cache);
+      r.sim_accesses += sim.accesses;
+      r.sim_time += sim.seconds;
+    }
+    t2 = now();
+  }
+
+  std::streambuf *cout_buffer = std::cout.rdbuf(&null_buffer);
+  dumpLoopMemPatTree(func_node, 0);
+  for (auto a : analyses) {
+    a->dumpDependence();
+  }
+  std::cout.rdbuf(cout_buffer);
+  r.emit += now() - t2;
+
+  for (auto a : analyses) {
+    r.iters += a->getNumIters();
+    r.acs += a->getNumAccesses();
+    r.pairs += a->getNumPairs();
+    delete a;
+  }
+  r.leaf_loops += leaves.size();
+}
+
+static double peakRSSMB() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0; // ru_maxrss is in KB on Linux
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "DFG pass micro-benchmark\n");
+  if (Repeat < 1) {
+    Repeat = 1;
+  }
+
+  printf("%-32s %6s %10s %10s %10s %12s %12s %10s %9s\n", "input", "loops",
+         "extract_s", "depchk_s", "emit_s", "iters/s", "accesses/s", "pairs",
+         "rss_MB");
+  for (auto &file : InputFiles) {
+    LLVMContext ctx;
+    SMDiagnostic err;
+    std::unique_ptr<Module> M = parseIRFile(file, err, ctx);
+    if (!M) {
+      err.print(argv[0], errs());
+      return 1;
+    }
+    DataLayout *DL = new DataLayout(M.get());
+
+    bench_result_t r;
+    for (int rep = 0; rep < Repeat; rep++) {
+      for (auto &F : *M) {
+        if (!F.isDeclaration()) {
+          benchFunction(F, DL, r);
+        }
+      }
+    }
+    delete DL;
+
+    double depcheck = r.depcheck > 0 ? r.depcheck : 1e-9;
+    printf("%-32s %6d %10.4f %10.4f %10.4f %12.4g %12.4g %10lld %9.1f\n",
+           file.c_str(), r.leaf_loops / Repeat, r.extract / Repeat,
+           r.depcheck / Repeat, r.emit / Repeat, r.iters / depcheck,
+           r.acs / depcheck, r.pairs / Repeat, peakRSSMB());
+    if (DFGCacheSim) {
+      printf("%-32s cache simulation %12.4g accesses/s\n", "",
+             r.sim_accesses / (r.sim_time > 0 ? r.sim_time : 1e-9));
+    }
+    fflush(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,18 @@
+// gemm, after PolyBench/C 4.2
+#define NI 48
+#define NJ 56
+#define NK 64
+
+void kernel_gemm(double alpha, double beta, double C[NI][NJ],
+                 double A[NI][NK], double B[NK][NJ]) {
+    for (int i = 0; i < NI; i++) {
+        for (int j = 0; j < NJ; j++) {
+            C[i][j] *= beta;
+        }
+        for (int k = 0; k < NK; k++) {
+            for (int j = 0; j < NJ; j++) {
+                C[i][j] += alpha * A[i][k] * B[k][j];
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+// jacobi-2d, after PolyBench/C 4.2
+#define TSTEPS 10
+#define N 64
+
+void kernel_jacobi_2d(double A[N][N], double B[N][N]) {
+    for (int t = 0; t < TSTEPS; t++) {
+        for (int i = 1; i < N - 1; i++) {
+            for (int j = 1; j < N - 1; j++) {
+                B[i][j] = 0.2 * (A[i][j] + A[i][j - 1] + A[i][j + 1]
+                                 + A[i + 1][j] + A[i - 1][j]);
+            }
+        }
+        for (int i = 1; i < N - 1; i++) {
+            for (int j = 1; j < N - 1; j++) {
+                A[i][j] = 0.2 * (B[i][j] + B[i][j - 1] + B[i][j + 1]
+                                 + B[i + 1][j] + B[i - 1][j]);
+            }
+        }
+    }
+}
@@ -0,0 +1,15 @@
+// seidel-2d, after PolyBench/C 4.2
+#define TSTEPS 10
+#define N 64
+
+void kernel_seidel_2d(double A[N][N]) {
+    for (int t = 0; t < TSTEPS; t++) {
+        for (int i = 1; i < N - 1; i++) {
+            for (int j = 1; j < N - 1; j++) {
+                A[i][j] = (A[i - 1][j - 1] + A[i - 1][j] + A[i - 1][j + 1]
+                           + A[i][j - 1] + A[i][j] + A[i][j + 1]
+                           + A[i + 1][j - 1] + A[i + 1][j] + A[i + 1][j + 1]) / 9.0;
+            }
+        }
+    }
+}
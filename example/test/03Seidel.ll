@@ -0,0 +1,40 @@
+; In-place 5-point Gauss-Seidel sweep: no loop is parallel, and the wavefront
+; schedule is the hyperplane (1, 1)
+define void @seidel2d([10 x double]* %A) {
+entry:
+  br label %outer.header
+outer.header:
+  %i = phi i64 [ 1, %entry ], [ %i.next, %outer.latch ]
+  %im1 = add nsw i64 %i, -1
+  %ip1 = add nuw nsw i64 %i, 1
+  br label %inner.header
+inner.header:
+  %j = phi i64 [ 1, %outer.header ], [ %j.next, %inner.header ]
+  %jm1 = add nsw i64 %j, -1
+  %jp1 = add nuw nsw i64 %j, 1
+  %p0 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %im1, i64 %j
+  %v0 = load double, double* %p0
+  %p1 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %i, i64 %jm1
+  %v1 = load double, double* %p1
+  %p2 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %i, i64 %j
+  %v2 = load double, double* %p2
+  %p3 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %i, i64 %jp1
+  %v3 = load double, double* %p3
+  %p4 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %ip1, i64 %j
+  %v4 = load double, double* %p4
+  %s0 = fadd double %v0, %v1
+  %s1 = fadd double %s0, %v2
+  %s2 = fadd double %s1, %v3
+  %s3 = fadd double %s2, %v4
+  %r = fdiv double %s3, 5.0
+  store double %r, double* %p2
+  %j.next = add nuw nsw i64 %j, 1
+  %c = icmp eq i64 %j.next, 9
+  br i1 %c, label %outer.latch, label %inner.header
+outer.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %c2 = icmp eq i64 %i.next, 9
+  br i1 %c2, label %exit, label %outer.header
+exit:
+  ret void
+}
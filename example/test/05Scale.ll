@@ -0,0 +1,24 @@
+; In-place update A[i][j] *= 2: the element read is the one written, so both
+; loops are parallel and there is no memory recurrence
+define void @scale([64 x double]* %A) {
+entry:
+  br label %Li
+Li:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  br label %Lj
+Lj:
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v = load double, double* %p, align 8
+  %w = fmul double %v, 2.0
+  store double %w, double* %p, align 8
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj
+Li.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 64
+  br i1 %ci, label %exit, label %Li
+exit:
+  ret void
+}
@@ -0,0 +1,88 @@
+; Sibling loop nests: the copy pipeline of @same fuses, the second nest of
+; @ahead reads A[k][l+1] before the first one writes it, so it does not
+define void @same([64 x double]* %A, [64 x double]* %B, [64 x double]* %C) {
+entry:
+  br label %Li
+Li:
+  %i = phi i64 [ 1, %entry ], [ %i.next, %Li.latch ]
+  br label %Lj
+Lj:
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  %v = load double, double* %p, align 8
+  %w = fmul double %v, 2.0
+  %q = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  store double %w, double* %q, align 8
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 63
+  br i1 %cj, label %Li.latch, label %Lj
+Li.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 63
+  br i1 %ci, label %mid, label %Li
+mid:
+  br label %Mi
+Mi:
+  %k = phi i64 [ 1, %mid ], [ %k.next, %Mi.latch ]
+  br label %Mj
+Mj:
+  %l = phi i64 [ 0, %Mi ], [ %l.next, %Mj ]
+  %ko = add nsw i64 %k, 0
+  %lo = add nsw i64 %l, 0
+  %r = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ko, i64 %lo
+  %x = load double, double* %r, align 8
+  %s = getelementptr inbounds [64 x double], [64 x double]* %C, i64 %k, i64 %l
+  store double %x, double* %s, align 8
+  %l.next = add nuw nsw i64 %l, 1
+  %cl = icmp eq i64 %l.next, 63
+  br i1 %cl, label %Mi.latch, label %Mj
+Mi.latch:
+  %k.next = add nuw nsw i64 %k, 1
+  %ck = icmp eq i64 %k.next, 63
+  br i1 %ck, label %exit, label %Mi
+exit:
+  ret void
+}
+define void @ahead([64 x double]* %A, [64 x double]* %B, [64 x double]* %C) {
+entry:
+  br label %Li
+Li:
+  %i = phi i64 [ 1, %entry ], [ %i.next, %Li.latch ]
+  br label %Lj
+Lj:
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  %v = load double, double* %p, align 8
+  %w = fmul double %v, 2.0
+  %q = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  store double %w, double* %q, align 8
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 63
+  br i1 %cj, label %Li.latch, label %Lj
+Li.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 63
+  br i1 %ci, label %mid, label %Li
+mid:
+  br label %Mi
+Mi:
+  %k = phi i64 [ 1, %mid ], [ %k.next, %Mi.latch ]
+  br label %Mj
+Mj:
+  %l = phi i64 [ 0, %Mi ], [ %l.next, %Mj ]
+  %ko = add nsw i64 %k, 0
+  %lo = add nsw i64 %l, 1
+  %r = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ko, i64 %lo
+  %x = load double, double* %r, align 8
+  %s = getelementptr inbounds [64 x double], [64 x double]* %C, i64 %k, i64 %l
+  store double %x, double* %s, align 8
+  %l.next = add nuw nsw i64 %l, 1
+  %cl = icmp eq i64 %l.next, 63
+  br i1 %cl, label %Mi.latch, label %Mj
+Mi.latch:
+  %k.next = add nuw nsw i64 %k, 1
+  %ck = icmp eq i64 %k.next, 63
+  br i1 %ck, label %exit, label %Mi
+exit:
+  ret void
+}
@@ -0,0 +1,88 @@
+; Unroll-and-jam of the i loop: @perfect reuses A[i+1][j] one outer
+; iteration later and jams; @imperfect also clears C[i] in the i loop, and
+; @call calls an unknown function in the j loop, so neither jams
+declare void @touch(double*)
+
+define void @perfect([64 x double]* %A, [64 x double]* %B) {
+entry:
+  br label %Li
+Li:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  %ip1 = add nuw nsw i64 %i, 1
+  br label %Lj
+Lj:
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p0 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v0 = load double, double* %p0, align 8
+  %p1 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ip1, i64 %j
+  %v1 = load double, double* %p1, align 8
+  %s = fadd double %v0, %v1
+  %q = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  store double %s, double* %q, align 8
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj
+Li.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 32
+  br i1 %ci, label %exit, label %Li
+exit:
+  ret void
+}
+
+define void @imperfect([64 x double]* %A, [64 x double]* %B, double* %C) {
+entry:
+  br label %Li
+Li:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  %ip1 = add nuw nsw i64 %i, 1
+  %c = getelementptr inbounds double, double* %C, i64 %i
+  store double 0.0, double* %c, align 8
+  br label %Lj
+Lj:
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p0 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v0 = load double, double* %p0, align 8
+  %p1 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ip1, i64 %j
+  %v1 = load double, double* %p1, align 8
+  %s = fadd double %v0, %v1
+  %q = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  store double %s, double* %q, align 8
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj
+Li.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 32
+  br i1 %ci, label %exit, label %Li
+exit:
+  ret void
+}
+
+define void @call([64 x double]* %A, [64 x double]* %B) {
+entry:
+  br label %Li
+Li:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  %ip1 = add nuw nsw i64 %i, 1
+  br label %Lj
+Lj:
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p0 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v0 = load double, double* %p0, align 8
+  %p1 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ip1, i64 %j
+  %v1 = load double, double* %p1, align 8
+  %s = fadd double %v0, %v1
+  %q = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  store double %s, double* %q, align 8
+  call void @touch(double* %q)
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj
+Li.latch:
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 32
+  br i1 %ci, label %exit, label %Li
+exit:
+  ret void
+}
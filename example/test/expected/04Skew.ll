@@ -0,0 +1,45 @@
+; ModuleID = '04Skew.ll'
+source_filename = "04Skew.ll"
+
+define void @skew([10 x double]* %A) {
+entry:
+  br label %outer.header
+
+outer.header:                                     ; preds = %outer.latch, %entry
+  %i = phi i64 [ 1, %entry ], [ %i.next, %outer.latch ]
+  %im1 = add nsw i64 %i, -1
+  %ip1 = add nuw nsw i64 %i, 1
+  br label %inner.header
+
+inner.header:                                     ; preds = %inner.header, %outer.header
+  %j = phi i64 [ 1, %outer.header ], [ %j.next, %inner.header ]
+  %jm1 = add nsw i64 %j, -1
+  %jp1 = add nuw nsw i64 %j, 1
+  %p0 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %im1, i64 %jp1
+  %v0 = load double, double* %p0, align 8
+  %p1 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %i, i64 %jm1
+  %v1 = load double, double* %p1, align 8
+  %p2 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %i, i64 %j
+  %v2 = load double, double* %p2, align 8
+  %p3 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %i, i64 %jp1
+  %v3 = load double, double* %p3, align 8
+  %p4 = getelementptr inbounds [10 x double], [10 x double]* %A, i64 %ip1, i64 %j
+  %v4 = load double, double* %p4, align 8
+  %s0 = fadd double %v0, %v1
+  %s1 = fadd double %s0, %v2
+  %s2 = fadd double %s1, %v3
+  %s3 = fadd double %s2, %v4
+  %r = fdiv double %s3, 5.000000e+00
+  store double %r, double* %p2, align 8
+  %j.next = add nuw nsw i64 %j, 1
+  %c = icmp eq i64 %j.next, 9
+  br i1 %c, label %outer.latch, label %inner.header
+
+outer.latch:                                      ; preds = %inner.header
+  %i.next = add nuw nsw i64 %i, 1
+  %c2 = icmp eq i64 %i.next, 9
+  br i1 %c2, label %exit, label %outer.header
+
+exit:                                             ; preds = %outer.latch
+  ret void
+}
@@ -0,0 +1,38 @@
+; ModuleID = '05Scale.ll'
+source_filename = "05Scale.ll"
+
+define void @scale([64 x double]* %A) {
+entry:
+  br label %Li
+
+Li:                                               ; preds = %Li.latch, %entry
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  br label %Lj
+
+Lj:                                               ; preds = %Lj, %Li
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v = load double, double* %p, align 8, !llvm.access.group !0
+  %w = fmul double %v, 2.000000e+00
+  store double %w, double* %p, align 8, !llvm.access.group !0
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj, !llvm.loop !3
+
+Li.latch:                                         ; preds = %Lj
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 64
+  br i1 %ci, label %exit, label %Li, !llvm.loop !6
+
+exit:                                             ; preds = %Li.latch
+  ret void
+}
+
+!0 = !{!1, !2}
+!1 = distinct !{}
+!2 = distinct !{}
+!3 = distinct !{!3, !4, !5}
+!4 = !{!"llvm.loop.unroll.count", i32 8}
+!5 = !{!"llvm.loop.parallel_accesses", !2}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.parallel_accesses", !1}
@@ -0,0 +1,135 @@
+; ModuleID = '06Fuse.ll'
+source_filename = "06Fuse.ll"
+
+define void @same([64 x double]* %A, [64 x double]* %B, [64 x double]* %C) {
+entry:
+  br label %Li
+
+Li:                                               ; preds = %Li.latch, %entry
+  %i = phi i64 [ 1, %entry ], [ %i.next, %Li.latch ]
+  br label %Lj
+
+Lj:                                               ; preds = %Lj, %Li
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  %v = load double, double* %p, align 8, !llvm.access.group !0
+  %w = fmul double %v, 2.000000e+00
+  %q = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  store double %w, double* %q, align 8, !llvm.access.group !0
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 63
+  br i1 %cj, label %Li.latch, label %Lj, !llvm.loop !3
+
+Li.latch:                                         ; preds = %Lj
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 63
+  br i1 %ci, label %mid, label %Li, !llvm.loop !5
+
+mid:                                              ; preds = %Li.latch
+  br label %Mi
+
+Mi:                                               ; preds = %Mi.latch, %mid
+  %k = phi i64 [ 1, %mid ], [ %k.next, %Mi.latch ]
+  br label %Mj
+
+Mj:                                               ; preds = %Mj, %Mi
+  %l = phi i64 [ 0, %Mi ], [ %l.next, %Mj ]
+  %ko = add nsw i64 %k, 0
+  %lo = add nsw i64 %l, 0
+  %r = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ko, i64 %lo
+  %x = load double, double* %r, align 8, !llvm.access.group !7
+  %s = getelementptr inbounds [64 x double], [64 x double]* %C, i64 %k, i64 %l
+  store double %x, double* %s, align 8, !llvm.access.group !7
+  %l.next = add nuw nsw i64 %l, 1
+  %cl = icmp eq i64 %l.next, 63
+  br i1 %cl, label %Mi.latch, label %Mj, !llvm.loop !10
+
+Mi.latch:                                         ; preds = %Mj
+  %k.next = add nuw nsw i64 %k, 1
+  %ck = icmp eq i64 %k.next, 63
+  br i1 %ck, label %exit, label %Mi, !llvm.loop !12
+
+exit:                                             ; preds = %Mi.latch
+  ret void
+}
+
+define void @ahead([64 x double]* %A, [64 x double]* %B, [64 x double]* %C) {
+entry:
+  br label %Li
+
+Li:                                               ; preds = %Li.latch, %entry
+  %i = phi i64 [ 1, %entry ], [ %i.next, %Li.latch ]
+  br label %Lj
+
+Lj:                                               ; preds = %Lj, %Li
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  %v = load double, double* %p, align 8, !llvm.access.group !14
+  %w = fmul double %v, 2.000000e+00
+  %q = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  store double %w, double* %q, align 8, !llvm.access.group !14
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 63
+  br i1 %cj, label %Li.latch, label %Lj, !llvm.loop !17
+
+Li.latch:                                         ; preds = %Lj
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 63
+  br i1 %ci, label %mid, label %Li, !llvm.loop !19
+
+mid:                                              ; preds = %Li.latch
+  br label %Mi
+
+Mi:                                               ; preds = %Mi.latch, %mid
+  %k = phi i64 [ 1, %mid ], [ %k.next, %Mi.latch ]
+  br label %Mj
+
+Mj:                                               ; preds = %Mj, %Mi
+  %l = phi i64 [ 0, %Mi ], [ %l.next, %Mj ]
+  %ko = add nsw i64 %k, 0
+  %lo = add nsw i64 %l, 1
+  %r = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ko, i64 %lo
+  %x = load double, double* %r, align 8, !llvm.access.group !21
+  %s = getelementptr inbounds [64 x double], [64 x double]* %C, i64 %k, i64 %l
+  store double %x, double* %s, align 8, !llvm.access.group !21
+  %l.next = add nuw nsw i64 %l, 1
+  %cl = icmp eq i64 %l.next, 63
+  br i1 %cl, label %Mi.latch, label %Mj, !llvm.loop !24
+
+Mi.latch:                                         ; preds = %Mj
+  %k.next = add nuw nsw i64 %k, 1
+  %ck = icmp eq i64 %k.next, 63
+  br i1 %ck, label %exit, label %Mi, !llvm.loop !26
+
+exit:                                             ; preds = %Mi.latch
+  ret void
+}
+
+!0 = !{!1, !2}
+!1 = distinct !{}
+!2 = distinct !{}
+!3 = distinct !{!3, !4}
+!4 = !{!"llvm.loop.parallel_accesses", !2}
+!5 = distinct !{!5, !6}
+!6 = !{!"llvm.loop.parallel_accesses", !1}
+!7 = !{!8, !9}
+!8 = distinct !{}
+!9 = distinct !{}
+!10 = distinct !{!10, !11}
+!11 = !{!"llvm.loop.parallel_accesses", !9}
+!12 = distinct !{!12, !13}
+!13 = !{!"llvm.loop.parallel_accesses", !8}
+!14 = !{!15, !16}
+!15 = distinct !{}
+!16 = distinct !{}
+!17 = distinct !{!17, !18}
+!18 = !{!"llvm.loop.parallel_accesses", !16}
+!19 = distinct !{!19, !20}
+!20 = !{!"llvm.loop.parallel_accesses", !15}
+!21 = !{!22, !23}
+!22 = distinct !{}
+!23 = distinct !{}
+!24 = distinct !{!24, !25}
+!25 = !{!"llvm.loop.parallel_accesses", !23}
+!26 = distinct !{!26, !27}
+!27 = !{!"llvm.loop.parallel_accesses", !22}
@@ -0,0 +1,118 @@
+; ModuleID = '07UnrollJam.ll'
+source_filename = "07UnrollJam.ll"
+
+declare void @touch(double*)
+
+define void @perfect([64 x double]* %A, [64 x double]* %B) {
+entry:
+  br label %Li
+
+Li:                                               ; preds = %Li.latch, %entry
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  %ip1 = add nuw nsw i64 %i, 1
+  br label %Lj
+
+Lj:                                               ; preds = %Lj, %Li
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p0 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v0 = load double, double* %p0, align 8, !llvm.access.group !0
+  %p1 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ip1, i64 %j
+  %v1 = load double, double* %p1, align 8, !llvm.access.group !0
+  %s = fadd double %v0, %v1
+  %q = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  store double %s, double* %q, align 8, !llvm.access.group !0
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj, !llvm.loop !3
+
+Li.latch:                                         ; preds = %Lj
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 32
+  br i1 %ci, label %exit, label %Li, !llvm.loop !6
+
+exit:                                             ; preds = %Li.latch
+  ret void
+}
+
+define void @imperfect([64 x double]* %A, [64 x double]* %B, double* %C) {
+entry:
+  br label %Li
+
+Li:                                               ; preds = %Li.latch, %entry
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  %ip1 = add nuw nsw i64 %i, 1
+  %c = getelementptr inbounds double, double* %C, i64 %i
+  store double 0.000000e+00, double* %c, align 8, !llvm.access.group !9
+  br label %Lj
+
+Lj:                                               ; preds = %Lj, %Li
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p0 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v0 = load double, double* %p0, align 8, !llvm.access.group !10
+  %p1 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ip1, i64 %j
+  %v1 = load double, double* %p1, align 8, !llvm.access.group !10
+  %s = fadd double %v0, %v1
+  %q = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  store double %s, double* %q, align 8, !llvm.access.group !10
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj, !llvm.loop !12
+
+Li.latch:                                         ; preds = %Lj
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 32
+  br i1 %ci, label %exit, label %Li, !llvm.loop !14
+
+exit:                                             ; preds = %Li.latch
+  ret void
+}
+
+define void @call([64 x double]* %A, [64 x double]* %B) {
+entry:
+  br label %Li
+
+Li:                                               ; preds = %Li.latch, %entry
+  %i = phi i64 [ 0, %entry ], [ %i.next, %Li.latch ]
+  %ip1 = add nuw nsw i64 %i, 1
+  br label %Lj
+
+Lj:                                               ; preds = %Lj, %Li
+  %j = phi i64 [ 0, %Li ], [ %j.next, %Lj ]
+  %p0 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %i, i64 %j
+  %v0 = load double, double* %p0, align 8
+  %p1 = getelementptr inbounds [64 x double], [64 x double]* %A, i64 %ip1, i64 %j
+  %v1 = load double, double* %p1, align 8
+  %s = fadd double %v0, %v1
+  %q = getelementptr inbounds [64 x double], [64 x double]* %B, i64 %i, i64 %j
+  store double %s, double* %q, align 8
+  call void @touch(double* %q)
+  %j.next = add nuw nsw i64 %j, 1
+  %cj = icmp eq i64 %j.next, 64
+  br i1 %cj, label %Li.latch, label %Lj, !llvm.loop !16
+
+Li.latch:                                         ; preds = %Lj
+  %i.next = add nuw nsw i64 %i, 1
+  %ci = icmp eq i64 %i.next, 32
+  br i1 %ci, label %exit, label %Li
+
+exit:                                             ; preds = %Li.latch
+  ret void
+}
+
+!0 = !{!1, !2}
+!1 = distinct !{}
+!2 = distinct !{}
+!3 = distinct !{!3, !4, !5}
+!4 = !{!"llvm.loop.unroll.count", i32 8}
+!5 = !{!"llvm.loop.parallel_accesses", !2}
+!6 = distinct !{!6, !7, !8}
+!7 = !{!"llvm.loop.unroll_and_jam.count", i32 4}
+!8 = !{!"llvm.loop.parallel_accesses", !1}
+!9 = distinct !{}
+!10 = !{!9, !11}
+!11 = distinct !{}
+!12 = distinct !{!12, !4, !13}
+!13 = !{!"llvm.loop.parallel_accesses", !11}
+!14 = distinct !{!14, !15}
+!15 = !{!"llvm.loop.parallel_accesses", !9}
+!16 = distinct !{!16, !4}
@@ -1,8 +1,16 @@
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <fcntl.h>
 #include <map>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
 
 #include "graph.h"
 #include "utils.h"
@@ -104,68 +112,245 @@ type::edge_t Graph::AddEdge(const type::vertex_t src_vertex_id,
 }
 
 type::vertex_t Graph::AddGraph(Graph *g) {
-  // dbg(g->GetCurVertexNum());
-  g->DeleteExtraTailVertices();
-  // dbg(g->GetCurVertexNum());
-
-  std::map<type::vertex_t, type::vertex_t> old_vertex_id_2_new_vertex_id;
-
-  // Step over all vertices
-  igraph_vs_t vs;
-  igraph_vit_t vit;
-
-  igraph_vs_all(&vs);
-  igraph_vit_create(&g->ipag_->graph, vs, &vit);
-  while (!IGRAPH_VIT_END(vit)) {
-    // Get vector id
-    type::vertex_t vertex_id = (type::vertex_t)IGRAPH_VIT_GET(vit);
-    // printf("vertex %d", vertex_id);
-
-    // Add new vertex (the copy of that in the input g) into this pag
-    type::vertex_t new_vertex_id = this->AddVertex();
-
-    old_vertex_id_2_new_vertex_id[vertex_id] = new_vertex_id;
-
-    // copy all attributes of this vertex
-    this->CopyVertex(new_vertex_id, g, vertex_id);
+  std::vector<Graph *> graphs(1, g);
+  std::vector<type::vertex_t> entry_vertex_ids;
+  this->AddGraphs(graphs, entry_vertex_ids);
+  return entry_vertex_ids[0];
+}
 
-    IGRAPH_VIT_NEXT(vit);
+/** Copy the attribute columns of a list of source graphs into a contiguous
+ * range of vertices (or edges) of graph. Every column is read and written
+ * once, regardless of the number of source graphs.
+ */
+static void CopyAttributeColumns(igraph_t *graph,
+                                 const std::vector<const igraph_t *> &srcs,
+                                 const std::vector<igraph_integer_t> &offsets,
+                                 const std::vector<igraph_integer_t> &nums,
+                                 igraph_attribute_elemtype_t elemtype) {
+  bool is_vertex = (elemtype == IGRAPH_ATTRIBUTE_VERTEX);
+
+  // Collect the union of attribute names (with type) of all source graphs
+  std::map<std::string, int> attr_types;
+  for (auto src : srcs) {
+    igraph_vector_t types;
+    igraph_strvector_t names;
+    igraph_vector_init(&types, 0);
+    igraph_strvector_init(&names, 0);
+    if (is_vertex) {
+      igraph_cattribute_list(src, nullptr, nullptr, &names, &types, nullptr,
+                             nullptr);
+    } else {
+      igraph_cattribute_list(src, nullptr, nullptr, nullptr, nullptr, &names,
+                             &types);
+    }
+    for (long int i = 0; i < igraph_strvector_size(&names); i++) {
+      attr_types.insert(std::make_pair(std::string(STR(names, i)),
+                                       (int)VECTOR(types)[i]));
+    }
+    igraph_vector_destroy(&types);
+    igraph_strvector_destroy(&names);
   }
-  // printf("\n");
-
-  igraph_vit_destroy(&vit);
-  igraph_vs_destroy(&vs);
-
-  // Step over all edges
-  igraph_es_t es;
-  igraph_eit_t eit;
-
-  igraph_es_all(&es, IGRAPH_EDGEORDER_ID);
-  igraph_eit_create(&g->ipag_->graph, es, &eit);
-
-  while (!IGRAPH_EIT_END(eit)) {
-    // Get edge id
-    type::edge_t edge_id = (type::edge_t)IGRAPH_EIT_GET(eit);
-    // printf("edge %d", edge_id);
 
-    // Add new edge (the copy of that in the input g) into this pag
-    // type::edge_t new_edge_id =
-    this->AddEdge(old_vertex_id_2_new_vertex_id[g->GetEdgeSrc(edge_id)],
-                  old_vertex_id_2_new_vertex_id[g->GetEdgeDest(edge_id)]);
-
-    // copy all attributes of this vertex
-    // this->CopyVertex(new_vertex_id, g, vertex_id);
+  for (auto &attr : attr_types) {
+    const char *name = attr.first.c_str();
+    int type = attr.second;
+
+    // Find the first source that owns this column, it is used to create the
+    // column in graph if it does not exist yet
+    size_t first = 0;
+    while (first < srcs.size() &&
+           (nums[first] == 0 ||
+            !igraph_cattribute_has_attr(srcs[first], elemtype, name))) {
+      first++;
+    }
+    if (first == srcs.size()) {
+      continue;
+    }
 
-    IGRAPH_EIT_NEXT(eit);
+    if (type == IGRAPH_ATTRIBUTE_NUMERIC) {
+      if (!igraph_cattribute_has_attr(graph, elemtype, name)) {
+        if (is_vertex) {
+          SETVAN(graph, name, offsets[first], 0);
+        } else {
+          SETEAN(graph, name, offsets[first], 0);
+        }
+      }
+      igraph_vector_t col, src_col;
+      igraph_vector_init(&col, 0);
+      igraph_vector_init(&src_col, 0);
+      if (is_vertex) {
+        igraph_cattribute_VANV(graph, name, igraph_vss_all(), &col);
+      } else {
+        igraph_cattribute_EANV(graph, name,
+                               igraph_ess_all(IGRAPH_EDGEORDER_ID), &col);
+      }
+      for (size_t s = 0; s < srcs.size(); s++) {
+        if (nums[s] == 0 ||
+            !igraph_cattribute_has_attr(srcs[s], elemtype, name)) {
+          continue;
+        }
+        if (is_vertex) {
+          igraph_cattribute_VANV(srcs[s], name,
+                                 igraph_vss_seq(0, nums[s] - 1), &src_col);
+        } else {
+          igraph_cattribute_EANV(srcs[s], name,
+                                 igraph_ess_seq(0, nums[s] - 1), &src_col);
+        }
+        memcpy(&VECTOR(col)[offsets[s]], &VECTOR(src_col)[0],
+               sizeof(igraph_real_t) * nums[s]);
+      }
+      // "id" always equals the new vertex id, same as CopyVertex
+      if (is_vertex && strcmp(name, "id") == 0) {
+        for (size_t s = 0; s < srcs.size(); s++) {
+          for (igraph_integer_t i = 0; i < nums[s]; i++) {
+            VECTOR(col)[offsets[s] + i] = offsets[s] + i;
+          }
+        }
+      }
+      if (is_vertex) {
+        igraph_cattribute_VAN_setv(graph, name, &col);
+      } else {
+        igraph_cattribute_EAN_setv(graph, name, &col);
+      }
+      igraph_vector_destroy(&col);
+      igraph_vector_destroy(&src_col);
+    } else if (type == IGRAPH_ATTRIBUTE_BOOLEAN) {
+      if (!igraph_cattribute_has_attr(graph, elemtype, name)) {
+        if (is_vertex) {
+          SETVAB(graph, name, offsets[first], false);
+        } else {
+          SETEAB(graph, name, offsets[first], false);
+        }
+      }
+      igraph_vector_bool_t col, src_col;
+      igraph_vector_bool_init(&col, 0);
+      igraph_vector_bool_init(&src_col, 0);
+      if (is_vertex) {
+        igraph_cattribute_VABV(graph, name, igraph_vss_all(), &col);
+      } else {
+        igraph_cattribute_EABV(graph, name,
+                               igraph_ess_all(IGRAPH_EDGEORDER_ID), &col);
+      }
+      for (size_t s = 0; s < srcs.size(); s++) {
+        if (nums[s] == 0 ||
+            !igraph_cattribute_has_attr(srcs[s], elemtype, name)) {
+          continue;
+        }
+        if (is_vertex) {
+          igraph_cattribute_VABV(srcs[s], name,
+                                 igraph_vss_seq(0, nums[s] - 1), &src_col);
+        } else {
+          igraph_cattribute_EABV(srcs[s], name,
+                                 igraph_ess_seq(0, nums[s] - 1), &src_col);
+        }
+        memcpy(&VECTOR(col)[offsets[s]], &VECTOR(src_col)[0],
+               sizeof(igraph_bool_t) * nums[s]);
+      }
+      if (is_vertex) {
+        igraph_cattribute_VAB_setv(graph, name, &col);
+      } else {
+        igraph_cattribute_EAB_setv(graph, name, &col);
+      }
+      igraph_vector_bool_destroy(&col);
+      igraph_vector_bool_destroy(&src_col);
+    } else {
+      if (!igraph_cattribute_has_attr(graph, elemtype, name)) {
+        if (is_vertex) {
+          SETVAS(graph, name, offsets[first], "");
+        } else {
+          SETEAS(graph, name, offsets[first], "");
+        }
+      }
+      igraph_strvector_t col, src_col;
+      igraph_strvector_init(&col, 0);
+      igraph_strvector_init(&src_col, 0);
+      if (is_vertex) {
+        igraph_cattribute_VASV(graph, name, igraph_vss_all(), &col);
+      } else {
+        igraph_cattribute_EASV(graph, name,
+                               igraph_ess_all(IGRAPH_EDGEORDER_ID), &col);
+      }
+      for (size_t s = 0; s < srcs.size(); s++) {
+        if (nums[s] == 0 ||
+            !igraph_cattribute_has_attr(srcs[s], elemtype, name)) {
+          continue;
+        }
+        if (is_vertex) {
+          igraph_cattribute_VASV(srcs[s], name,
+                                 igraph_vss_seq(0, nums[s] - 1), &src_col);
+        } else {
+          igraph_cattribute_EASV(srcs[s], name,
+                                 igraph_ess_seq(0, nums[s] - 1), &src_col);
+        }
+        for (igraph_integer_t i = 0; i < nums[s]; i++) {
+          igraph_strvector_set(&col, offsets[s] + i, STR(src_col, i));
+        }
+      }
+      if (is_vertex) {
+        igraph_cattribute_VAS_setv(graph, name, &col);
+      } else {
+        igraph_cattribute_EAS_setv(graph, name, &col);
+      }
+      igraph_strvector_destroy(&col);
+      igraph_strvector_destroy(&src_col);
+    }
   }
-  // printf("\n");
+}
 
-  igraph_eit_destroy(&eit);
-  igraph_es_destroy(&es);
+void Graph::AddGraphs(std::vector<Graph *> &graphs,
+                      std::vector<type::vertex_t> &entry_vertex_ids) {
+  igraph_t *graph = &ipag_->graph;
+
+  std::vector<const igraph_t *> srcs;
+  std::vector<igraph_integer_t> vertex_offsets, vertex_nums;
+  std::vector<igraph_integer_t> edge_offsets, edge_nums;
+
+  // Lay out all appended graphs one after another. Pre-allocated tail
+  // vertices of the source graphs are never touched by edges, so only the
+  // first GetCurVertexNum() vertices of each source are taken.
+  igraph_integer_t vertex_offset = this->cur_vertex_num;
+  igraph_integer_t edge_offset = igraph_ecount(graph);
+  for (auto g : graphs) {
+    srcs.push_back(&g->ipag_->graph);
+    vertex_offsets.push_back(vertex_offset);
+    vertex_nums.push_back(g->GetCurVertexNum());
+    edge_offsets.push_back(edge_offset);
+    edge_nums.push_back(igraph_ecount(&g->ipag_->graph));
+    entry_vertex_ids.push_back((type::vertex_t)vertex_offset);
+    vertex_offset += g->GetCurVertexNum();
+    edge_offset += igraph_ecount(&g->ipag_->graph);
+  }
 
-  type::vertex_t ret_vertex_id = old_vertex_id_2_new_vertex_id[0];
-  FREE_CONTAINER(old_vertex_id_2_new_vertex_id);
-  return ret_vertex_id;
+  // Add all new vertices at once, reusing pre-allocated tail vertices
+  if (vertex_offset > igraph_vcount(graph)) {
+    igraph_add_vertices(graph, vertex_offset - igraph_vcount(graph), 0);
+  }
+  this->cur_vertex_num = vertex_offset;
+
+  // Remap vertex ids of all edges in one pass over the edge arrays, and add
+  // them with a single igraph call (igraph_add_edge rebuilds the edge index
+  // on every call)
+  igraph_vector_t all_edges, src_edges;
+  igraph_vector_init(&all_edges, 0);
+  igraph_vector_init(&src_edges, 0);
+  igraph_vector_reserve(&all_edges, 2 * (edge_offset - igraph_ecount(graph)));
+  for (size_t s = 0; s < srcs.size(); s++) {
+    igraph_get_edgelist(srcs[s], &src_edges, 0);
+    long int num = igraph_vector_size(&src_edges);
+    for (long int i = 0; i < num; i++) {
+      igraph_vector_push_back(&all_edges,
+                              VECTOR(src_edges)[i] + vertex_offsets[s]);
+    }
+  }
+  igraph_add_edges(graph, &all_edges, 0);
+  igraph_vector_destroy(&src_edges);
+  igraph_vector_destroy(&all_edges);
+
+  // Copy attributes column by column
+  CopyAttributeColumns(graph, srcs, vertex_offsets, vertex_nums,
+                       IGRAPH_ATTRIBUTE_VERTEX);
+  CopyAttributeColumns(graph, srcs, edge_offsets, edge_nums,
+                       IGRAPH_ATTRIBUTE_EDGE);
 }
 
 void Graph::DeleteVertex(type::vertex_t vertex_id) {
@@ -408,25 +593,59 @@ void Graph::DeleteVertices(type::vertex_set_t *vs) {
   igraph_delete_vertices(&ipag_->graph, vs->vertices);
 }
 
+void Graph::DeleteVertices(const std::vector<type::vertex_t> &vertex_ids,
+                           std::vector<type::vertex_t> *old_2_new_vertex_id) {
+  igraph_integer_t vertex_num = igraph_vcount(&ipag_->graph);
+
+  // Mark deleted vertices (duplicated ids are allowed)
+  std::vector<bool> deleted(vertex_num, false);
+  igraph_vector_t del_vec;
+  igraph_vector_init(&del_vec, 0);
+  igraph_vector_reserve(&del_vec, vertex_ids.size());
+  int num_deleted_in_use = 0;
+  for (auto vertex_id : vertex_ids) {
+    if (vertex_id < 0 || vertex_id >= vertex_num || deleted[vertex_id]) {
+      continue;
+    }
+    deleted[vertex_id] = true;
+    igraph_vector_push_back(&del_vec, vertex_id);
+    if (vertex_id < this->cur_vertex_num) {
+      num_deleted_in_use++;
+    }
+  }
+
+  // igraph compacts the vertex array and rewrites edge endpoints in one pass;
+  // the relative order of remaining vertices is kept
+  igraph_delete_vertices(&ipag_->graph, igraph_vss_vector(&del_vec));
+  igraph_vector_destroy(&del_vec);
+  this->cur_vertex_num -= num_deleted_in_use;
+
+  if (old_2_new_vertex_id) {
+    old_2_new_vertex_id->resize(vertex_num);
+    type::vertex_t new_vertex_id = 0;
+    for (igraph_integer_t i = 0; i < vertex_num; i++) {
+      (*old_2_new_vertex_id)[i] = deleted[i] ? -1 : new_vertex_id++;
+    }
+  }
+}
+
 void Graph::DeleteExtraTailVertices() {
   // unnecessary to delete
-  // dbg(this->GetGraphAttributeString("name"), this->cur_vertex_num,
-  // igraph_vcount(&ipag_->graph));
-  if (this->GetCurVertexNum() - 1 == igraph_vcount(&ipag_->graph)) {
+  if (this->GetCurVertexNum() == igraph_vcount(&ipag_->graph)) {
     return;
-  } else if (this->GetCurVertexNum() - 1 > igraph_vcount(&ipag_->graph)) {
+  } else if (this->GetCurVertexNum() > igraph_vcount(&ipag_->graph)) {
     dbg("Error: The number of vertices is larger than pre-allocated gragh "
         "size");
     return;
   }
 
-  // Check the number of vertices
-  type::vertex_set_t vs;
-
-  igraph_vs_seq(&vs.vertices, this->cur_vertex_num,
-                igraph_vcount(&ipag_->graph) - 1);
-  this->DeleteVertices(&vs);
-  igraph_vs_destroy(&vs.vertices);
+  // Delete all pre-allocated but unused vertices at once
+  std::vector<type::vertex_t> tail_vertex_ids;
+  for (type::vertex_t i = this->cur_vertex_num;
+       i < igraph_vcount(&ipag_->graph); i++) {
+    tail_vertex_ids.push_back(i);
+  }
+  this->DeleteVertices(tail_vertex_ids, nullptr);
 }
 
 void Graph::Dfs() { UNIMPLEMENTED(); }
@@ -440,12 +659,725 @@ void Graph::Dfs() { UNIMPLEMENTED(); }
 //                /*extra=*/ 0);
 // }
 
+/* ---------- Memory-mapped GML / DOT reader ---------- */
+
+namespace {
+
+enum token_kind_t {
+  TOK_END = 0,
+  TOK_WORD,
+  TOK_NUM,
+  TOK_STR,
+  TOK_LBRACKET,
+  TOK_RBRACKET,
+  TOK_LBRACE,
+  TOK_RBRACE,
+  TOK_EQ,
+  TOK_SEMI,
+  TOK_COMMA,
+  TOK_ARROW,
+  TOK_OTHER
+};
+
+/** A token is a view into the mapped file, nothing is copied */
+struct token_t {
+  token_kind_t kind;
+  const char *str;
+  int len;
+};
+
+inline bool TokenIs(const token_t &tok, const char *word) {
+  return (int)strlen(word) == tok.len && strncmp(tok.str, word, tok.len) == 0;
+}
+
+inline bool IsWordChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+class Tokenizer {
+private:
+  const char *cur_;
+  const char *end_;
+
+public:
+  Tokenizer(const char *begin, const char *end) : cur_(begin), end_(end) {}
+
+  token_t Next() {
+    // Skip spaces and comments ("#" for GML, "//" and "/* */" for DOT)
+    while (cur_ < end_) {
+      char c = *cur_;
+      if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        cur_++;
+      } else if (c == '#' ||
+                 (c == '/' && cur_ + 1 < end_ && cur_[1] == '/')) {
+        while (cur_ < end_ && *cur_ != '\n') {
+          cur_++;
+        }
+      } else if (c == '/' && cur_ + 1 < end_ && cur_[1] == '*') {
+        cur_ += 2;
+        while (cur_ + 1 < end_ && !(cur_[0] == '*' && cur_[1] == '/')) {
+          cur_++;
+        }
+        cur_ += 2;
+      } else {
+        break;
+      }
+    }
+    if (cur_ >= end_) {
+      return token_t{TOK_END, end_, 0};
+    }
+
+    const char *start = cur_;
+    char c = *cur_;
+    if (c == '"') {
+      cur_++;
+      while (cur_ < end_ && *cur_ != '"') {
+        if (*cur_ == '\\' && cur_ + 1 < end_) {
+          cur_++;
+        }
+        cur_++;
+      }
+      cur_++;
+      return token_t{TOK_STR, start + 1, (int)(cur_ - start - 2)};
+    }
+    if (c == '-' && cur_ + 1 < end_ && (cur_[1] == '>' || cur_[1] == '-')) {
+      cur_ += 2;
+      return token_t{TOK_ARROW, start, 2};
+    }
+    if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.') {
+      cur_++;
+      while (cur_ < end_ && (IsWordChar(*cur_) ||
+                             ((*cur_ == '-' || *cur_ == '+') &&
+                              (cur_[-1] == 'e' || cur_[-1] == 'E')))) {
+        cur_++;
+      }
+      return token_t{TOK_NUM, start, (int)(cur_ - start)};
+    }
+    if (IsWordChar(c)) {
+      while (cur_ < end_ && IsWordChar(*cur_)) {
+        cur_++;
+      }
+      return token_t{TOK_WORD, start, (int)(cur_ - start)};
+    }
+    cur_++;
+    switch (c) {
+    case '[':
+      return token_t{TOK_LBRACKET, start, 1};
+    case ']':
+      return token_t{TOK_RBRACKET, start, 1};
+    case '{':
+      return token_t{TOK_LBRACE, start, 1};
+    case '}':
+      return token_t{TOK_RBRACE, start, 1};
+    case '=':
+      return token_t{TOK_EQ, start, 1};
+    case ';':
+      return token_t{TOK_SEMI, start, 1};
+    case ',':
+      return token_t{TOK_COMMA, start, 1};
+    default:
+      return token_t{TOK_OTHER, start, 1};
+    }
+  }
+};
+
+/** Parse a numeric token. The mapped file is not NUL-terminated and may end
+ * right after the token, so the token is copied before strtod reads it. */
+inline double TokenToNum(const token_t &tok) {
+  if (TokenIs(tok, "NaN") || TokenIs(tok, "nan")) {
+    return NAN;
+  } else if (TokenIs(tok, "Inf") || TokenIs(tok, "inf")) {
+    return INFINITY;
+  } else if (TokenIs(tok, "-Inf") || TokenIs(tok, "-inf")) {
+    return -INFINITY;
+  }
+  char buf[64];
+  if (tok.len < (int)sizeof(buf)) {
+    memcpy(buf, tok.str, tok.len);
+    buf[tok.len] = '\0';
+    return strtod(buf, nullptr);
+  }
+  return strtod(std::string(tok.str, tok.len).c_str(), nullptr);
+}
+
+inline bool TokenIsNum(const token_t &tok) {
+  return tok.kind == TOK_NUM || TokenIs(tok, "NaN") || TokenIs(tok, "nan") ||
+         TokenIs(tok, "Inf") || TokenIs(tok, "inf");
+}
+
+enum attr_cell_kind_t { CELL_ABSENT = 0, CELL_NUM = 1, CELL_STR = 2 };
+
+struct attr_cell_t {
+  double num;
+  const char *str;
+  int len;
+  int kind;
+};
+
+struct attr_column_t {
+  const char *name;
+  int name_len;
+  bool is_string;
+  std::vector<attr_cell_t> cells; /**<one cell per element, by local id */
+};
+
+/** Attribute columns of vertices, edges or the graph. The number of distinct
+ * attribute names is small, so a linear lookup is used. */
+struct attr_table_t {
+  std::vector<attr_column_t> cols;
+
+  attr_column_t &GetColumn(const char *name, int name_len) {
+    for (auto &col : cols) {
+      if (col.name_len == name_len && strncmp(col.name, name, name_len) == 0) {
+        return col;
+      }
+    }
+    cols.push_back(attr_column_t{name, name_len, false, {}});
+    return cols.back();
+  }
+
+  void Set(long int elem, const token_t &key, const token_t &value) {
+    attr_column_t &col = GetColumn(key.str, key.len);
+    if ((long int)col.cells.size() <= elem) {
+      col.cells.resize(elem + 1, attr_cell_t{0, nullptr, 0, CELL_ABSENT});
+    }
+    attr_cell_t &cell = col.cells[elem];
+    cell.str = value.str;
+    cell.len = value.len;
+    if (value.kind != TOK_STR && TokenIsNum(value)) {
+      cell.kind = CELL_NUM;
+      cell.num = TokenToNum(value);
+    } else {
+      cell.kind = CELL_STR;
+      col.is_string = true;
+    }
+  }
+};
+
+/** Result of parsing one piece of the input */
+struct graph_chunk_t {
+  std::vector<long int> vertex_ids; /**<file id of each vertex, in order */
+  std::vector<long int> edges;      /**<file ids of edge endpoints, in pairs */
+  attr_table_t vattrs;
+  attr_table_t eattrs;
+  attr_table_t gattrs;
+  bool directed = true; /**<GML pieces start undirected, DOT ones directed */
+  bool ok = true;
+};
+
+/** Skip a (possibly nested) GML list, the opening "[" is consumed */
+void SkipGMLList(Tokenizer &tz) {
+  int depth = 1;
+  while (depth > 0) {
+    token_t tok = tz.Next();
+    if (tok.kind == TOK_END) {
+      return;
+    } else if (tok.kind == TOK_LBRACKET) {
+      depth++;
+    } else if (tok.kind == TOK_RBRACKET) {
+      depth--;
+    }
+  }
+}
+
+/** Parse a piece of a GML file. The first piece starts at the beginning of
+ * the file, others start at a "node" or "edge" key inside the graph list. */
+void ParseGMLChunk(const char *begin, const char *end, bool is_first,
+                   graph_chunk_t *chunk) {
+  Tokenizer tz(begin, end);
+  bool in_graph = !is_first;
+  // A GML graph is undirected unless it has "directed 1"
+  chunk->directed = false;
+
+  while (true) {
+    token_t key = tz.Next();
+    if (key.kind == TOK_END) {
+      return;
+    }
+    if (key.kind == TOK_RBRACKET) {
+      // end of the graph list
+      in_graph = false;
+      continue;
+    }
+    if (key.kind != TOK_WORD) {
+      chunk->ok = false;
+      return;
+    }
+    token_t value = tz.Next();
+
+    if (!in_graph) {
+      // "Creator", "Version", ... before the graph
+      if (TokenIs(key, "graph") && value.kind == TOK_LBRACKET) {
+        in_graph = true;
+      } else if (value.kind == TOK_LBRACKET) {
+        SkipGMLList(tz);
+      }
+      continue;
+    }
+
+    if ((TokenIs(key, "node") || TokenIs(key, "edge")) &&
+        value.kind == TOK_LBRACKET) {
+      bool is_node = TokenIs(key, "node");
+      long int elem = is_node ? (long int)chunk->vertex_ids.size()
+                              : (long int)chunk->edges.size() / 2;
+      long int id = -1, source = -1, target = -1;
+      while (true) {
+        token_t k = tz.Next();
+        if (k.kind == TOK_RBRACKET || k.kind == TOK_END) {
+          break;
+        }
+        token_t v = tz.Next();
+        if (v.kind == TOK_LBRACKET) {
+          SkipGMLList(tz);
+          continue;
+        }
+        if (is_node) {
+          if (TokenIs(k, "id")) {
+            id = (long int)TokenToNum(v);
+          }
+          // "id" is kept as an attribute, as igraph does
+          chunk->vattrs.Set(elem, k, v);
+        } else if (TokenIs(k, "source")) {
+          source = (long int)TokenToNum(v);
+        } else if (TokenIs(k, "target")) {
+          target = (long int)TokenToNum(v);
+        } else {
+          chunk->eattrs.Set(elem, k, v);
+        }
+      }
+      if (is_node) {
+        if (id < 0) {
+          chunk->ok = false;
+          return;
+        }
+        chunk->vertex_ids.push_back(id);
+      } else {
+        if (source < 0 || target < 0) {
+          chunk->ok = false;
+          return;
+        }
+        chunk->edges.push_back(source);
+        chunk->edges.push_back(target);
+      }
+    } else if (TokenIs(key, "directed")) {
+      chunk->directed = (TokenToNum(value) != 0);
+    } else if (value.kind == TOK_LBRACKET) {
+      SkipGMLList(tz);
+    } else {
+      chunk->gattrs.Set(0, key, value);
+    }
+  }
+}
+
+/** Parse an attribute list "[ k=v k=v ... ]" of DOT, the "[" is consumed */
+void ParseDotAttrList(Tokenizer &tz, attr_table_t *attrs, long int elem) {
+  while (true) {
+    token_t k = tz.Next();
+    if (k.kind == TOK_RBRACKET || k.kind == TOK_END) {
+      return;
+    }
+    if (k.kind == TOK_COMMA || k.kind == TOK_SEMI) {
+      continue;
+    }
+    token_t eq = tz.Next();
+    if (eq.kind != TOK_EQ) {
+      continue;
+    }
+    token_t v = tz.Next();
+    if (attrs) {
+      attrs->Set(elem, k, v);
+    }
+  }
+}
+
+/** Parse a piece of a DOT file as written by DumpGraphDot: numeric vertex
+ * ids, "a -> b" edges and "[ k=v ]" attribute lists. The first piece starts
+ * at the beginning of the file, others start at a statement inside the graph
+ * body. */
+void ParseDotChunk(const char *begin, const char *end, bool is_first,
+                   graph_chunk_t *chunk) {
+  Tokenizer tz(begin, end);
+  bool in_body = !is_first;
+  token_t tok = tz.Next();
+
+  while (tok.kind != TOK_END) {
+    if (!in_body) {
+      if (TokenIs(tok, "graph")) {
+        chunk->directed = false;
+      } else if (tok.kind == TOK_LBRACE) {
+        in_body = true;
+      }
+      tok = tz.Next();
+      continue;
+    }
+
+    if (tok.kind == TOK_RBRACE) {
+      return;
+    } else if (tok.kind == TOK_SEMI) {
+      tok = tz.Next();
+      continue;
+    } else if (tok.kind == TOK_WORD &&
+               (TokenIs(tok, "graph") || TokenIs(tok, "node") ||
+                TokenIs(tok, "edge"))) {
+      // Graph attributes, or default node / edge attributes (ignored)
+      bool is_graph = TokenIs(tok, "graph");
+      tok = tz.Next();
+      if (tok.kind == TOK_LBRACKET) {
+        ParseDotAttrList(tz, is_graph ? &chunk->gattrs : nullptr, 0);
+        tok = tz.Next();
+      }
+      continue;
+    } else if (tok.kind != TOK_NUM) {
+      // Only the subset with numeric vertex ids is supported
+      chunk->ok = false;
+      return;
+    }
+
+    long int src = (long int)TokenToNum(tok);
+    tok = tz.Next();
+    if (tok.kind == TOK_ARROW) {
+      token_t dest_tok = tz.Next();
+      if (dest_tok.kind != TOK_NUM) {
+        chunk->ok = false;
+        return;
+      }
+      long int elem = (long int)chunk->edges.size() / 2;
+      chunk->edges.push_back(src);
+      chunk->edges.push_back((long int)TokenToNum(dest_tok));
+      tok = tz.Next();
+      if (tok.kind == TOK_LBRACKET) {
+        ParseDotAttrList(tz, &chunk->eattrs, elem);
+        tok = tz.Next();
+      }
+    } else {
+      long int elem = (long int)chunk->vertex_ids.size();
+      chunk->vertex_ids.push_back(src);
+      if (tok.kind == TOK_LBRACKET) {
+        ParseDotAttrList(tz, &chunk->vattrs, elem);
+        tok = tz.Next();
+      }
+    }
+  }
+}
+
+/** Whether the line starting at line begins a top-level element: "node" /
+ * "edge" for GML, a numeric vertex id for DOT */
+inline bool IsElementLine(const char *line, const char *end, bool is_dot) {
+  const char *p = line;
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  if (is_dot) {
+    return p < end && *p >= '0' && *p <= '9';
+  }
+  return end - p > 5 &&
+         (strncmp(p, "node", 4) == 0 || strncmp(p, "edge", 4) == 0) &&
+         (p[4] == ' ' || p[4] == '\t' || p[4] == '\n' || p[4] == '[');
+}
+
+/** Find the start of the next line at or after pos that begins a top-level
+ * element. The scan starts at from, which must be outside any string or
+ * comment, and skips them as Tokenizer does, so that a line inside a
+ * multi-line string is never taken for an element. */
+const char *FindSplitPoint(const char *from, const char *pos, const char *end,
+                           bool is_dot) {
+  const char *p = from;
+  while (p < end) {
+    char c = *p;
+    if (c == '"') {
+      p++;
+      while (p < end && *p != '"') {
+        p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+      }
+      p++;
+    } else if (c == '#' || (c == '/' && p + 1 < end && p[1] == '/')) {
+      p = (const char *)memchr(p, '\n', end - p);
+      if (!p) {
+        return end;
+      }
+    } else if (c == '/' && p + 1 < end && p[1] == '*') {
+      p += 2;
+      while (p + 1 < end && !(p[0] == '*' && p[1] == '/')) {
+        p++;
+      }
+      p += 2;
+    } else if (c == '\n') {
+      p++;
+      if (p >= pos && IsElementLine(p, end, is_dot)) {
+        return p;
+      }
+    } else {
+      p++;
+    }
+  }
+  return end;
+}
+
+/** Decode a string value: GML entities (&quot; ...) and DOT escapes (\") */
+void DecodeString(const attr_cell_t &cell, bool is_dot, std::string &out) {
+  out.clear();
+  if (cell.kind == CELL_NUM) {
+    out.append(cell.str, cell.len);
+    return;
+  }
+  for (int i = 0; i < cell.len; i++) {
+    char c = cell.str[i];
+    if (is_dot && c == '\\' && i + 1 < cell.len) {
+      out.push_back(cell.str[++i]);
+    } else if (!is_dot && c == '&') {
+      static const char *entities[][2] = {{"&quot;", "\""}, {"&amp;", "&"},
+                                          {"&lt;", "<"},    {"&gt;", ">"},
+                                          {"&apos;", "'"}};
+      bool matched = false;
+      for (auto &entity : entities) {
+        int len = strlen(entity[0]);
+        if (i + len <= cell.len && strncmp(cell.str + i, entity[0], len) == 0) {
+          out.append(entity[1]);
+          i += len - 1;
+          matched = true;
+          break;
+        }
+      }
+      if (!matched) {
+        out.push_back(c);
+      }
+    } else {
+      out.push_back(c);
+    }
+  }
+}
+
+/** Stitch the attribute columns of all chunks into igraph columns */
+void SetAttributeColumns(igraph_t *graph, std::vector<graph_chunk_t> &chunks,
+                         attr_table_t graph_chunk_t::*table,
+                         const std::vector<long int> &offsets, long int total,
+                         igraph_attribute_elemtype_t elemtype, bool is_dot) {
+  // Merge column names (and types) over all chunks, in order of appearance
+  attr_table_t merged;
+  for (auto &chunk : chunks) {
+    for (auto &col : (chunk.*table).cols) {
+      attr_column_t &merged_col = merged.GetColumn(col.name, col.name_len);
+      merged_col.is_string |= col.is_string;
+    }
+  }
+
+  std::string name, decoded;
+  for (auto &merged_col : merged.cols) {
+    name.assign(merged_col.name, merged_col.name_len);
+    if (!merged_col.is_string) {
+      igraph_vector_t col;
+      igraph_vector_init(&col, total);
+      for (long int i = 0; i < total; i++) {
+        VECTOR(col)[i] = NAN;
+      }
+      for (size_t c = 0; c < chunks.size(); c++) {
+        attr_column_t &chunk_col = (chunks[c].*table).GetColumn(
+            merged_col.name, merged_col.name_len);
+        for (size_t i = 0; i < chunk_col.cells.size(); i++) {
+          if (chunk_col.cells[i].kind == CELL_NUM) {
+            VECTOR(col)[offsets[c] + i] = chunk_col.cells[i].num;
+          }
+        }
+      }
+      if (elemtype == IGRAPH_ATTRIBUTE_VERTEX) {
+        igraph_cattribute_VAN_setv(graph, name.c_str(), &col);
+      } else if (elemtype == IGRAPH_ATTRIBUTE_EDGE) {
+        igraph_cattribute_EAN_setv(graph, name.c_str(), &col);
+      } else if (total > 0) {
+        SETGAN(graph, name.c_str(), VECTOR(col)[0]);
+      }
+      igraph_vector_destroy(&col);
+    } else {
+      igraph_strvector_t col;
+      igraph_strvector_init(&col, total);
+      for (size_t c = 0; c < chunks.size(); c++) {
+        attr_column_t &chunk_col = (chunks[c].*table).GetColumn(
+            merged_col.name, merged_col.name_len);
+        for (size_t i = 0; i < chunk_col.cells.size(); i++) {
+          if (chunk_col.cells[i].kind != CELL_ABSENT) {
+            DecodeString(chunk_col.cells[i], is_dot, decoded);
+            igraph_strvector_set(&col, offsets[c] + i, decoded.c_str());
+          }
+        }
+      }
+      if (elemtype == IGRAPH_ATTRIBUTE_VERTEX) {
+        igraph_cattribute_VAS_setv(graph, name.c_str(), &col);
+      } else if (elemtype == IGRAPH_ATTRIBUTE_EDGE) {
+        igraph_cattribute_EAS_setv(graph, name.c_str(), &col);
+      } else if (total > 0) {
+        SETGAS(graph, name.c_str(), STR(col, 0));
+      }
+      igraph_strvector_destroy(&col);
+    }
+  }
+}
+
+/** Read a GML or DOT file into graph. The file is memory-mapped and
+ * tokenized in place; large files are split at element boundaries and the
+ * pieces are parsed in parallel, then stitched together.
+ * @return false if the file cannot be mapped or is not in the supported
+ * subset, graph is not initialized in that case
+ */
+bool ReadGraphMapped(const char *file_name, bool is_dot, igraph_t *graph) {
+  int fd = open(file_name, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+  madvise(addr, size, MADV_SEQUENTIAL);
+  const char *begin = (const char *)addr;
+  const char *end = begin + size;
+
+  // Split the input into pieces at element boundaries
+  const size_t MIN_CHUNK_SIZE = 4 << 20;
+  size_t num_chunks = std::max(1u, std::thread::hardware_concurrency());
+  num_chunks = std::min(num_chunks, size / MIN_CHUNK_SIZE + 1);
+  std::vector<const char *> bounds(1, begin);
+  for (size_t i = 1; i < num_chunks; i++) {
+    const char *split = FindSplitPoint(
+        bounds.back(), std::max(bounds.back(), begin + size / num_chunks * i),
+        end, is_dot);
+    if (split >= end) {
+      break;
+    }
+    bounds.push_back(split);
+  }
+  bounds.push_back(end);
+  num_chunks = bounds.size() - 1;
+
+  std::vector<graph_chunk_t> chunks(num_chunks);
+  auto parse = [&](size_t c) {
+    if (is_dot) {
+      ParseDotChunk(bounds[c], bounds[c + 1], c == 0, &chunks[c]);
+    } else {
+      ParseGMLChunk(bounds[c], bounds[c + 1], c == 0, &chunks[c]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t c = 1; c < num_chunks; c++) {
+    workers.emplace_back(parse, c);
+  }
+  parse(0);
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  bool ok = true;
+  for (auto &chunk : chunks) {
+    ok = ok && chunk.ok;
+  }
+  if (!ok) {
+    munmap(addr, size);
+    return false;
+  }
+
+  // Stitch: vertices and edges are numbered in order of appearance
+  std::vector<long int> vertex_offsets, edge_offsets;
+  long int num_vertices = 0, num_edges = 0;
+  bool dense_ids = true;
+  for (auto &chunk : chunks) {
+    vertex_offsets.push_back(num_vertices);
+    edge_offsets.push_back(num_edges);
+    for (size_t i = 0; i < chunk.vertex_ids.size(); i++) {
+      dense_ids = dense_ids && (chunk.vertex_ids[i] == num_vertices + (long)i);
+    }
+    num_vertices += chunk.vertex_ids.size();
+    num_edges += chunk.edges.size() / 2;
+  }
+
+  // File ids are usually 0..n-1 in order, only build a map otherwise. DOT
+  // vertices may also be declared implicitly by an edge: they are numbered
+  // after the declared ones, in order of first appearance, through the same
+  // map.
+  long int num_declared = num_vertices;
+  std::unordered_map<long int, long int> id_2_vertex;
+  if (!dense_ids) {
+    id_2_vertex.reserve(num_vertices);
+    for (size_t c = 0; c < chunks.size(); c++) {
+      for (size_t i = 0; i < chunks[c].vertex_ids.size(); i++) {
+        id_2_vertex.insert(
+            std::make_pair(chunks[c].vertex_ids[i], vertex_offsets[c] + i));
+      }
+    }
+  }
+
+  igraph_vector_t edges;
+  igraph_vector_init(&edges, num_edges * 2);
+  long int pos = 0;
+  for (auto &chunk : chunks) {
+    for (auto id : chunk.edges) {
+      long int vertex_id = -1;
+      if (dense_ids && id >= 0 && id < num_declared) {
+        vertex_id = id;
+      } else {
+        auto iter = id_2_vertex.find(id);
+        if (iter != id_2_vertex.end()) {
+          vertex_id = iter->second;
+        } else if (is_dot) {
+          vertex_id = num_vertices++;
+          id_2_vertex.insert(std::make_pair(id, vertex_id));
+        }
+      }
+      if (vertex_id < 0) {
+        ok = false;
+        break;
+      }
+      VECTOR(edges)[pos++] = vertex_id;
+    }
+  }
+  if (!ok) {
+    igraph_vector_destroy(&edges);
+    munmap(addr, size);
+    return false;
+  }
+
+  igraph_empty(graph, num_vertices, chunks[0].directed ? IGRAPH_DIRECTED : 0);
+  igraph_add_edges(graph, &edges, 0);
+  igraph_vector_destroy(&edges);
+
+  SetAttributeColumns(graph, chunks, &graph_chunk_t::vattrs, vertex_offsets,
+                      num_vertices, IGRAPH_ATTRIBUTE_VERTEX, is_dot);
+  SetAttributeColumns(graph, chunks, &graph_chunk_t::eattrs, edge_offsets,
+                      num_edges, IGRAPH_ATTRIBUTE_EDGE, is_dot);
+  std::vector<long int> graph_offsets(chunks.size(), 0);
+  SetAttributeColumns(graph, chunks, &graph_chunk_t::gattrs, graph_offsets, 1,
+                      IGRAPH_ATTRIBUTE_GRAPH, is_dot);
+
+  munmap(addr, size);
+  return true;
+}
+
+} // namespace
+
 void Graph::ReadGraphGML(const char *file_name) {
-  FILE *in_file = fopen(file_name, "r");
-  igraph_read_graph_gml(&ipag_->graph, in_file);
+  if (!ReadGraphMapped(file_name, /*is_dot=*/false, &ipag_->graph)) {
+    // Fall back to igraph's parser for GML outside the supported subset
+    FILE *in_file = fopen(file_name, "r");
+    igraph_read_graph_gml(&ipag_->graph, in_file);
+    fclose(in_file);
+  }
   const char *graph_name = VAS(&ipag_->graph, "name", 0);
   SETGAS(&ipag_->graph, "name", graph_name);
-  fclose(in_file);
+
+  this->cur_vertex_num = igraph_vcount(&ipag_->graph);
+}
+
+void Graph::ReadGraphDot(const char *file_name) {
+  if (!ReadGraphMapped(file_name, /*is_dot=*/true, &ipag_->graph)) {
+    dbg("Error: Cannot read dot file", file_name);
+    igraph_empty(&ipag_->graph, 0, IGRAPH_DIRECTED);
+  }
 
   this->cur_vertex_num = igraph_vcount(&ipag_->graph);
 }
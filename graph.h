@@ -77,6 +77,16 @@ public:
    */
   type::vertex_t AddGraph(Graph *g);
 
+  /** Append a list of graphs to the graph in one batch. Vertices of all
+   * graphs are appended at once, edge ids are remapped in one pass over the
+   * edge arrays and attributes are copied column by column.
+   * @param graphs - the graphs to be appended
+   * @param entry_vertex_ids - ids of entry vertices of the appended new
+   * graphs (one per input graph, not ids in old graphs)
+   */
+  void AddGraphs(std::vector<Graph *> &graphs,
+                 std::vector<type::vertex_t> &entry_vertex_ids);
+
   /** Delete a vertex.
    * @param vertex_id - id of vertex to be removed
    */
@@ -87,6 +97,15 @@ public:
    */
   void DeleteVertices(depdetector::type::vertex_set_t *vs);
 
+  /** Delete a set of vertices with one compaction pass. Edge endpoints are
+   * rewritten and the relative order of remaining vertices is kept.
+   * @param vertex_ids - ids of vertices to be deleted
+   * @param old_2_new_vertex_id - if not nullptr, filled with the new id of
+   * each old vertex (-1 for deleted vertices)
+   */
+  void DeleteVertices(const std::vector<type::vertex_t> &vertex_ids,
+                      std::vector<type::vertex_t> *old_2_new_vertex_id);
+
   /** Delete extra vertices at the end of vertices. (No need to expose to
    * developers)
    */
@@ -332,11 +351,20 @@ public:
    */
   void Dfs();
 
-  /** Read a graph from a GML format file.
+  /** Read a graph from a GML format file. The file is memory-mapped and
+   * parsed in place (in parallel for large files); GML that is not in the
+   * subset written by DumpGraphGML falls back to igraph's parser.
    * @param file_name - name of input file
    */
   void ReadGraphGML(const char *file_name);
 
+  /** Read a graph from a dot format file written by DumpGraphDot. Vertex
+   * ids need not be dense; vertices only named by an edge are added after
+   * the declared ones.
+   * @param file_name - name of input file
+   */
+  void ReadGraphDot(const char *file_name);
+
   /** Dump the graph as a GML format file.
    * @param file_name - name of output file
    */
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+# Generate a synthetic loop nest as LLVM IR (.ll), in the rotated,
+# canonical-IV form clang -O1/-O2 produces, for benchmarking the DFG pass.
+#
+#   python3 script/gen_loop_nest.py --depth 3 --trip 64 --arrays 2 \
+#       --radius 1 --index affine -o nest.ll
+#
+# The innermost loop computes a star stencil of the given radius over every
+# input array and stores the result to A0:
+#   A0[i0][i1]... = sum_a sum_d sum_{|o|<=r} Aa[..][id + o][..]
+# With --index nonaffine, dimension d is subscripted by id * i(d+1)
+# instead of id.
+import argparse
+import sys
+
+
+def array_type(extents):
+    # Type pointed to by an array parameter: the inner dimensions
+    ty = "double"
+    for n in reversed(extents[1:]):
+        ty = "[%d x %s]" % (n, ty)
+    return ty
+
+
+def gen(depth, trips, num_arrays, radius, index, out_of_place):
+    r = radius
+    lines = []
+    emit = lines.append
+    elem_ty = array_type(trips)
+    params = ", ".join("%s* %%A%d" % (elem_ty, a) for a in range(num_arrays))
+    emit("; depth=%d trips=%s arrays=%d radius=%d index=%s%s" %
+         (depth, ",".join(map(str, trips)), num_arrays, radius, index,
+          " out-of-place" if out_of_place else ""))
+    emit("define void @kernel(%s) {" % params)
+    emit("entry:")
+    emit("  br label %L0")
+
+    def name(k, o):
+        if o == 0:
+            return "%%i%d" % k
+        return "%%i%d.%s%d" % (k, "p" if o > 0 else "m", abs(o))
+
+    for k in range(depth):
+        pred = "entry" if k == 0 else "L%d" % (k - 1)
+        latch = "L%d" % k if k == depth - 1 else "L%d.latch" % k
+        emit("L%d:" % k)
+        emit("  %%i%d = phi i64 [ %d, %%%s ], [ %%i%d.next, %%%s ]" %
+             (k, r, pred, k, latch))
+        if k < depth - 1:
+            emit("  br label %%L%d" % (k + 1))
+
+    # Innermost body: subscripts, loads, reduction, store
+    for k in range(depth):
+        base = "%%i%d" % k
+        if index == "nonaffine":
+            emit("  %%i%d.sq = mul nsw i64 %%i%d, %%i%d" %
+                 (k, k, (k + 1) % depth))
+            base = "%%i%d.sq" % k
+        for o in range(-r, r + 1):
+            if o != 0:
+                emit("  %s = add nsw i64 %s, %d" % (name(k, o), base, o))
+
+    def subscript(k, o):
+        if index == "nonaffine" and o == 0:
+            return "%%i%d.sq" % k
+        return name(k, o)
+
+    def gep(dst, a, offsets):
+        idx = ", ".join("i64 %s" % subscript(k, offsets[k])
+                        for k in range(depth))
+        emit("  %s = getelementptr inbounds %s, %s* %%A%d, %s" %
+             (dst, elem_ty, elem_ty, a, idx))
+
+    values = []
+    first_read = 1 if out_of_place else 0
+    n = 0
+    for a in range(first_read, num_arrays):
+        points = [[0] * depth]
+        for k in range(depth):
+            for o in range(-r, r + 1):
+                if o != 0:
+                    p = [0] * depth
+                    p[k] = o
+                    points.append(p)
+        for p in points:
+            gep("%%p%d" % n, a, p)
+            emit("  %%v%d = load double, double* %%p%d, align 8" % (n, n))
+            values.append("%%v%d" % n)
+            n += 1
+    acc = values[0] if values else "0.0"
+    for i, v in enumerate(values[1:]):
+        emit("  %%s%d = fadd double %s, %s" % (i, acc, v))
+        acc = "%%s%d" % i
+    gep("%pw", 0, [0] * depth)
+    emit("  store double %s, double* %%pw, align 8" % acc)
+
+    # Latches, from the innermost loop outwards
+    for k in reversed(range(depth)):
+        if k < depth - 1:
+            emit("L%d.latch:" % k)
+        exit_bb = "exit" if k == 0 else "L%d.latch" % (k - 1)
+        emit("  %%i%d.next = add nuw nsw i64 %%i%d, 1" % (k, k))
+        emit("  %%c%d = icmp eq i64 %%i%d.next, %d" % (k, k, trips[k] - r))
+        emit("  br i1 %%c%d, label %%%s, label %%L%d" % (k, exit_bb, k))
+    emit("exit:")
+    emit("  ret void")
+    emit("}")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--depth", type=int, default=2)
+    parser.add_argument("--trip", default="64",
+                        help="trip count (array extent), or one per level "
+                        "separated by commas, outermost first")
+    parser.add_argument("--arrays", type=int, default=1)
+    parser.add_argument("--radius", type=int, default=1)
+    parser.add_argument("--index", choices=["affine", "nonaffine"],
+                        default="affine")
+    parser.add_argument("--out-of-place", action="store_true",
+                        help="do not read the written array A0")
+    parser.add_argument("-o", "--output", default="-")
+    args = parser.parse_args()
+
+    trips = [int(t) for t in args.trip.split(",")]
+    if len(trips) == 1:
+        trips = trips * args.depth
+    if len(trips) != args.depth or args.depth < 1:
+        sys.exit("error: need one trip count per loop level")
+    if args.out_of_place and args.arrays < 2:
+        sys.exit("error: --out-of-place needs at least 2 arrays")
+    if any(t <= 2 * args.radius for t in trips):
+        sys.exit("error: trip counts must be larger than 2 * radius")
+
+    ir = gen(args.depth, trips, args.arrays, args.radius, args.index,
+             args.out_of_place)
+    if args.output == "-":
+        sys.stdout.write(ir)
+    else:
+        with open(args.output, "w") as f:
+            f.write(ir)
+
+
+if __name__ == "__main__":
+    main()
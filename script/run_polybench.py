@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# End-to-end benchmark of the DFG pass over the kernels in example/polybench.
+#
+#   python3 script/run_polybench.py --pass build/src/DFGPass.so
+#
+# Every kernel is compiled to bitcode with fixed flags, then the pass is run
+# on it --repeat times. The best wall time, the peak RSS of opt and the size
+# of the pass output are compared against example/polybench/baseline.json;
+# the script exits with 1 if any kernel regresses by more than --tolerance,
+# its output changes or it has no baseline. The results of every run are
+# written to polybench.json in the build directory of the pass; only
+# --update, run on the reference machine, writes the baseline.
+import argparse
+import glob
+import hashlib
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+ROOT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+KERNEL_DIR = os.path.join(ROOT_DIR, "example", "polybench")
+
+# Keep loops in the canonical form the pass recognizes: no unrolling and
+# no vectorization
+CFLAGS = ["-c", "-g", "-emit-llvm", "-O2", "-fno-unroll-loops",
+          "-fno-vectorize", "-fno-slp-vectorize"]
+
+
+def compile_kernel(cc, src, bc):
+    subprocess.check_call([cc] + CFLAGS + [src, "-o", bc])
+
+
+def run_pass(opt, pass_so, bc, work_dir):
+    # The pass writes one .dot file per function into its working directory
+    cmd = [opt, "-load", pass_so, "-DFGPass", "-enable-new-pm=0", bc,
+           "-o", os.devnull]
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, cwd=work_dir, stdout=subprocess.PIPE)
+    digest = hashlib.sha1()
+    size = 0
+    for chunk in iter(lambda: proc.stdout.read(1 << 16), b""):
+        digest.update(chunk)
+        size += len(chunk)
+    _, status, rusage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        raise subprocess.CalledProcessError(proc.returncode, cmd)
+    return {
+        "wall_s": wall,
+        "peak_rss_kb": rusage.ru_maxrss,
+        "output_bytes": size,
+        "output_sha1": digest.hexdigest(),
+    }
+
+
+def measure(args, name, src, work_dir):
+    bc = os.path.join(work_dir, name + ".bc")
+    compile_kernel(args.cc, src, bc)
+    best = None
+    for _ in range(args.repeat):
+        r = run_pass(args.opt, args.pass_so, bc, work_dir)
+        if best is None:
+            best = r
+            continue
+        if r["output_sha1"] != best["output_sha1"]:
+            sys.exit("error: %s: output differs between runs" % name)
+        best["wall_s"] = min(best["wall_s"], r["wall_s"])
+        best["peak_rss_kb"] = min(best["peak_rss_kb"], r["peak_rss_kb"])
+    return best
+
+
+def compare(name, cur, base, tolerance):
+    problems = []
+    if base is None:
+        return problems
+    if cur["output_sha1"] != base["output_sha1"]:
+        problems.append("output changed (%d -> %d bytes)" %
+                        (base["output_bytes"], cur["output_bytes"]))
+    for key in ("wall_s", "peak_rss_kb"):
+        if cur[key] > base[key] * (1.0 + tolerance):
+            problems.append("%s %.3g -> %.3g (+%.0f%%)" %
+                            (key, base[key], cur[key],
+                             100.0 * (cur[key] / base[key] - 1.0)))
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="End-to-end benchmark of the DFG pass")
+    parser.add_argument("--pass", dest="pass_so",
+                        default=os.path.join(ROOT_DIR, "build", "src",
+                                             "DFGPass.so"))
+    parser.add_argument("--cc", default="clang")
+    parser.add_argument("--opt", default="opt")
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--tolerance", type=float, default=0.2,
+                        help="allowed relative increase of wall time and "
+                        "peak memory (default: 0.2)")
+    parser.add_argument("--baseline",
+                        default=os.path.join(KERNEL_DIR, "baseline.json"))
+    parser.add_argument("--update", action="store_true",
+                        help="record this run as the baseline")
+    parser.add_argument("--json",
+                        help="file to write the results to (default: "
+                        "polybench.json in the build directory of --pass)")
+    parser.add_argument("kernels", nargs="*",
+                        help="kernel names (default: all)")
+    args = parser.parse_args()
+    args.pass_so = os.path.abspath(args.pass_so)
+    args.repeat = max(args.repeat, 1)
+    if not args.json:
+        # build/src/DFGPass.so -> build/polybench.json
+        args.json = os.path.join(os.path.dirname(os.path.dirname(args.pass_so)),
+                                 "polybench.json")
+
+    srcs = sorted(glob.glob(os.path.join(KERNEL_DIR, "*.c")))
+    names = [os.path.splitext(os.path.basename(s))[0] for s in srcs]
+    if args.kernels:
+        unknown = set(args.kernels) - set(names)
+        if unknown:
+            sys.exit("error: unknown kernel(s): " + ", ".join(sorted(unknown)))
+        srcs = [s for s, n in zip(srcs, names) if n in args.kernels]
+        names = [n for n in names if n in args.kernels]
+
+    baselines = {}
+    if not args.update:
+        if not os.path.exists(args.baseline):
+            sys.exit("error: no baseline %s, record one with --update" %
+                     os.path.relpath(args.baseline))
+        with open(args.baseline) as f:
+            baselines = json.load(f)
+
+    results = {}
+    failed = False
+    print("%-12s %10s %12s %12s  %s" %
+          ("kernel", "wall(s)", "peak RSS(KB)", "output(B)", "status"))
+    with tempfile.TemporaryDirectory() as work_dir:
+        for name, src in zip(names, srcs):
+            cur = measure(args, name, src, work_dir)
+            results[name] = cur
+            base = baselines.get(name)
+            problems = compare(name, cur, base, args.tolerance)
+            if args.update:
+                status = "recorded"
+            elif base is None:
+                status = "NO BASELINE"
+                failed = True
+            elif problems:
+                status = "REGRESSED: " + "; ".join(problems)
+                failed = True
+            else:
+                status = "ok"
+            print("%-12s %10.3f %12d %12d  %s" %
+                  (name, cur["wall_s"], cur["peak_rss_kb"],
+                   cur["output_bytes"], status))
+
+    with open(args.json, "w") as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+        f.write("\n")
+    print("results written to %s" % os.path.relpath(args.json))
+    # --update overwrites the measured kernels and keeps the others
+    if args.update:
+        merged = {}
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                merged = json.load(f)
+        merged.update(results)
+        with open(args.baseline, "w") as f:
+            json.dump(merged, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline written to %s" % os.path.relpath(args.baseline))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
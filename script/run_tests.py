@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+# Regression tests of the DFG pass over the loop nests in example/test.
+#
+#   python3 script/run_tests.py --pass build/src/DFGPass.so
+#
+# The pass is run on every example/test/*.ll with its analyses and metadata
+# turned on. Its output, the -dfg-stats JSON and every report are compared
+# with example/test/expected/<test>.json, and the IR it writes with
+# example/test/expected/<test>.ll. Times and memory sizes are left out. The
+# script exits with 1 if any test differs. Run with --update to record new
+# expected files after a deliberate change.
+import argparse
+import difflib
+import glob
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+TEST_DIR = os.path.join(ROOT_DIR, "example", "test")
+EXPECTED_DIR = os.path.join(TEST_DIR, "expected")
+
+# Report options, by the key of their output in the expected JSON
+REPORTS = {
+    "parallel": "-dfg-parallel-loops",
+    "tiling": "-dfg-tiling",
+    "traffic": "-dfg-traffic",
+    "strides": "-dfg-strides",
+    "interchange": "-dfg-interchange",
+    "fusion": "-dfg-fusion",
+    "stencils": "-dfg-stencils",
+}
+
+FLAGS = ["-dfg-cache-sim", "-dfg-wavefront", "-dfg-parallel-metadata",
+         "-dfg-interchange-metadata"]
+
+# Stats that vary from run to run
+VOLATILE_KEYS = {"time", "memory", "dependence_s", "seconds", "peak_bytes"}
+
+
+def strip_volatile(value):
+    if isinstance(value, dict):
+        return {k: strip_volatile(v) for k, v in value.items()
+                if k not in VOLATILE_KEYS}
+    if isinstance(value, list):
+        return [strip_volatile(v) for v in value]
+    return value
+
+
+def run_pass(opt, pass_so, ll, work_dir):
+    # The pass writes one .dot file per function into its working directory.
+    # It is given a copy of the input, so that no path shows in its output
+    name = os.path.basename(ll)
+    shutil.copy(ll, os.path.join(work_dir, name))
+    cmd = [opt, "-load", pass_so, "-DFGPass", "-enable-new-pm=0", name, "-S",
+           "-o", os.path.join(work_dir, "out.ll"),
+           "-dfg-stats=" + os.path.join(work_dir, "stats.json")] + FLAGS
+    for key, flag in REPORTS.items():
+        cmd.append(flag + "=" + os.path.join(work_dir, key + ".json"))
+    proc = subprocess.run(cmd, cwd=work_dir, stdout=subprocess.PIPE,
+                          universal_newlines=True, check=True)
+    result = {"output": proc.stdout.splitlines()}
+    with open(os.path.join(work_dir, "stats.json")) as f:
+        result["stats"] = strip_volatile(json.load(f))
+    for key in REPORTS:
+        with open(os.path.join(work_dir, key + ".json")) as f:
+            result[key] = json.load(f)
+    with open(os.path.join(work_dir, "out.ll")) as f:
+        ir = f.read()
+    return json.dumps(result, indent=2, sort_keys=True) + "\n", ir
+
+
+def diff(expected_file, actual):
+    if not os.path.exists(expected_file):
+        return ["missing " + os.path.relpath(expected_file, ROOT_DIR) + "\n"]
+    with open(expected_file) as f:
+        expected = f.read()
+    return list(difflib.unified_diff(
+        expected.splitlines(True), actual.splitlines(True),
+        os.path.relpath(expected_file, ROOT_DIR), "actual"))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Regression tests of the DFG pass")
+    parser.add_argument("--pass", dest="pass_so", required=True,
+                        help="path to DFGPass.so")
+    parser.add_argument("--opt", default="opt")
+    parser.add_argument("--update", action="store_true",
+                        help="record the expected files")
+    parser.add_argument("tests", nargs="*",
+                        help="test names (default: all of example/test)")
+    args = parser.parse_args()
+
+    lls = sorted(glob.glob(os.path.join(TEST_DIR, "*.ll")))
+    if args.tests:
+        lls = [ll for ll in lls
+               if os.path.splitext(os.path.basename(ll))[0] in args.tests]
+    pass_so = os.path.abspath(args.pass_so)
+
+    failed = []
+    for ll in lls:
+        name = os.path.splitext(os.path.basename(ll))[0]
+        with tempfile.TemporaryDirectory() as work_dir:
+            result, ir = run_pass(args.opt, pass_so, ll, work_dir)
+        json_file = os.path.join(EXPECTED_DIR, name + ".json")
+        ir_file = os.path.join(EXPECTED_DIR, name + ".ll")
+        if args.update:
+            os.makedirs(EXPECTED_DIR, exist_ok=True)
+            with open(json_file, "w") as f:
+                f.write(result)
+            with open(ir_file, "w") as f:
+                f.write(ir)
+            print("%-12s recorded" % name)
+            continue
+        lines = diff(json_file, result) + diff(ir_file, ir)
+        if lines:
+            failed.append(name)
+            print("%-12s FAILED" % name)
+            sys.stdout.writelines(lines)
+        else:
+            print("%-12s ok" % name)
+
+    if failed:
+        print("failed: " + ", ".join(failed))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,238 @@
+#ifndef AFFINE_H_
+#define AFFINE_H_
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pattern.h"
+
+// Integer value of a CONSTANT pattern node. Loop-invariant values that are
+// not integer literals are CONSTANT nodes too, named after the value.
+inline bool parseConstant(PatNode* pn, long long& val) {
+    if (!pn || pn->getType() != CONSTANT) {
+        return false;
+    }
+    const std::string& str = pn->getConstantNum();
+    char* end;
+    val = strtoll(str.c_str(), &end, 10);
+    return end != str.c_str() && *end == '\0';
+}
+
+// Closed integer interval; unknown means any value
+struct Interval {
+    bool known = false;
+    long long lo = 0;
+    long long hi = 0;
+
+    Interval() {}
+    Interval(long long lo, long long hi) : known(true), lo(lo), hi(hi) {}
+
+    bool intersects(const Interval& other) const {
+        if (!known || !other.known) {
+            return true;
+        }
+        return lo <= other.hi && other.lo <= hi;
+    }
+};
+
+// Range of the ind var of a loop with constant bounds (end is exclusive)
+inline Interval getIndVarRange(int start, int end, int step) {
+    if (step <= 0 || start >= end) {
+        return Interval();
+    }
+    return Interval(start, start + (long long)(end - 1 - start) / step * step);
+}
+
+// c + sum(coeffs[v] * v) over loop ind vars v
+class AffineExpr {
+private:
+    bool _valid = true;
+    long long _const = 0;
+    std::map<std::string, long long> _coeffs;
+
+public:
+    AffineExpr() {}
+    explicit AffineExpr(long long c) : _const(c) {}
+
+    static AffineExpr invalid() {
+        AffineExpr e;
+        e._valid = false;
+        return e;
+    }
+
+    static AffineExpr indVar(const std::string& name) {
+        AffineExpr e;
+        e._coeffs[name] = 1;
+        return e;
+    }
+
+    // Affine form of a subscript pattern, invalid if it is not affine in
+    // the ind vars (or uses values the evaluator does not know)
+    static AffineExpr fromPattern(PatNode* pn) {
+        if (!pn) {
+            return invalid();
+        }
+        auto type = pn->getType();
+        auto& children = pn->getChildren();
+        long long c;
+        if (type == CONSTANT) {
+            return parseConstant(pn, c) ? AffineExpr(c) : invalid();
+        } else if (type == LOOP_IND_VAR) {
+            return indVar(pn->getValueName());
+        } else if (type == CAST_INST) {
+            return children.size() == 1 ? fromPattern(children[0]) : invalid();
+        } else if (type != BIN_OP) {
+            return invalid();
+        }
+
+        auto& op = pn->getOp();
+        if (op == "+") {
+            AffineExpr sum(0);
+            for (auto child : children) {
+                sum.add(fromPattern(child), 1);
+            }
+            return sum;
+        }
+        if (children.size() != 2) {
+            return invalid();
+        }
+        AffineExpr a = fromPattern(children[0]);
+        AffineExpr b = fromPattern(children[1]);
+        if (op == "-") {
+            a.add(b, -1);
+            return a;
+        } else if (op == "*") {
+            if (a.isConstant()) {
+                b.scale(a._const);
+                return b;
+            } else if (b.isConstant()) {
+                a.scale(b._const);
+                return a;
+            }
+        } else if (op == "<<" && b.isConstant() && b._const >= 0 &&
+                   b._const < 31) {
+            a.scale(1LL << b._const);
+            return a;
+        }
+        return invalid();
+    }
+
+    bool isValid() const { return _valid; }
+
+    bool isConstant() const { return _valid && _coeffs.empty(); }
+
+    long long getConstant() const { return _const; }
+
+    long long getCoeff(const std::string& ind_var) const {
+        auto iter = _coeffs.find(ind_var);
+        return iter == _coeffs.end() ? 0 : iter->second;
+    }
+
+    const std::map<std::string, long long>& getCoeffs() const { return _coeffs; }
+
+    void add(const AffineExpr& other, long long factor) {
+        _valid = _valid && other._valid;
+        _const += factor * other._const;
+        for (auto& term : other._coeffs) {
+            long long& coeff = _coeffs[term.first];
+            coeff += factor * term.second;
+            if (coeff == 0) {
+                _coeffs.erase(term.first);
+            }
+        }
+    }
+
+    void scale(long long factor) {
+        _const *= factor;
+        for (auto iter = _coeffs.begin(); iter != _coeffs.end();) {
+            iter->second *= factor;
+            if (iter->second == 0) {
+                iter = _coeffs.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    // Exact range over the box of ind var ranges
+    Interval getRange(const std::map<std::string, Interval>& ranges) const {
+        if (!_valid) {
+            return Interval();
+        }
+        long long lo = _const, hi = _const;
+        for (auto& term : _coeffs) {
+            auto iter = ranges.find(term.first);
+            if (iter == ranges.end() || !iter->second.known) {
+                return Interval();
+            }
+            long long a = term.second * iter->second.lo;
+            long long b = term.second * iter->second.hi;
+            lo += std::min(a, b);
+            hi += std::max(a, b);
+        }
+        return Interval(lo, hi);
+    }
+};
+
+// Range of a subscript pattern over the ind var ranges. Affine subscripts
+// get their exact range, other ones interval arithmetic, following the
+// operators LoopUnrollAnalysis::getPatNodeValue evaluates.
+inline Interval getPatternRange(PatNode* pn,
+                                const std::map<std::string, Interval>& ranges) {
+    AffineExpr affine = AffineExpr::fromPattern(pn);
+    if (affine.isValid()) {
+        return affine.getRange(ranges);
+    }
+    if (!pn) {
+        return Interval();
+    }
+    auto type = pn->getType();
+    auto& children = pn->getChildren();
+    if (type == CAST_INST && children.size() == 1) {
+        return getPatternRange(children[0], ranges);
+    }
+    if (type != BIN_OP) {
+        return Interval();
+    }
+
+    std::vector<Interval> child_ranges;
+    for (auto child : children) {
+        child_ranges.push_back(getPatternRange(child, ranges));
+        if (!child_ranges.back().known) {
+            return Interval();
+        }
+    }
+    auto& op = pn->getOp();
+    if (op == "+") {
+        Interval sum(0, 0);
+        for (auto& r : child_ranges) {
+            sum.lo += r.lo;
+            sum.hi += r.hi;
+        }
+        return sum;
+    }
+    if (child_ranges.size() != 2) {
+        return Interval();
+    }
+    Interval& a = child_ranges[0];
+    Interval& b = child_ranges[1];
+    if (op == "-") {
+        return Interval(a.lo - b.hi, a.hi - b.lo);
+    } else if (op == "*") {
+        long long p[4] = {a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi};
+        return Interval(*std::min_element(p, p + 4), *std::max_element(p, p + 4));
+    } else if (op == "/" && b.lo > 0) {
+        // Truncating division by a positive divisor is monotonic
+        long long p[4] = {a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi};
+        return Interval(*std::min_element(p, p + 4), *std::max_element(p, p + 4));
+    } else if (op == ">>" && b.lo >= 0 && b.hi < 31) {
+        long long p[4] = {a.lo >> b.lo, a.lo >> b.hi, a.hi >> b.lo, a.hi >> b.hi};
+        return Interval(*std::min_element(p, p + 4), *std::max_element(p, p + 4));
+    }
+    return Interval();
+}
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef CACHE_MODEL_H_
+#define CACHE_MODEL_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/GetElementPtrTypeIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "affine.h"
+#include "json_report.h"
+#include "pattern.h"
+
+// Iterations sampled per footprint of a non-affine reference
+static const long long REUSE_SAMPLE_ITERS = 1 << 16;
+
+// Cache hierarchy the tiling advisor and the miss model are fitted to.
+// Caches are modelled as fully associative LRU caches of whole lines; the
+// simulator of cache_sim.h also uses the associativity and the policy.
+
+enum cache_level_t {
+    CACHE_L1 = 0,
+    CACHE_L2 = 1,
+    CACHE_LLC = 2,
+    NUM_CACHE_LEVELS = 3
+};
+
+static const char* cache_level_names[NUM_CACHE_LEVELS] = {"L1", "L2", "LLC"};
+
+enum cache_policy_t {
+    POLICY_LRU = 0,
+    POLICY_PLRU = 1 // tree pseudo-LRU
+};
+
+struct cache_config_t {
+    long long capacity[NUM_CACHE_LEVELS] = {0}; // bytes
+    int line_bytes = 64;
+    int ways[NUM_CACHE_LEVELS] = {8, 16, 16}; // simulator only
+    cache_policy_t policy = POLICY_LRU;       // simulator only
+};
+
+// Size of the elements addressed by a GEP pattern, from the DataLayout of
+// the module
+inline long long getElementBytes(PatNode* pn) {
+    auto gep = llvm::dyn_cast_or_null<llvm::GetElementPtrInst>(pn->getValue());
+    if (!gep) {
+        return 0;
+    }
+    auto& DL = gep->getModule()->getDataLayout();
+    return DL.getTypeAllocSize(gep->getResultElementType()).getFixedSize();
+}
+
+// Bytes each subscript of a GEP pattern advances the address by, from the
+// DataLayout; empty if the pattern is not a GEP. Struct fields are
+// constants and count for 0.
+inline std::vector<long long> getSubscriptStrides(PatNode* pn) {
+    std::vector<long long> strides;
+    auto gep = llvm::dyn_cast_or_null<llvm::GetElementPtrInst>(pn->getValue());
+    if (!gep) {
+        return strides;
+    }
+    auto& DL = gep->getModule()->getDataLayout();
+    for (auto GTI = llvm::gep_type_begin(gep), E = llvm::gep_type_end(gep); GTI != E; ++GTI) {
+        strides.push_back(GTI.isStruct() ? 0
+                                         : (long long)DL.getTypeAllocSize(GTI.getIndexedType())
+                                               .getFixedSize());
+    }
+    return strides;
+}
+
+// Lines and byte span a reference touches during one execution of the
+// loops from some level inwards, the loops outside at their first
+// iteration
+struct ref_footprint_t {
+    double lines = 0;
+    Interval span; // addresses, relative to the array; unknown if sampled partially
+};
+
+// Byte address of an affine reference: base + sum(coeff[k] * x_k) over the
+// iteration numbers x_k of the loops of the nest
+struct ref_address_t {
+    bool affine = false;
+    long long base = 0;
+    std::vector<long long> coeff;
+    long long elem_bytes = 0;
+};
+
+// Byte address of a reference relative to its array, from the DataLayout
+// strides of its subscripts; affine if every subscript is affine in the
+// ind vars of the loops, whose iterations start at start and advance by
+// step. False if the strides are unknown.
+inline bool getRefAddress(PatNode* pn, const std::vector<std::string>& ind_vars,
+                          const std::vector<int>& start, const std::vector<int>& step,
+                          ref_address_t& addr) {
+    int depth = ind_vars.size();
+    std::vector<long long> strides = getSubscriptStrides(pn);
+    auto& subs = pn->getChildren();
+    if (strides.size() != subs.size()) {
+        return false;
+    }
+    addr.affine = true;
+    addr.base = 0;
+    addr.coeff.assign(depth, 0);
+    addr.elem_bytes = getElementBytes(pn);
+    for (size_t d = 0; d < subs.size(); d++) {
+        AffineExpr e = AffineExpr::fromPattern(subs[d]);
+        long long known = 0;
+        for (int k = 0; k < depth; k++) {
+            long long a = e.getCoeff(ind_vars[k]);
+            known += a != 0;
+            addr.base += strides[d] * a * start[k];
+            addr.coeff[k] += strides[d] * a * step[k];
+        }
+        addr.base += strides[d] * e.getConstant();
+        addr.affine = addr.affine && e.isValid() && known == (long long)e.getCoeffs().size();
+    }
+    return true;
+}
+
+// Closed form footprint of an affine reference over the loops from level
+// m: the loop with the smallest stride below a line walks lines, the other
+// moving loops multiply them; never more than the lines of the span
+inline ref_footprint_t getAffineFootprint(const ref_address_t& a,
+                                          const std::vector<long long>& trip, int m,
+                                          int line_bytes) {
+    ref_footprint_t fp;
+    long long lo = a.base, hi = a.base;
+    int contiguous = -1;
+    for (size_t k = m; k < trip.size(); k++) {
+        long long delta = a.coeff[k] * (trip[k] - 1);
+        lo += std::min(0LL, delta);
+        hi += std::max(0LL, delta);
+        if (a.coeff[k] != 0 && std::abs(a.coeff[k]) < line_bytes &&
+            (contiguous < 0 || std::abs(a.coeff[k]) < std::abs(a.coeff[contiguous]))) {
+            contiguous = k;
+        }
+    }
+    fp.span = Interval(lo, hi + a.elem_bytes - 1);
+    double lines = 1;
+    for (size_t k = m; k < trip.size(); k++) {
+        if (a.coeff[k] == 0) {
+            continue;
+        }
+        if ((int)k == contiguous) {
+            lines *= std::ceil((double)(std::abs(a.coeff[k]) * (trip[k] - 1) + a.elem_bytes) /
+                               line_bytes);
+        } else {
+            lines *= trip[k];
+        }
+    }
+    double span_lines = std::floor((double)fp.span.hi / line_bytes) -
+                        std::floor((double)fp.span.lo / line_bytes) + 1;
+    fp.lines = std::min(lines, span_lines);
+    return fp;
+}
+
+enum reuse_kind_t {
+    REUSE_NONE = 0,
+    REUSE_TEMPORAL = 1, // the same element
+    REUSE_SPATIAL = 2,  // the same line
+    REUSE_SAMPLED = 3   // subscripts not affine, footprints sampled
+};
+
+static const char* reuse_kind_names[] = {"none", "temporal", "spatial", "sampled"};
+
+struct ref_reuse_t {
+    std::string array;
+    bool write = false;
+    reuse_kind_t kind = REUSE_NONE;
+    int level = -1;          // innermost loop carrying the reuse
+    double distance = -1;    // distinct lines touched between two uses, -1 = none
+    double misses[NUM_CACHE_LEVELS] = {0}; // per iteration of the nest
+};
+
+struct reuse_report_t {
+    bool valid = false;
+    std::string reason;
+    long long iterations = 0;
+    std::vector<ref_reuse_t> refs;
+    int local_level[NUM_CACHE_LEVELS] = {0}; // outermost loop whose footprint fits
+    double misses[NUM_CACHE_LEVELS] = {0};   // per iteration, all references
+    double traffic[NUM_CACHE_LEVELS] = {0};  // bytes filled into each level
+};
+
+// Misses of a nest in each cache level. footprints[r][m] is the footprint
+// of reference r over loops m.. (m = depth: one iteration). The lines of
+// one array are at most those of the union of its spans. A cache of L
+// lines keeps the data of the loops from the outermost level m whose
+// footprint fits (the localized iteration space): every line of it misses
+// once per execution of those loops. Shares of sampled references may
+// have unknown spans, then the sum of the lines stands.
+inline void estimateMisses(reuse_report_t& report,
+                           const std::vector<std::vector<ref_footprint_t>>& footprints,
+                           const std::vector<long long>& trip, const cache_config_t& config) {
+    int depth = trip.size();
+    int num_refs = report.refs.size();
+    // Lines of the whole nest over loops m.., and each reference's share
+    std::vector<double> total(depth + 1, 0);
+    std::vector<std::vector<double>> share(num_refs, std::vector<double>(depth + 1, 0));
+    for (int m = 0; m <= depth; m++) {
+        std::map<std::string, std::vector<int>> arrays;
+        for (int r = 0; r < num_refs; r++) {
+            arrays[report.refs[r].array].push_back(r);
+        }
+        for (auto& array: arrays) {
+            double sum = 0;
+            Interval span;
+            bool spans_known = true;
+            for (int r: array.second) {
+                const ref_footprint_t& fp = footprints[r][m];
+                sum += fp.lines;
+                spans_known = spans_known && fp.span.known;
+                if (!span.known) {
+                    span = fp.span;
+                }
+                span.lo = std::min(span.lo, fp.span.lo);
+                span.hi = std::max(span.hi, fp.span.hi);
+            }
+            double lines = sum;
+            if (spans_known && span.known) {
+                lines = std::min(sum, std::floor((double)span.hi / config.line_bytes) -
+                                          std::floor((double)span.lo / config.line_bytes) + 1);
+            }
+            for (int r: array.second) {
+                share[r][m] = sum > 0 ? footprints[r][m].lines * lines / sum : 0;
+            }
+            total[m] += lines;
+        }
+    }
+
+    for (auto& ref: report.refs) {
+        if (ref.level >= 0) {
+            ref.distance = total[ref.level + 1];
+        }
+    }
+    for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+        double cache_lines = (double)config.capacity[c] / config.line_bytes;
+        int m = 0;
+        while (m < depth && total[m] > cache_lines) {
+            m++;
+        }
+        report.local_level[c] = m;
+        double outer = 1;
+        for (int k = 0; k < m; k++) {
+            outer *= trip[k];
+        }
+        for (int r = 0; r < num_refs; r++) {
+            double& misses = report.refs[r].misses[c];
+            misses = outer * share[r][m] / report.iterations;
+            // LRU inclusion: a larger cache never misses more
+            if (c > 0) {
+                misses = std::min(misses, report.refs[r].misses[c - 1]);
+            }
+            report.misses[c] += misses;
+        }
+        report.traffic[c] = report.misses[c] * report.iterations * config.line_bytes;
+    }
+}
+
+// JSON list of the leaf loop nests, ranked by the bytes they bring in from
+// memory (LLC fills), then L2 and L1 fills:
+//   [{"function": ..., "loops": [ind_var, ...], "file": ..., "line": n,
+//     "iterations": n, "traffic": {"L1": bytes, ...},
+//     "misses_per_iteration": {"L1": x, ...}}, ...]
+class TrafficReport : public JSONListReport {
+private:
+    struct entry_t {
+        std::string func_name;
+        std::vector<std::string> ind_vars;
+        std::string file;
+        unsigned line = 0;
+        reuse_report_t report;
+    };
+
+    std::vector<entry_t> _entries;
+
+public:
+    void add(const std::string& func_name, const std::vector<std::string>& ind_vars,
+             const llvm::DebugLoc& loc, const reuse_report_t& report) {
+        if (!_json || !report.valid) {
+            return;
+        }
+        entry_t entry;
+        entry.func_name = func_name;
+        entry.ind_vars = ind_vars;
+        if (loc) {
+            entry.file = loc->getFilename().str();
+            entry.line = loc.getLine();
+        }
+        entry.report = report;
+        entry.report.refs.clear();
+        _entries.push_back(entry);
+    }
+
+    void close() {
+        if (!_json) {
+            return;
+        }
+        std::stable_sort(_entries.begin(), _entries.end(), [](const entry_t& a, const entry_t& b) {
+            for (int c = NUM_CACHE_LEVELS - 1; c >= 0; c--) {
+                if (a.report.traffic[c] != b.report.traffic[c]) {
+                    return a.report.traffic[c] > b.report.traffic[c];
+                }
+            }
+            return false;
+        });
+        for (auto& entry: _entries) {
+            _json->object([&] {
+                _json->attribute("function", entry.func_name);
+                _json->attributeArray("loops", [&] {
+                    for (auto& ind_var: entry.ind_vars) {
+                        _json->value(ind_var);
+                    }
+                });
+                if (!entry.file.empty()) {
+                    _json->attribute("file", entry.file);
+                    _json->attribute("line", (int64_t)entry.line);
+                }
+                _json->attribute("iterations", entry.report.iterations);
+                _json->attributeObject("traffic", [&] {
+                    for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                        _json->attribute(cache_level_names[c], entry.report.traffic[c]);
+                    }
+                });
+                _json->attributeObject("misses_per_iteration", [&] {
+                    for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                        _json->attribute(cache_level_names[c], entry.report.misses[c]);
+                    }
+                });
+            });
+        }
+        JSONListReport::close();
+        _entries.clear();
+    }
+};
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef CACHE_SIM_H_
+#define CACHE_SIM_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cache_model.h"
+
+// Trace-driven simulator of a hierarchy of set-associative caches, LRU or
+// tree pseudo-LRU. Lines are allocated on reads and writes in every level
+// that misses; levels are neither inclusive nor exclusive. All state is
+// allocated up front, accesses come in batches.
+
+// Accesses buffered before they are simulated
+static const int CACHE_SIM_BATCH = 4096;
+
+struct cache_counts_t {
+    long long hits = 0;
+    long long misses = 0;
+    long long evictions = 0; // valid lines replaced by the misses
+};
+
+class CacheLevelSim {
+private:
+    static constexpr uint64_t INVALID = ~0ULL;
+
+    cache_policy_t _policy;
+    int _ways;
+    uint64_t _sets;
+    uint64_t _set_mask; // _sets - 1 if a power of two, else 0
+    std::vector<uint64_t> _tags;  // _sets * _ways lines
+    std::vector<uint64_t> _stamp; // LRU: last use of each way
+    std::vector<uint64_t> _tree;  // PLRU: bits of the nodes 1.._ways-1 of each set
+    uint64_t _clock = 0;
+
+    int findVictim(uint64_t set, uint64_t* tags) {
+        for (int w = 0; w < _ways; w++) {
+            if (tags[w] == INVALID) {
+                return w;
+            }
+        }
+        if (_policy == POLICY_PLRU) {
+            uint64_t bits = _tree[set];
+            int n = 1;
+            while (n < _ways) {
+                n = 2 * n + ((bits >> n) & 1);
+            }
+            return n - _ways;
+        }
+        uint64_t* stamp = &_stamp[set * _ways];
+        int victim = 0;
+        for (int w = 1; w < _ways; w++) {
+            if (stamp[w] < stamp[victim]) {
+                victim = w;
+            }
+        }
+        return victim;
+    }
+
+    void touch(uint64_t set, int way) {
+        if (_policy == POLICY_PLRU) {
+            // Point every node on the path away from way
+            uint64_t bits = _tree[set];
+            int n = 1;
+            for (int half = _ways / 2; half >= 1; half /= 2) {
+                int right = (way & half) != 0;
+                bits = right ? bits & ~(1ULL << n) : bits | (1ULL << n);
+                n = 2 * n + right;
+            }
+            _tree[set] = bits;
+        } else {
+            _stamp[set * _ways + way] = ++_clock;
+        }
+    }
+
+public:
+    // PLRU needs a power of two of ways up to 64; other counts are rounded
+    // down
+    CacheLevelSim(long long capacity, int line_bytes, int ways, cache_policy_t policy)
+        : _policy(policy) {
+        _ways = ways < 1 ? 1 : ways;
+        if (_policy == POLICY_PLRU) {
+            int pow2 = 1;
+            while (pow2 * 2 <= _ways && pow2 < 64) {
+                pow2 *= 2;
+            }
+            _ways = pow2;
+        }
+        _sets = capacity / ((long long)line_bytes * _ways);
+        _sets = _sets < 1 ? 1 : _sets;
+        _set_mask = (_sets & (_sets - 1)) == 0 ? _sets - 1 : 0;
+        _tags.assign(_sets * _ways, INVALID);
+        if (_policy == POLICY_PLRU) {
+            _tree.assign(_sets, 0);
+        } else {
+            _stamp.assign(_sets * _ways, 0);
+        }
+    }
+
+    // True on a hit; on a miss the line is allocated, and evicted tells
+    // whether a valid line made room for it
+    bool access(uint64_t line, bool& evicted) {
+        uint64_t set = _set_mask || _sets == 1 ? line & _set_mask : line % _sets;
+        uint64_t* tags = &_tags[set * _ways];
+        for (int w = 0; w < _ways; w++) {
+            if (tags[w] == line) {
+                touch(set, w);
+                return true;
+            }
+        }
+        int victim = findVictim(set, tags);
+        evicted = tags[victim] != INVALID;
+        tags[victim] = line;
+        touch(set, victim);
+        return false;
+    }
+};
+
+class CacheSim {
+private:
+    int _line_shift = 0;
+    long long _line_bytes;
+    std::vector<CacheLevelSim> _levels;
+    // _counts[ref * NUM_CACHE_LEVELS + level]
+    std::vector<cache_counts_t> _counts;
+
+public:
+    CacheSim(const cache_config_t& config, int num_refs) : _line_bytes(config.line_bytes) {
+        while ((1LL << _line_shift) < _line_bytes) {
+            _line_shift++;
+        }
+        for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+            _levels.emplace_back(config.capacity[c], config.line_bytes, config.ways[c],
+                                 config.policy);
+        }
+        _counts.resize((size_t)num_refs * NUM_CACHE_LEVELS);
+    }
+
+    // Accesses n of a batch: byte addresses and the references they come
+    // from
+    void simulate(const uint64_t* addrs, const int* refs, int n) {
+        bool pow2 = (1LL << _line_shift) == _line_bytes;
+        for (int i = 0; i < n; i++) {
+            uint64_t line = pow2 ? addrs[i] >> _line_shift : addrs[i] / _line_bytes;
+            cache_counts_t* counts = &_counts[(size_t)refs[i] * NUM_CACHE_LEVELS];
+            for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                bool evicted = false;
+                if (_levels[c].access(line, evicted)) {
+                    counts[c].hits++;
+                    break;
+                }
+                counts[c].misses++;
+                counts[c].evictions += evicted;
+            }
+        }
+    }
+
+    const cache_counts_t& getCounts(int ref, int level) {
+        return _counts[(size_t)ref * NUM_CACHE_LEVELS + level];
+    }
+};
+
+struct sim_ref_t {
+    std::string array;
+    bool write = false;
+    cache_counts_t counts[NUM_CACHE_LEVELS];
+};
+
+struct cache_sim_report_t {
+    bool valid = false;
+    std::string reason;
+    long long accesses = 0;
+    double seconds = 0;
+    std::vector<sim_ref_t> refs;
+    cache_counts_t counts[NUM_CACHE_LEVELS]; // all references
+};
+
+#endif
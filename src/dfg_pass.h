@@ -0,0 +1,1821 @@
+#ifndef DFG_PASS_H_
+#define DFG_PASS_H_
+#include <llvm/Pass.h>
+
+#include "llvm/IR/DerivedUser.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/Constant.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Operator.h>
+#include <llvm/IR/Use.h>
+#include <llvm/IR/User.h>
+#include <llvm/IR/Value.h>
+
+#include <llvm/Analysis/CFG.h>
+#include <llvm/Analysis/CallGraphSCCPass.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/LoopPass.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Transforms/Utils/LoopUtils.h>
+#include <llvm/Analysis/VectorUtils.h>
+//#include <llvm/DebugInfo.h>
+
+#include "dbg.h"
+#include "dfg_stats.h"
+#include "pattern.h"
+#include "loop_mem_pat_node.h"
+#include "loop_unroll_analysis.h"
+#include "parallel.h"
+#include "progress.h"
+#include "scc.h"
+#include <chrono>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+// #define DEBUG
+
+using namespace llvm;
+
+static cl::opt<std::string>
+    DFGStatsFile("dfg-stats", cl::value_desc("file"),
+                 cl::desc("Write per-function and per-loop statistics of "
+                          "DFGPass as JSON to <file>"));
+
+static cl::opt<bool>
+    DFGMemSummary("dfg-mem-summary",
+                  cl::desc("Print the memory high-water mark of DFGPass "
+                           "for each function to stderr"));
+
+static cl::opt<double> DFGProgress(
+    "dfg-progress", cl::init(0), cl::value_desc("seconds"),
+    cl::desc("Report the progress of dependence enumeration every <seconds> "
+             "(0 = off)"));
+
+static cl::opt<long long> DFGLoopMaxIters(
+    "dfg-loop-max-iters", cl::init(0), cl::value_desc("n"),
+    cl::desc("Assume a leaf loop nest dependent if enumerating it takes more "
+             "than <n> iterations (0 = unlimited)"));
+
+static cl::opt<double> DFGLoopTimeLimit(
+    "dfg-loop-time-limit", cl::init(0), cl::value_desc("seconds"),
+    cl::desc("Assume a leaf loop nest dependent if enumerating it takes more "
+             "than <seconds> (0 = unlimited)"));
+
+static cl::opt<long long> DFGFuncMaxIters(
+    "dfg-func-max-iters", cl::init(0), cl::value_desc("n"),
+    cl::desc("Maximum number of iterations enumerated per function; loops "
+             "beyond it are assumed dependent (0 = unlimited)"));
+
+static cl::opt<double> DFGFuncTimeLimit(
+    "dfg-func-time-limit", cl::init(0), cl::value_desc("seconds"),
+    cl::desc("Maximum analysis time per function; loops beyond it are "
+             "assumed dependent (0 = unlimited)"));
+
+static cl::opt<bool> DFGPrescreen(
+    "dfg-prescreen", cl::init(true),
+    cl::desc("Skip accesses and loops whose subscript ranges cannot overlap "
+             "before enumerating iterations (default on)"));
+
+static cl::opt<unsigned> DFGDenseTableLimit(
+    "dfg-dense-table-limit", cl::init(64), cl::value_desc("MiB"),
+    cl::desc("Memory for dense last-writer tables per leaf loop nest; arrays "
+             "beyond it use hash tables (0 = always hash, default 64)"));
+
+static cl::opt<bool> DFGWindowed(
+    "dfg-windowed", cl::init(true),
+    cl::desc("Evict hash table writes older than the largest dependence "
+             "distance along the outermost loop, when it can be derived "
+             "(default on)"));
+
+static cl::opt<int> DFGWindow(
+    "dfg-window", cl::init(-1), cl::value_desc("iterations"),
+    cl::desc("Outer loop iterations of writes to keep, trusted to cover every "
+             "dependence distance (-1 = derive, default)"));
+
+static cl::opt<std::string> DFGSpillDir(
+    "dfg-spill-dir", cl::value_desc("dir"),
+    cl::desc("Enumerate leaf loop nests whose hash write tables could exceed "
+             "-dfg-spill-threshold out of core, with temporary files in "
+             "<dir> (default: always in memory)"));
+
+static cl::opt<unsigned> DFGSpillThreshold(
+    "dfg-spill-threshold", cl::init(1024), cl::value_desc("MiB"),
+    cl::desc("Worst-case size of the in-memory write tables and pairs of a "
+             "leaf loop nest above which it is spilled (default 1024)"));
+
+static cl::opt<unsigned> DFGSpillPartitions(
+    "dfg-spill-partitions", cl::init(64),
+    cl::desc("Number of on-disk partitions of a spilled loop nest; each one "
+             "is joined in memory on its own (default 64)"));
+
+static cl::opt<bool> DFGSpecialize(
+    "dfg-specialize", cl::init(true),
+    cl::desc("Enumerate leaf loop nests of depth 1-4 whose accesses all have "
+             "1-3 affine subscripts with kernels specialized on depth and "
+             "subscript count (default on)"));
+
+static cl::opt<bool> DFGUseJIT(
+    "dfg-jit", cl::init(false),
+    cl::desc("Enumerate large leaf loop nests with native kernels compiled "
+             "by ORC, cached by nest structure"));
+
+static cl::opt<unsigned> DFGJITMinIters(
+    "dfg-jit-min-iters", cl::init(100000), cl::value_desc("iterations"),
+    cl::desc("Smallest iteration space worth compiling a kernel for "
+             "(default 100000)"));
+
+static cl::opt<bool> DFGUnrollMetadata(
+    "dfg-unroll-metadata", cl::init(true),
+    cl::desc("Attach the recommended llvm.loop.unroll.count and "
+             "llvm.loop.unroll_and_jam.count to leaf loops and the loops "
+             "around them, unless they already carry unroll metadata "
+             "(default on)"));
+
+static cl::opt<unsigned> DFGMaxUnroll(
+    "dfg-max-unroll", cl::init(8),
+    cl::desc("Largest recommended unroll factor of a leaf loop (default 8)"));
+
+static cl::opt<unsigned> DFGMaxUnrollAndJam(
+    "dfg-max-unroll-and-jam", cl::init(4),
+    cl::desc("Largest recommended unroll-and-jam factor (default 4)"));
+
+static cl::opt<std::string> DFGParallelLoops(
+    "dfg-parallel-loops", cl::value_desc("file"),
+    cl::desc("Write the loops without loop-carried memory dependences, with "
+             "their source locations, to <file> as JSON"));
+
+static cl::opt<bool> DFGParallelMetadata(
+    "dfg-parallel-metadata", cl::init(false),
+    cl::desc("Put the memory accesses of loops without loop-carried "
+             "dependences in an llvm.access.group and mark the loops "
+             "llvm.loop.parallel_accesses; arrays are told apart by name, so "
+             "only use it when differently named pointers do not alias"));
+
+static cl::opt<bool> DFGWavefront(
+    "dfg-wavefront", cl::init(false),
+    cl::desc("Print a wavefront schedule of every leaf loop nest none of "
+             "whose loops is parallel"));
+
+static cl::opt<unsigned> DFGL1Size(
+    "dfg-l1-size", cl::init(32), cl::value_desc("KiB"),
+    cl::desc("L1 data cache capacity the tile sizes are fitted to"));
+
+static cl::opt<unsigned> DFGL2Size(
+    "dfg-l2-size", cl::init(1024), cl::value_desc("KiB"),
+    cl::desc("L2 cache capacity the tile sizes are fitted to"));
+
+static cl::opt<unsigned> DFGLLCSize(
+    "dfg-llc-size", cl::init(32768), cl::value_desc("KiB"),
+    cl::desc("Last-level cache capacity the tile sizes are fitted to"));
+
+static cl::opt<unsigned> DFGCacheLine(
+    "dfg-cache-line", cl::init(64), cl::value_desc("bytes"),
+    cl::desc("Cache line size of the tiling advisor and the miss model"));
+
+static cl::opt<unsigned> DFGL1Ways(
+    "dfg-l1-ways", cl::init(8),
+    cl::desc("L1 associativity of the cache simulator"));
+
+static cl::opt<unsigned> DFGL2Ways(
+    "dfg-l2-ways", cl::init(16),
+    cl::desc("L2 associativity of the cache simulator"));
+
+static cl::opt<unsigned> DFGLLCWays(
+    "dfg-llc-ways", cl::init(16),
+    cl::desc("Last-level cache associativity of the cache simulator"));
+
+static cl::opt<cache_policy_t> DFGCachePolicy(
+    "dfg-cache-policy", cl::init(POLICY_LRU),
+    cl::desc("Replacement policy of the cache simulator"),
+    cl::values(clEnumValN(POLICY_LRU, "lru", "Least recently used"),
+               clEnumValN(POLICY_PLRU, "plru", "Tree pseudo-LRU")));
+
+static cl::opt<bool> DFGCacheSim(
+    "dfg-cache-sim", cl::init(false),
+    cl::desc("Replay the accesses of every leaf loop nest through the "
+             "simulated cache hierarchy"));
+
+// Cache hierarchy of the tiling advisor, the miss model and the simulator
+static cache_config_t getCacheConfig() {
+  cache_config_t cache;
+  cache.capacity[CACHE_L1] = (long long)DFGL1Size << 10;
+  cache.capacity[CACHE_L2] = (long long)DFGL2Size << 10;
+  cache.capacity[CACHE_LLC] = (long long)DFGLLCSize << 10;
+  cache.line_bytes = DFGCacheLine;
+  cache.ways[CACHE_L1] = DFGL1Ways;
+  cache.ways[CACHE_L2] = DFGL2Ways;
+  cache.ways[CACHE_LLC] = DFGLLCWays;
+  cache.policy = DFGCachePolicy;
+  return cache;
+}
+
+static cl::opt<std::string> DFGStrides(
+    "dfg-strides", cl::value_desc("file"),
+    cl::desc("Write the vectorizability of every loop of each leaf loop nest "
+             "and the accesses its innermost loop walks with a non-unit "
+             "stride to <file> as JSON"));
+
+static cl::opt<std::string> DFGTraffic(
+    "dfg-traffic", cl::value_desc("file"),
+    cl::desc("Write the leaf loop nests ranked by estimated memory traffic, "
+             "with their misses per iteration in each cache level, to "
+             "<file> as JSON"));
+
+static cl::opt<std::string> DFGTiling(
+    "dfg-tiling", cl::value_desc("file"),
+    cl::desc("Write the tiling legality and the tile sizes of every leaf "
+             "loop nest for each cache level to <file> as JSON"));
+
+static cl::opt<std::string> DFGInterchange(
+    "dfg-interchange", cl::value_desc("file"),
+    cl::desc("Write the best legal loop order of every perfect leaf loop "
+             "nest, with the cache traffic before and after, to <file> as "
+             "JSON"));
+
+static cl::opt<bool> DFGInterchangeMetadata(
+    "dfg-interchange-metadata", cl::init(false),
+    cl::desc("Attach the recommended loop order to the outermost loop of "
+             "each nest as dfg.loop.interchange.order metadata"));
+
+static cl::opt<std::string> DFGFusion(
+    "dfg-fusion", cl::value_desc("file"),
+    cl::desc("Write the pairs of adjacent sibling loop nests, ranked by the "
+             "memory traffic fusing them saves, with their legality, to "
+             "<file> as JSON"));
+
+static cl::opt<std::string> DFGStencils(
+    "dfg-stencils", cl::value_desc("file"),
+    cl::desc("Write a descriptor of every stencil leaf loop nest (offsets, "
+             "radius, shape, in place or not, points per update) to <file> "
+             "as JSON"));
+
+static cl::opt<std::string> DFGProgressFile(
+    "dfg-progress-file", cl::value_desc("file"),
+    cl::desc("Write -dfg-progress reports to <file> instead of stderr"));
+
+struct DFGPass : public ModulePass {
+public:
+  static char ID;
+
+  typedef std::pair<Value *, std::string> node;
+  typedef std::pair<node, node> edge;
+  typedef std::list<node> node_list;
+  typedef std::list<edge> edge_list;
+
+  std::map<Value *, std::string> variant_value;
+  std::vector<Loop *> loop_stack;
+  std::map<Loop *, LoopMemPatNode *> loop_node_map;
+  std::map<LoopMemPatNode *, Loop *> node_loop_map;
+  std::map<Instruction *, MemAcsPat *> acs_pat_map; // of each load and store
+
+  // std::error_code error;
+  edge_list inst_edges; // control flow
+  edge_list edges;      // data flow
+  node_list nodes;      // instruction
+
+  DFGStats stats;
+  FuncStats func_stats; // of the function being analyzed
+  ProgressReporter progress{DFGProgress, DFGProgressFile};
+  DFGJIT jit;
+  ParallelLoopReport parallel_report;
+  TilingReport tiling_report;
+  TrafficReport traffic_report;
+  StrideReport stride_report;
+  InterchangeReport interchange_report;
+  FusionReport fusion_report;
+  StencilReport stencil_report;
+
+  // Budget of the function being analyzed
+  std::chrono::steady_clock::time_point func_start;
+  long long func_iters = 0;
+
+  int num;
+  int func_id = 0;
+  DFGPass() : ModulePass(ID) { num = 0; }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    // AU.addRequired<CFG>();
+    AU.setPreservesCFG();
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addRequired<ScalarEvolutionWrapperPass>();
+    // AU.addRequired<RegionInfo>();
+    ModulePass::getAnalysisUsage(AU);
+  }
+
+  void dumpGraph(raw_fd_ostream &file, Function *F) {
+    // errs() << "Write\n";
+    file << "digraph \"DFG for'" + F->getName() + "\' function\" {\n";
+
+    // dump node
+    for (node_list::iterator node = nodes.begin(), node_end = nodes.end();
+         node != node_end; ++node) {
+      // errs() << "Node First:" << node->first << "\n";
+      // errs() << "Node Second:" << node-> second << "\n";
+      if (dyn_cast<Instruction>(node->first)) {
+        // file << "\tNode" << node->second << "[shape=record, label=\""
+        //      << *(node->first) << "\"];\n";
+        file << "\tNode" << node->first << "[shape=record, label=\""
+             << node->second.c_str() << "\"];\n";
+      } else {
+        file << "\tNode" << node->first << "[shape=record, label=\""
+             << node->second.c_str() << "\"];\n";
+      }
+    }
+
+    //  dump instruction edges
+#ifdef CFG
+    for (edge_list::iterator edge = inst_edges.begin(),
+                             edge_end = inst_edges.end();
+         edge != edge_end; ++edge) {
+      file << "\tNode" << edge->first.first << " -> Node" <<
+      edge->second.first << "\n";
+    }
+#endif
+
+    // dump data flow edges
+    file << "edge [color=red]"
+         << "\n";
+    for (edge_list::iterator edge = edges.begin(), edge_end = edges.end();
+         edge != edge_end; ++edge) {
+      file << "\tNode" << edge->first.first << " -> Node" << edge->second.first
+           << "\n";
+    }
+
+    file << "}\n";
+  }
+
+  // Convert instruction to string
+  std::string convertIns2Str(Instruction *ins) {
+    std::string temp_str;
+    raw_string_ostream os(temp_str);
+    ins->print(os);
+    return os.str();
+  }
+
+  template <class ForwardIt, class T>
+  ForwardIt remove(ForwardIt first, ForwardIt last, const T &value) {
+    first = std::find(first, last, value);
+    if (first != last)
+      for (ForwardIt i = first; ++i != last;)
+        if (!(*i == value))
+          *first++ = std::move(*i);
+    return first;
+  }
+
+  // If v is variable, then use the name.
+  // If v is instruction, then use the content.
+  std::string getValueName(Value *v) {
+    std::string temp_result = "#val";
+    if (!v) {
+      return "undefined";
+    }
+    if (v->getName().empty()) {
+      if (isa<ConstantInt>(v)) {
+        auto constant_v = dyn_cast<ConstantInt>(v);
+        temp_result = std::to_string(constant_v->getSExtValue());
+      } else {
+        temp_result += std::to_string(num);
+        num++;
+      }
+      // errs() << temp_result << "\n";
+    } else {
+      temp_result = v->getName().str();
+      // errs() << temp_result << "\n";
+    }
+    return temp_result;
+  }
+
+  // const MDNode *findVar(const Value *V, const Function *F) {
+  //   for (const_inst_iterator Iter = inst_begin(F), End = inst_end(F);
+  //        Iter != End; ++Iter) {
+  //     const Instruction *I = &*Iter;
+  //     if (const DbgDeclareInst *DbgDeclare = dyn_cast<DbgDeclareInst>(I)) {
+  //       if (DbgDeclare->getAddress() == V) {
+  //         return DbgDeclare->getVariable();
+  //         // return DbgDeclare->getOperand(1);
+  //       }
+  //     } else if (const DbgValueInst *DbgValue = dyn_cast<DbgValueInst>(I)) {
+  //       // errs() << "\nvalue:" <<DbgValue->getValue()  <<
+  //       // *(DbgValue->getValue()) << "\nV:" << V << *V<< "\n";
+  //       if (DbgValue->getValue() == V) {
+  //         return DbgValue->getVariable();
+  //         // return DbgValue->getOperand(1);
+  //       }
+  //     }
+  //   }
+  //   return nullptr;
+  // }
+
+  // std::string getDbgName(const Value *V, Function *F) {
+  //   // TODO handle globals as well
+
+  //   // const Function* F = findEnclosingFunc(V);
+  //   if (!F)
+  //     return V->getName().str();
+
+  //   const MDNode *Var = findVar(V, F);
+  //   if (!Var)
+  //     return "tmp";
+
+  //   // MDString * mds = dyn_cast_or_null<MDString>(Var->getOperand(0));
+  //   // //errs() << mds->getString() << '\n';
+  //   // if(mds->getString().str() != std::string("")) {
+  //   // return mds->getString().str();
+  //   // }else {
+  //   // 	return "##";
+  //   // }
+
+  //   auto var = dyn_cast<DIVariable>(Var);
+  //   // DIVariable *var(Var);
+
+  //   return var->getName().str();
+  // }
+
+  bool endWith(const std::string &str, const std::string &tail) {
+    return str.compare(str.size() - tail.size(), tail.size(), tail) == 0;
+  }
+
+  bool startWith(const std::string &str, const std::string &head) {
+    return str.compare(0, head.size(), head) == 0;
+  }
+
+  Value *getLoopIndvar(Loop *L, ScalarEvolution &SE) {
+    // auto phi = dyn_cast<PHINode>(L);
+    PHINode *indvar_phinode = L->getInductionVariable(SE);
+    // errs() << " phi: "<< indvar_phinode << '\n';
+    // Value *indvar = dyn_cast<Value>(indvar_phinode);
+    // return indvar;
+    return indvar_phinode;
+  }
+
+  bool isLoopIndVar(Value *v) {
+    auto iter = variant_value.find(v);
+    if (iter != variant_value.end()) {
+      return true;
+    }
+    return false;
+  }
+
+  // Loop bounds, or nullptr if the loop is not in canonical form
+  Value *getLoopInitVar(Loop *L, ScalarEvolution &SE) {
+    auto loop_bound = L->getBounds(SE);
+    if (!loop_bound) {
+      return nullptr;
+    }
+    return &(loop_bound->getInitialIVValue());
+  }
+
+  Value *getLoopStepVar(Loop *L, ScalarEvolution &SE) {
+    auto loop_bound = L->getBounds(SE);
+    if (!loop_bound) {
+      return nullptr;
+    }
+    return loop_bound->getStepValue();
+  }
+
+  Value *getLoopEndVar(Loop *L, ScalarEvolution &SE) {
+    auto loop_bound = L->getBounds(SE);
+    if (!loop_bound) {
+      return nullptr;
+    }
+    return &(loop_bound->getFinalIVValue());
+  }
+
+  static std::string budgetReason(const char *budget, const char *option,
+                                  double limit) {
+    std::ostringstream oss;
+    oss << budget << " budget exceeded (-" << option << "=" << limit << ")";
+    return oss.str();
+  }
+
+  double funcElapsed() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         func_start)
+        .count();
+  }
+
+  bool isFuncTimeExceeded() {
+    return DFGFuncTimeLimit > 0 && funcElapsed() >= DFGFuncTimeLimit;
+  }
+
+  PatNode *getGEPPattern(GetElementPtrInst *gep_inst, DataLayout *DL) {
+    GEPOperator *gep_op = dyn_cast<GEPOperator>(gep_inst);
+    Value *obj = gep_op->getPointerOperand();
+    // errs() << getValueName(obj) << '\n';
+
+    PatNode **patnode_array = new PatNode *[loop_stack.size()];
+
+    for (int l = loop_stack.size() - 1; l >= 0; l--) {
+      PatNode *gep_node = new PatNode(gep_inst, GEP_INST, getValueName(obj));
+      auto LL = loop_stack[l];
+      int num_operand = gep_inst->getNumOperands();
+      for (int i = 1; i < num_operand; i++) {
+        Value *idx = gep_inst->getOperand(i);
+        PatNode *op_node = getOpPattern(idx, LL);
+        gep_node->addChild(op_node);
+      }
+      // dumpPattern(gep_node, 0);
+      patnode_array[l] = gep_node;
+    }
+
+    // PatNode *gep_node1 = new PatNode(gep_inst, GEP_INST, getValueName(obj));
+
+    // // int num_operand = gep_inst->getNumOperands();
+    // for (int i = 1; i < num_operand; i++) {
+    //   Value *idx = gep_inst->getOperand(i);
+    //   PatNode *op_node = getOpPattern(idx, loop_stack[loop_stack.size() -
+    //   2]); gep_node1->addChild(op_node);
+    // }
+    // dumpPattern(gep_node1, 0);
+
+    // PatNode *gep_node2 = new PatNode(gep_inst, GEP_INST, getValueName(obj));
+
+    // // int num_operand = gep_inst->getNumOperands();
+    // for (int i = 1; i < num_operand; i++) {
+    //   Value *idx = gep_inst->getOperand(i);
+    //   PatNode *op_node = getOpPattern(idx, loop_stack[loop_stack.size() -
+    //   3]); gep_node2->addChild(op_node);
+    // }
+    // dumpPattern(gep_node2, 0);
+
+    return patnode_array[0];
+  }
+
+  PatNode *getBinaryOpPattern(BinaryOperator *bin_op, Loop *L) {
+    auto opcode = bin_op->getOpcode();
+    // errs() << opcode << '\n';
+    std::ostringstream oss;
+    switch (opcode) {
+    case 11:
+    case llvm::Instruction::Add:
+      oss << "+";
+      break;
+    case llvm::Instruction::Sub:
+      oss << '-';
+      break;
+    case llvm::Instruction::UDiv:
+      oss << '/';
+      break;
+    case llvm::Instruction::SDiv:
+      oss << '/';
+      break;
+    case llvm::Instruction::Mul:
+      oss << '*';
+      break;
+    case llvm::Instruction::FAdd:
+      oss << "+";
+      break;
+    case llvm::Instruction::FSub:
+      oss << '-';
+      break;
+    case llvm::Instruction::FDiv:
+      oss << '/';
+      break;
+    case llvm::Instruction::FMul:
+      oss << '*';
+      break;
+    case llvm::Instruction::Shl:
+      oss << "<<";
+      break;
+    case llvm::Instruction::LShr:
+      oss << ">>";
+      break;
+    default:
+      oss << "opcode: " << opcode;
+      break;
+    }
+
+    PatNode *bin_node = new PatNode(bin_op, BIN_OP, oss.str());
+#ifdef DEBUG
+    errs() << "Process binary op " << getValueName(bin_op) << ": bin op is "
+           << oss.str() << '\n';
+#endif
+
+    // Traverse all operands
+    int num_operands = bin_op->getNumOperands();
+    for (int i = 0; i < num_operands; i++) {
+      auto operand = bin_op->getOperand(i);
+      // auto operand = dyn_cast<Instruction>(operandi);
+#ifdef DEBUG
+      errs() << "  Process binary op operand " << getValueName(operand) << ": "
+             << getValueName(operand) << '\n';
+#endif
+      if (!L->isLoopInvariant(operand)) {
+#ifdef DEBUG
+        errs() << "  variant vars: " << getValueName(operand) << '\n';
+#endif
+        auto child = getOpPattern(dyn_cast<Instruction>(operand), L);
+        bin_node->addChild(child);
+      } else if (isa<ConstantInt>(operand)) {
+#ifdef DEBUG
+        errs() << "  invariant vars: " << getValueName(operand) << '\n';
+#endif
+        auto child = getOpPattern(operand, L);
+        bin_node->addChild(child);
+      } else {
+        PatNode *invar_var =
+            new PatNode(operand, CONSTANT, getValueName(operand));
+        bin_node->addChild(invar_var);
+      }
+    }
+
+    return bin_node;
+  }
+
+  void getSExtPattern(SExtInst *sext_inst) { 
+#ifdef DEBUG  
+    errs() << '=' << '\n'; 
+#endif
+  }
+  PatNode *getCastPattern(CastInst *sext_inst, Loop *L) {
+    PatNode *cast_node = new PatNode(sext_inst, CAST_INST,
+                                     getValueName(sext_inst->getOperand(0)));
+#ifdef DEBUG
+    errs() << "Process cast " << getValueName(sext_inst) << '\n';
+#endif
+    // traverse operand
+    auto operand0 = sext_inst->getOperand(0);
+    auto operand = dyn_cast<Instruction>(operand0);
+#ifdef DEBUG
+    errs() << "  Process cast operand " << getValueName(operand) << '\n';
+#endif
+    if (!L->isLoopInvariant(operand)) {
+#ifdef DEBUG
+      errs() << "  variant vars " << getValueName(operand) << '\n';
+#endif
+      auto child = getOpPattern(operand, L);
+
+      cast_node->addChild(child);
+    } else if (isa<ConstantInt>(operand)) {
+#ifdef DEBUG
+      errs() << "  invariant vars " << getValueName(operand) << '\n';
+#endif
+      auto child = getOpPattern(operand, L);
+
+      cast_node->addChild(child);
+    }
+
+    return cast_node;
+  }
+
+  PatNode *getConstPattern(ConstantInt *const_v) {
+#ifdef DEBUG
+    errs() << "Process constant " << getValueName(const_v)
+           << ": value = " << const_v->getSExtValue() << '\n';
+#endif
+    std::string temp_result = std::to_string(const_v->getSExtValue());
+    PatNode *const_node = new PatNode(const_v, CONSTANT, temp_result);
+    return const_node;
+  }
+
+  PatNode *getOpPattern(Instruction *curII, Loop *L) {
+    if (isLoopIndVar(curII)) {
+      PatNode *indvar_node =
+          new PatNode(curII, LOOP_IND_VAR, getValueName(curII));
+      return indvar_node;
+    } else if (isa<BinaryOperator>(curII)) {
+      auto bin_op = dyn_cast<BinaryOperator>(curII);
+      return getBinaryOpPattern(bin_op, L);
+    } else if (isa<CastInst>(curII)) {
+      auto sext_inst = dyn_cast<CastInst>(curII);
+      return getCastPattern(sext_inst, L);
+    } else if (isa<ConstantInt>(curII)) {
+      auto constant_v = dyn_cast<ConstantInt>(curII);
+      return getConstPattern(constant_v);
+    } else if (isa<PHINode>(curII)) {
+      PatNode *phi_node = new PatNode(curII, CONSTANT, getValueName(curII));
+      return phi_node;
+    }
+
+    return nullptr;
+  }
+
+  void handleLoop(Loop *L, LoopInfo &LI, DataLayout *DL, ScalarEvolution &SE,
+                  Function *F, LoopMemPatNode* parent_node) {
+    loop_stack.push_back(L);
+    Value *indvar = getLoopIndvar(L, SE);
+    Value *loop_init_var = getLoopInitVar(L, SE);
+    Value *loop_step_var = getLoopStepVar(L, SE);
+    Value *loop_end_var = getLoopEndVar(L, SE);
+    // getValueName(indvar, F)
+
+    if (indvar) {
+      variant_value.insert(make_pair(indvar, std::string("xx")));
+    }
+
+    std::string loop_ind_var_str = getValueName(indvar);
+    std::string loop_init_var_str = getValueName(loop_init_var);
+    std::string loop_step_var_str = getValueName(loop_step_var);
+    std::string loop_end_var_str = getValueName(loop_end_var);
+    // dbg(loop_init_var_str);
+    // dbg(loop_step_var_str);
+    // dbg(loop_end_var_str);
+    PatNode* loop_init_var_pat_node =
+        loop_init_var ? getOpPattern(loop_init_var, L) : nullptr;
+    PatNode* loop_step_var_pat_node =
+        loop_step_var ? getOpPattern(loop_step_var, L) : nullptr;
+    PatNode* loop_end_var_pat_node =
+        loop_end_var ? getOpPattern(loop_end_var, L) : nullptr;
+
+
+    // LoopPat* loop_pat = new LoopPat(loop_ind_var_str);
+    LoopPat* loop_pat = new LoopPat(loop_ind_var_str, loop_init_var_pat_node, loop_end_var_pat_node, loop_step_var_pat_node);
+    LoopMemPatNode* loop_node = new LoopMemPatNode(LOOP_NODE, loop_pat);
+    parent_node->addChild(loop_node);
+    loop_node_map[L] = loop_node;
+    node_loop_map[loop_node] = L;
+
+    // Out of time: keep the loop, without its accesses and inner loops
+    if (isFuncTimeExceeded()) {
+      loop_node->setAssumedDependent(budgetReason(
+          "function time", "dfg-func-time-limit", DFGFuncTimeLimit));
+      loop_stack.pop_back();
+      return;
+    }
+
+    // dbg(indvar); 
+    // errs() << "Loop index var:" << getValueName(indvar) << "\n\n";
+
+    for (Loop::block_iterator BB = L->block_begin(), BEnd = L->block_end();
+         BB != BEnd; ++BB) {
+      BasicBlock *curBB = *BB;
+      // check if bb belongs to L or inner loop, traverse the BB of Loop
+      // itself.
+      if (L != LI.getLoopFor(curBB)) {
+        continue;
+      }
+      for (BasicBlock::iterator II = curBB->begin(), IEnd = curBB->end();
+           II != IEnd; ++II) {
+
+        Instruction *curII = &*II;
+
+        if (isa<GetElementPtrInst>(curII)) {
+          // errs() << *(curII) << "\n";
+          GetElementPtrInst *gepinst = dyn_cast<GetElementPtrInst>(curII);
+
+          //  auto user = dyn_cast<User>(curII);
+          auto gep_pat = getGEPPattern(gepinst, DL);
+          func_stats.loops[loop_node].num_geps++;
+
+          auto val = dyn_cast<Value>(curII);
+          // auto use = dyn_cast<User>(val);
+          auto users = val->users();
+          
+          for(auto user: users) {
+            Instruction *next = dyn_cast<Instruction>(user);
+            int mode;
+            if (isa<LoadInst>(next)) {
+              mode = READ;
+            } else if (isa<StoreInst>(next)) {
+              mode = WRITE;
+            } else {
+              mode = 0;
+            }
+            // dbg(mode);
+            MemAcsPat* mem_acs_pat = new MemAcsPat(gep_pat, mode);
+            LoopMemPatNode* mem_acs_node = new LoopMemPatNode(MEM_ACS_NODE, mem_acs_pat);
+            loop_node->addChild(mem_acs_node);
+            if (mode) {
+              acs_pat_map[next] = mem_acs_pat;
+            }
+          }
+          
+          
+
+          // // old version for simple pattern A[i]
+          // GEPOperator *gepop = dyn_cast<GEPOperator>(curII);
+          // Value *obj = gepop->getPointerOperand();
+          // Value *idx = gepinst->getOperand(1);
+          // errs() << getOriginalName(obj, F) << "[" << getOriginalName(idx, F)
+          //        << "]" << '\n';
+        }
+      }
+    }
+
+    // traverse the inner Loops by recursive method
+    std::vector<Loop *> subLoops = L->getSubLoops();
+    Loop::iterator SL, SLE;
+    for (SL = subLoops.begin(), SLE = subLoops.end(); SL != SLE; ++SL) {
+      handleLoop(*SL, LI, DL, SE, F, loop_node);
+    }
+    loop_stack.pop_back();
+  }
+
+  // Data-flow and control-flow edges of the instructions of L and its inner
+  // loops
+  void buildLoopDFG(Loop *L, LoopInfo &LI) {
+    for (Loop::block_iterator BB = L->block_begin(), BEnd = L->block_end();
+         BB != BEnd; ++BB) {
+      BasicBlock *curBB = *BB;
+      if (L != LI.getLoopFor(curBB)) {
+        continue;
+      }
+      for (BasicBlock::iterator II = curBB->begin(), IEnd = curBB->end();
+           II != IEnd; ++II) {
+        Instruction *curII = &*II;
+        switch (curII->getOpcode()) {
+        // Load and store instruction
+        case llvm::Instruction::Load: {
+          LoadInst *linst = dyn_cast<LoadInst>(curII);
+          Value *loadValPtr = linst->getPointerOperand();
+          edges.push_back(edge(node(loadValPtr, getValueName(loadValPtr)),
+                               node(curII, getValueName(curII))));
+          break;
+        }
+        case llvm::Instruction::Store: {
+          StoreInst *sinst = dyn_cast<StoreInst>(curII);
+          Value *storeValPtr = sinst->getPointerOperand();
+          Value *storeVal = sinst->getValueOperand();
+          edges.push_back(edge(node(storeVal, getValueName(storeVal)),
+                               node(curII, getValueName(curII))));
+          edges.push_back(edge(node(curII, getValueName(curII)),
+                               node(storeValPtr, getValueName(storeValPtr))));
+          break;
+        }
+        default: {
+          for (Instruction::op_iterator op = curII->op_begin(),
+                                        opEnd = curII->op_end();
+               op != opEnd; ++op) {
+            Instruction *tempIns;
+            if (dyn_cast<Instruction>(*op)) {
+              edges.push_back(edge(node(op->get(), getValueName(op->get())),
+                                   node(curII, getValueName(curII))));
+            }
+          }
+          break;
+        }
+        }
+        BasicBlock::iterator next = II;
+        nodes.push_back(node(curII, getValueName(curII)));
+        ++next;
+        if (next != IEnd) {
+          inst_edges.push_back(edge(node(curII, getValueName(curII)),
+                                    node(&*next, getValueName(&*next))));
+        }
+      }
+
+      Instruction *terminator = curBB->getTerminator();
+      for (BasicBlock *sucBB : successors(curBB)) {
+        Instruction *first = &*(sucBB->begin());
+        inst_edges.push_back(edge(node(terminator, getValueName(terminator)),
+                                  node(first, getValueName(first))));
+      }
+    }
+
+
+    for (Loop *SL : L->getSubLoops()) {
+      buildLoopDFG(SL, LI);
+    }
+  }
+
+  Loop *getCommonLoop(Loop *a, Loop *b) {
+    while (a && !a->contains(b)) {
+      a = a->getParentLoop();
+    }
+    return a;
+  }
+
+  // Whether a loop around both store and load may carry a flow of values
+  // from the first to the second, judging from the separable subscripts of
+  // their patterns. A location that is not an array element is the same in
+  // every iteration.
+  bool isCarriedFlow(StoreInst *store, LoadInst *load, LoopInfo &LI,
+                     const std::map<std::string, Interval> &ranges) {
+    Loop *loop = getCommonLoop(LI.getLoopFor(store->getParent()),
+                               LI.getLoopFor(load->getParent()));
+    if (!loop) {
+      return false;
+    }
+    auto store_pat = acs_pat_map.find(store);
+    auto load_pat = acs_pat_map.find(load);
+    if (store_pat == acs_pat_map.end() || load_pat == acs_pat_map.end()) {
+      return store->getPointerOperand() == load->getPointerOperand();
+    }
+    std::vector<LoopMemPatNode *> chain;
+    for (Loop *L = loop; L; L = L->getParentLoop()) {
+      auto iter = loop_node_map.find(L);
+      if (iter == loop_node_map.end()) {
+        return true;
+      }
+      chain.insert(chain.begin(), iter->second);
+    }
+    std::vector<std::string> ind_vars;
+    std::vector<int> step;
+    std::vector<long long> trip;
+    getNestBounds(chain, ind_vars, step, trip);
+    for (size_t k = 1; k <= chain.size(); k++) {
+      if (mayCarryDependence(
+              store_pat->second->getPatNode(), load_pat->second->getPatNode(),
+              std::vector<std::string>(ind_vars.begin(), ind_vars.begin() + k),
+              std::vector<int>(step.begin(), step.begin() + k),
+              std::vector<long long>(trip.begin(), trip.begin() + k),
+              ranges)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Find the cycles (strongly connected components) of the data-flow graph
+  // and attach each one to the innermost loop containing all of its
+  // instructions. Memory only closes a cycle through a flow from a store to
+  // a load that a loop may carry: the edges through the pointer operands of
+  // loads and stores are left out, or any load-modify-store of one element
+  // would be a cycle.
+  void recurrenceAnalysis(LoopInfo &LI) {
+    std::unordered_map<Value *, int> value_id;
+    std::vector<Value *> values;
+    std::vector<std::pair<int, int>> dfg_edges;
+    auto getId = [&](Value *v) {
+      auto iter = value_id.find(v);
+      if (iter != value_id.end()) {
+        return iter->second;
+      }
+      int id = values.size();
+      value_id[v] = id;
+      values.push_back(v);
+      return id;
+    };
+    std::vector<StoreInst *> stores;
+    std::map<std::string, std::vector<LoadInst *>> loads; // by array
+    auto getLocation = [&](Instruction *inst, Value *ptr) {
+      auto iter = acs_pat_map.find(inst);
+      return iter != acs_pat_map.end()
+                 ? iter->second->getPatNode()->getValueName()
+                 : getValueName(ptr);
+    };
+    for (auto &e : edges) {
+      if (auto store = dyn_cast<StoreInst>(e.first.first)) {
+        stores.push_back(store);
+        continue;
+      }
+      if (auto load = dyn_cast<LoadInst>(e.second.first)) {
+        loads[getLocation(load, load->getPointerOperand())].push_back(load);
+        continue;
+      }
+      int from = getId(e.first.first);
+      int to = getId(e.second.first);
+      dfg_edges.push_back(std::make_pair(from, to));
+    }
+    std::map<std::string, Interval> ranges;
+    std::vector<LoopMemPatNode *> all_loops;
+    for (auto &entry : loop_node_map) {
+      all_loops.push_back(entry.second);
+    }
+    addIndVarRanges(all_loops, ranges);
+    for (auto store : stores) {
+      auto iter = loads.find(getLocation(store, store->getPointerOperand()));
+      if (iter == loads.end()) {
+        continue;
+      }
+      for (auto load : iter->second) {
+        if (isCarriedFlow(store, load, LI, ranges)) {
+          dfg_edges.push_back(std::make_pair(getId(store), getId(load)));
+        }
+      }
+    }
+
+    SCCAnalysis scc(values.size(), dfg_edges);
+    scc.run();
+
+    int num_scc = scc.getNumSCC();
+    std::vector<std::vector<Value *>> members(num_scc);
+    for (int v = 0; v < (int)values.size(); v++) {
+      int id = scc.getSCCId(v);
+      if (scc.isCyclic(id)) {
+        members[id].push_back(values[v]);
+      }
+    }
+
+    // Classify cycles
+    std::vector<std::string> kinds(num_scc);
+    std::vector<int> weights(num_scc, 0);
+    for (int id = 0; id < num_scc; id++) {
+      if (members[id].empty()) {
+        continue;
+      }
+      int num_phis = 0, num_ind_phis = 0, num_loads = 0, num_stores = 0;
+      for (auto v : members[id]) {
+        if (isa<PHINode>(v)) {
+          num_phis++;
+          if (isLoopIndVar(v)) {
+            num_ind_phis++;
+          }
+        } else if (isa<LoadInst>(v)) {
+          num_loads++;
+        } else if (isa<StoreInst>(v)) {
+          num_stores++;
+        }
+      }
+      if (num_stores > 0) {
+        kinds[id] = "memory";
+      } else if (num_phis > 0 && num_phis == num_ind_phis && num_loads == 0) {
+        kinds[id] = "induction";
+      } else if (num_phis > 0) {
+        kinds[id] = "reduction";
+      } else {
+        kinds[id] = "other";
+      }
+      weights[id] = (kinds[id] == "induction") ? 0 : 1;
+    }
+
+    // Condensation DAG: longest chain of (non-induction) recurrences
+    std::vector<int> path_len = scc.getLongestPath(weights);
+
+    for (int id = 0; id < num_scc; id++) {
+      if (members[id].empty()) {
+        continue;
+      }
+      int num_phis = 0, num_loads = 0, num_stores = 0, num_ops = 0;
+      Loop *loop = nullptr;
+      bool first = true;
+      for (auto v : members[id]) {
+        num_phis += isa<PHINode>(v);
+        num_loads += isa<LoadInst>(v);
+        num_stores += isa<StoreInst>(v);
+        num_ops += isa<BinaryOperator>(v) || isa<CmpInst>(v);
+        if (auto inst = dyn_cast<Instruction>(v)) {
+          Loop *inst_loop = LI.getLoopFor(inst->getParent());
+          loop = first ? inst_loop : getCommonLoop(loop, inst_loop);
+          first = false;
+        }
+      }
+      auto iter = loop_node_map.find(loop);
+      if (!loop || iter == loop_node_map.end()) {
+        continue;
+      }
+      RecurrencePat *rec = new RecurrencePat(
+          kinds[id], members[id].size(), num_phis, num_loads, num_stores,
+          num_ops, path_len[id]);
+      iter->second->addRecurrence(rec);
+    }
+  }
+
+  // The tighter of the per-loop and the remaining per-function budget. A
+  // loop left with no budget at all is marked assumed dependent.
+  void setLoopBudget(LoopMemPatNode *n, LoopUnrollAnalysis *analysis) {
+    if (n->isAssumedDependent()) {
+      return;
+    }
+    long long max_iters = DFGLoopMaxIters;
+    std::string iters_reason = budgetReason(
+        "loop iteration", "dfg-loop-max-iters", DFGLoopMaxIters);
+    if (DFGFuncMaxIters > 0) {
+      long long remaining = DFGFuncMaxIters - func_iters;
+      std::string reason = budgetReason(
+          "function iteration", "dfg-func-max-iters", DFGFuncMaxIters);
+      if (remaining <= 0) {
+        n->setAssumedDependent(reason);
+        return;
+      }
+      if (max_iters <= 0 || remaining < max_iters) {
+        max_iters = remaining;
+        iters_reason = reason;
+      }
+    }
+    if (max_iters > 0) {
+      analysis->setIterBudget(max_iters, iters_reason);
+    }
+
+    double time_limit = DFGLoopTimeLimit;
+    std::string time_reason =
+        budgetReason("loop time", "dfg-loop-time-limit", DFGLoopTimeLimit);
+    if (DFGFuncTimeLimit > 0) {
+      double remaining = DFGFuncTimeLimit - funcElapsed();
+      std::string reason = budgetReason("function time", "dfg-func-time-limit",
+                                        DFGFuncTimeLimit);
+      if (remaining <= 0) {
+        n->setAssumedDependent(reason);
+        return;
+      }
+      if (time_limit <= 0 || remaining < time_limit) {
+        time_limit = remaining;
+        time_reason = reason;
+      }
+    }
+    if (time_limit > 0) {
+      analysis->setDeadline(
+          std::chrono::steady_clock::now() +
+              std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(time_limit)),
+          time_reason);
+    }
+  }
+
+  // Write the unroll factors into the IR for the unroll passes; user
+  // pragmas win. Returns whether any metadata was added.
+  bool addUnrollMetadata(LoopMemPatNode *n, const unroll_advice_t &advice) {
+    auto iter = node_loop_map.find(n);
+    if (!advice.valid || iter == node_loop_map.end()) {
+      return false;
+    }
+    bool added = false;
+    Loop *L = iter->second;
+    if (advice.unroll > 1 && hasUnrollTransformation(L) == TM_Unspecified) {
+      addStringMetadataToLoop(L, "llvm.loop.unroll.count", advice.unroll);
+      added = true;
+    }
+    // Unroll-and-jam only handles a loop with a single inner loop, and its
+    // legality only covers the accesses the patterns describe
+    Loop *outer = L->getParentLoop();
+    if (advice.unroll_and_jam > 1 && outer &&
+        outer->getSubLoops().size() == 1 && !hasUnanalyzedAccess(outer) &&
+        hasUnrollAndJamTransformation(outer) == TM_Unspecified) {
+      addStringMetadataToLoop(outer, "llvm.loop.unroll_and_jam.count",
+                              advice.unroll_and_jam);
+      added = true;
+    }
+    return added;
+  }
+
+  void loopDepAnalysis(LoopMemPatNode* n) {
+    auto type = n->getType();
+    auto has_loop_child = n->hasLoopChild();
+    if(type == LOOP_NODE && has_loop_child == false) {
+      LoopUnrollAnalysis* loop_unroll_analysis = new LoopUnrollAnalysis(n);
+      loop_unroll_analysis->setProgress(&progress);
+      loop_unroll_analysis->setPrescreen(DFGPrescreen);
+      loop_unroll_analysis->setDenseLimit((long long)DFGDenseTableLimit << 20);
+      loop_unroll_analysis->setWindow(DFGWindowed, DFGWindow);
+      loop_unroll_analysis->setSpecialize(DFGSpecialize);
+      if (DFGUseJIT) {
+        loop_unroll_analysis->setJIT(&jit, DFGJITMinIters);
+      }
+      loop_unroll_analysis->setSpill(DFGSpillDir,
+                                     (long long)DFGSpillThreshold << 20,
+                                     DFGSpillPartitions);
+      setLoopBudget(n, loop_unroll_analysis);
+      LoopStats& loop_stats = func_stats.loops[n];
+      {
+        PhaseRegion region(stats.getTimer(PHASE_DEPENDENCE),
+                           loop_stats.dep_time);
+        loop_unroll_analysis->checkDependence();
+      }
+      if (loop_unroll_analysis->isAssumedDependent()) {
+        n->setAssumedDependent(loop_unroll_analysis->getAssumedDepReason());
+      }
+      func_iters += loop_unroll_analysis->getNumIters();
+      func_stats.time[PHASE_DEPENDENCE] += loop_stats.dep_time;
+      loop_stats.num_iters = loop_unroll_analysis->getNumIters();
+      loop_stats.num_acs = loop_unroll_analysis->getNumAccesses();
+      loop_stats.num_pairs = loop_unroll_analysis->getNumPairs();
+      loop_stats.num_skipped_acs = loop_unroll_analysis->getNumSkippedAccesses();
+      loop_stats.skipped = loop_unroll_analysis->isSkippedLoop();
+      loop_stats.num_dense_tables = loop_unroll_analysis->getNumDenseTables();
+      loop_stats.window = loop_unroll_analysis->getWindow();
+      loop_stats.spill_bytes = loop_unroll_analysis->getSpillBytes();
+      loop_stats.jit = loop_unroll_analysis->isJITted();
+      loop_stats.specialized = loop_unroll_analysis->isSpecialized();
+      {
+        PhaseRegion region(stats.getTimer(PHASE_UNROLL),
+                           func_stats.time[PHASE_UNROLL]);
+        loop_stats.unroll = loop_unroll_analysis->adviseUnroll(
+            DFGMaxUnroll, DFGMaxUnrollAndJam);
+        if (DFGUnrollMetadata) {
+          loop_stats.unroll_metadata = addUnrollMetadata(n, loop_stats.unroll);
+        }
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_PARALLEL),
+                           func_stats.time[PHASE_PARALLEL]);
+        loop_stats.flow_carried = loop_unroll_analysis->getCarriedLevels();
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_WAVEFRONT),
+                           func_stats.time[PHASE_WAVEFRONT]);
+        loop_stats.wavefront = loop_unroll_analysis->scheduleWavefront();
+      }
+      cache_config_t cache = getCacheConfig();
+      {
+        PhaseRegion region(stats.getTimer(PHASE_TILING),
+                           func_stats.time[PHASE_TILING]);
+        loop_stats.tiling = loop_unroll_analysis->adviseTiling(cache);
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_STENCIL),
+                           func_stats.time[PHASE_STENCIL]);
+        loop_stats.stencil = loop_unroll_analysis->recognizeStencil();
+        Loop *nest_loop =
+            node_loop_map[loop_unroll_analysis->getLoopNest().front()];
+        if (loop_stats.stencil.valid && hasUnanalyzedAccess(nest_loop)) {
+          loop_stats.stencil = stencil_t();
+          loop_stats.stencil.reason = "unanalyzed memory access";
+        }
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_REUSE),
+                           func_stats.time[PHASE_REUSE]);
+        loop_stats.reuse = loop_unroll_analysis->estimateReuse(cache);
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_STRIDES),
+                           func_stats.time[PHASE_STRIDES]);
+        loop_stats.strides = loop_unroll_analysis->classifyStrides();
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_INTERCHANGE),
+                           func_stats.time[PHASE_INTERCHANGE]);
+        loop_stats.interchange = loop_unroll_analysis->adviseInterchange(cache);
+      }
+      if (DFGCacheSim) {
+        PhaseRegion region(stats.getTimer(PHASE_CACHE_SIM),
+                           func_stats.time[PHASE_CACHE_SIM]);
+        loop_stats.cache_sim = loop_unroll_analysis->simulateCache(cache);
+      }
+      if (tiling_report.isOpen() || traffic_report.isOpen() ||
+          stencil_report.isOpen()) {
+        std::vector<std::string> ind_vars;
+        for (auto node : loop_unroll_analysis->getLoopNest()) {
+          ind_vars.push_back(node->getLoopPat()->getIndVar());
+        }
+        Loop *outer = node_loop_map[loop_unroll_analysis->getLoopNest().front()];
+        DebugLoc loc = outer ? outer->getStartLoc() : DebugLoc();
+        tiling_report.write(func_stats.name, ind_vars, loc, loop_stats.tiling);
+        traffic_report.add(func_stats.name, ind_vars, loc, loop_stats.reuse);
+        stencil_report.write(func_stats.name, ind_vars, loc, loop_stats.stencil);
+      }
+      loop_unroll_analysis->getMemUsage(loop_stats.mem);
+      if (!func_stats.peak_loop ||
+          loop_stats.mem.getTotalBytes() >
+              func_stats.loops[func_stats.peak_loop].mem.getTotalBytes()) {
+        func_stats.peak_loop = n;
+      }
+      {
+        PhaseRegion region(stats.getTimer(PHASE_OUTPUT),
+                           func_stats.time[PHASE_OUTPUT]);
+        loop_unroll_analysis->dumpDependence();
+      }
+      delete loop_unroll_analysis;
+    }
+    
+    auto children = n->getChildren();
+    for(auto child: children) {
+      loopDepAnalysis(child);
+    }
+
+  }
+
+  // Memory accesses of the loop that are not loads or stores through a GEP
+  // of the loop, which the patterns do not describe
+  bool hasUnanalyzedAccess(Loop *L) {
+    for (BasicBlock *BB : L->blocks()) {
+      for (Instruction &I : *BB) {
+        if (!I.mayReadOrWriteMemory()) {
+          continue;
+        }
+        Value *ptr = getLoadStorePointerOperand(&I);
+        auto gep = ptr ? dyn_cast<GetElementPtrInst>(ptr) : nullptr;
+        if (!gep || !L->contains(gep)) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  void collectSubtree(LoopMemPatNode *n, std::vector<LoopMemPatNode *> &loops,
+                      std::vector<MemAcsPat *> &refs) {
+    for (auto child : n->getChildren()) {
+      if (child->getType() == MEM_ACS_NODE) {
+        refs.push_back(child->getMemAcsPat());
+      } else if (child->getType() == LOOP_NODE) {
+        loops.push_back(child);
+        collectSubtree(child, loops, refs);
+      }
+    }
+  }
+
+  // Ranges of the ind vars of the loops with constant bounds
+  void addIndVarRanges(const std::vector<LoopMemPatNode *> &loops,
+                       std::map<std::string, Interval> &ranges) {
+    for (auto loop : loops) {
+      auto loop_pat = loop->getLoopPat();
+      if (loop_pat && loop_pat->hasConstantBounds()) {
+        ranges[loop_pat->getIndVar()] =
+            getIndVarRange(loop_pat->getStartVal(), loop_pat->getEndVal(),
+                           loop_pat->getStepVal());
+      }
+    }
+  }
+
+  // Ind vars, steps and trip counts of the loops of chain, from the
+  // outermost one. Loops without constant bounds get step 1 and trip 0
+  // (unknown).
+  void getNestBounds(const std::vector<LoopMemPatNode *> &chain,
+                     std::vector<std::string> &ind_vars, std::vector<int> &step,
+                     std::vector<long long> &trip) {
+    for (auto loop : chain) {
+      auto loop_pat = loop->getLoopPat();
+      ind_vars.push_back(loop_pat->getIndVar());
+      bool known = loop_pat->hasConstantBounds() && loop_pat->getStepVal() > 0;
+      step.push_back(known ? loop_pat->getStepVal() : 1);
+      trip.push_back(known ? std::max(0, (loop_pat->getEndVal() -
+                                          loop_pat->getStartVal() +
+                                          loop_pat->getStepVal() - 1) /
+                                             loop_pat->getStepVal())
+                           : 0);
+    }
+  }
+
+  // Whether the last loop of chain (its enclosing loops, from the outermost
+  // one) carries no memory dependence: no enumerated dependence of its
+  // leaf nests is carried at its level, and no pair of references with a
+  // write may be either
+  bool isLoopParallel(std::vector<LoopMemPatNode *> &chain) {
+    LoopMemPatNode *n = chain.back();
+    auto iter = node_loop_map.find(n);
+    if (iter == node_loop_map.end() || hasUnanalyzedAccess(iter->second)) {
+      return false;
+    }
+    std::vector<LoopMemPatNode *> loops = {n};
+    std::vector<MemAcsPat *> refs;
+    collectSubtree(n, loops, refs);
+    int level = chain.size() - 1;
+    for (auto loop : loops) {
+      // Loops cut short by a budget may be missing their accesses
+      if (loop->isAssumedDependent()) {
+        return false;
+      }
+      auto &carried = func_stats.loops[loop].flow_carried;
+      if (level < (int)carried.size() && carried[level]) {
+        return false;
+      }
+    }
+
+    std::vector<std::string> ind_vars;
+    std::vector<int> step;
+    std::vector<long long> trip;
+    std::map<std::string, Interval> ranges;
+    loops.insert(loops.end(), chain.begin(), chain.end() - 1);
+    addIndVarRanges(loops, ranges);
+    getNestBounds(chain, ind_vars, step, trip);
+
+    for (size_t i = 0; i < refs.size(); i++) {
+      if (refs[i]->getAccessMode() != READ && refs[i]->getAccessMode() != WRITE) {
+        return false;
+      }
+      for (size_t j = i; j < refs.size(); j++) {
+        if (refs[i]->getAccessMode() != WRITE &&
+            refs[j]->getAccessMode() != WRITE) {
+          continue;
+        }
+        if (mayCarryDependence(refs[i]->getPatNode(), refs[j]->getPatNode(),
+                               ind_vars, step, trip, ranges)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Put the memory accesses of L in a new access group and declare them
+  // free of dependences carried by L
+  void addParallelMetadata(Loop *L) {
+    LLVMContext &ctx = L->getHeader()->getContext();
+    MDNode *group = MDNode::getDistinct(ctx, {});
+    for (BasicBlock *BB : L->blocks()) {
+      for (Instruction &I : *BB) {
+        if (!I.mayReadOrWriteMemory()) {
+          continue;
+        }
+        MDNode *groups = I.getMetadata(LLVMContext::MD_access_group);
+        I.setMetadata(LLVMContext::MD_access_group,
+                      groups ? uniteAccessGroups(groups, group) : group);
+      }
+    }
+    SmallVector<Metadata *, 4> mds = {nullptr};
+    if (MDNode *loop_id = L->getLoopID()) {
+      for (unsigned i = 1; i < loop_id->getNumOperands(); i++) {
+        mds.push_back(loop_id->getOperand(i));
+      }
+    }
+    mds.push_back(MDNode::get(
+        ctx, {MDString::get(ctx, "llvm.loop.parallel_accesses"), group}));
+    MDNode *loop_id = MDNode::getDistinct(ctx, mds);
+    loop_id->replaceOperandWith(0, loop_id);
+    L->setLoopID(loop_id);
+  }
+
+  // Keep the wavefront schedule of the leaf nest ending chain only if no
+  // loop of the nest is parallel, and the nest is perfect
+  void waveFrontAnalysis(std::vector<LoopMemPatNode *> &chain) {
+    PhaseRegion region(stats.getTimer(PHASE_WAVEFRONT),
+                       func_stats.time[PHASE_WAVEFRONT]);
+    wavefront_t &wf = func_stats.loops[chain.back()].wavefront;
+    for (auto loop : chain) {
+      if (func_stats.loops[loop].parallel) {
+        wf = wavefront_t();
+        return;
+      }
+    }
+    if (!wf.valid) {
+      return;
+    }
+    for (size_t k = 0; k + 1 < chain.size(); k++) {
+      if (chain[k]->getChildren().size() != 1) {
+        wf = wavefront_t();
+        wf.reason = "imperfect nest";
+        return;
+      }
+    }
+    if (hasUnanalyzedAccess(node_loop_map[chain.front()])) {
+      wf = wavefront_t();
+      wf.reason = "unanalyzed memory access";
+      return;
+    }
+    if (!DFGWavefront) {
+      return;
+    }
+    std::cout << "Wavefront schedule of " << func_stats.name << ", loop nest";
+    for (auto loop : chain) {
+      std::cout << " " << loop->getLoopPat()->getIndVar();
+    }
+    std::cout << ": hyperplane (";
+    for (size_t k = 0; k < wf.hyperplane.size(); k++) {
+      std::cout << (k ? ", " : "") << wf.hyperplane[k];
+    }
+    std::cout << "), " << wf.num_wavefronts << " wavefronts, parallelism "
+              << wf.max_parallelism << " max, " << wf.avg_parallelism
+              << " average\n";
+    for (auto &line : wf.schedule) {
+      std::cout << "  " << line << "\n";
+    }
+  }
+
+  // Vectorizability of each loop of the leaf nest ending chain, were it
+  // innermost, from the strides of the accesses and its parallelism
+  void vectorAnalysis(std::vector<LoopMemPatNode *> &chain) {
+    PhaseRegion region(stats.getTimer(PHASE_STRIDES),
+                       func_stats.time[PHASE_STRIDES]);
+    LoopStats &loop_stats = func_stats.loops[chain.back()];
+    if (loop_stats.strides.empty() ||
+        loop_stats.strides.front().cls.size() != chain.size()) {
+      return;
+    }
+    std::vector<std::string> ind_vars;
+    for (size_t k = 0; k < chain.size(); k++) {
+      ind_vars.push_back(chain[k]->getLoopPat()->getIndVar());
+      loop_stats.vectorization.push_back(getVectorVerdict(
+          loop_stats.strides, k, func_stats.loops[chain[k]].parallel));
+    }
+    Loop *outer = node_loop_map[chain.front()];
+    stride_report.write(func_stats.name, ind_vars,
+                        outer ? outer->getStartLoc() : DebugLoc(),
+                        loop_stats.vectorization, loop_stats.strides);
+  }
+
+  // Record the loop order recommended for the leaf nest ending chain on its
+  // outermost loop: the original level of each loop, from the outermost
+  void addInterchangeMetadata(Loop *L, const std::vector<int> &order) {
+    LLVMContext &ctx = L->getHeader()->getContext();
+    SmallVector<Metadata *, 4> mds = {nullptr};
+    if (MDNode *loop_id = L->getLoopID()) {
+      for (unsigned i = 1; i < loop_id->getNumOperands(); i++) {
+        mds.push_back(loop_id->getOperand(i));
+      }
+    }
+    SmallVector<Metadata *, 4> ops = {
+        MDString::get(ctx, "dfg.loop.interchange.order")};
+    for (int k : order) {
+      ops.push_back(ConstantAsMetadata::get(
+          ConstantInt::get(Type::getInt32Ty(ctx), k)));
+    }
+    mds.push_back(MDNode::get(ctx, ops));
+    MDNode *loop_id = MDNode::getDistinct(ctx, mds);
+    loop_id->replaceOperandWith(0, loop_id);
+    L->setLoopID(loop_id);
+  }
+
+  // Drop the interchange advice of the leaf nest ending chain if an access
+  // escapes the patterns, then report it
+  void interchangeAnalysis(std::vector<LoopMemPatNode *> &chain) {
+    PhaseRegion region(stats.getTimer(PHASE_INTERCHANGE),
+                       func_stats.time[PHASE_INTERCHANGE]);
+    if (chain.size() < 2) {
+      return;
+    }
+    LoopStats &loop_stats = func_stats.loops[chain.back()];
+    interchange_advice_t &advice = loop_stats.interchange;
+    Loop *outer = node_loop_map[chain.front()];
+    if (advice.valid && hasUnanalyzedAccess(outer)) {
+      advice = interchange_advice_t();
+      advice.reason = "unanalyzed memory access";
+    }
+    std::vector<std::string> ind_vars;
+    for (auto loop : chain) {
+      ind_vars.push_back(loop->getLoopPat()->getIndVar());
+    }
+    interchange_report.write(func_stats.name, ind_vars,
+                             outer ? outer->getStartLoc() : DebugLoc(), advice);
+    if (DFGInterchangeMetadata && advice.valid && !advice.isIdentity() && outer) {
+      addInterchangeMetadata(outer, advice.order);
+      loop_stats.interchange_metadata = true;
+    }
+  }
+
+  // Whether control flows from the exit of A straight to the preheader of
+  // B, through blocks that do not touch memory
+  bool areAdjacentLoops(Loop *A, Loop *B) {
+    BasicBlock *BB = A->getExitBlock();
+    BasicBlock *preheader = B->getLoopPreheader();
+    for (int n = 0; BB && preheader && n < FUSION_MAX_BLOCKS_BETWEEN; n++) {
+      for (Instruction &I : *BB) {
+        if (I.mayReadOrWriteMemory()) {
+          return false;
+        }
+      }
+      if (BB == preheader) {
+        return true;
+      }
+      BB = BB->getSingleSuccessor();
+    }
+    return false;
+  }
+
+  // Legality and savings of fusing the nest from a with the nest from b,
+  // which runs right after it, both inside the loops of chain
+  fusion_candidate_t checkFusionPair(LoopMemPatNode *a, LoopMemPatNode *b,
+                                     std::vector<LoopMemPatNode *> &chain) {
+    fusion_candidate_t candidate;
+    LoopMemPatNode *first[2] = {a, b};
+    for (int n = 0; n < 2; n++) {
+      for (auto node = first[n]; node; ) {
+        candidate.loops[n].push_back(node->getLoopPat()->getIndVar());
+        LoopMemPatNode *inner = nullptr;
+        for (auto child : node->getChildren()) {
+          inner = child->getType() == LOOP_NODE ? child : inner;
+        }
+        node = inner;
+      }
+      DebugLoc loc = node_loop_map[first[n]]->getStartLoc();
+      if (loc) {
+        candidate.file = loc->getFilename().str();
+        candidate.line[n] = loc.getLine();
+      }
+    }
+    fusion_nest_t nest_a, nest_b;
+    if (!getFusionNest(a, chain, nest_a, candidate.reason) ||
+        !getFusionNest(b, chain, nest_b, candidate.reason)) {
+      return candidate;
+    }
+    if (hasUnanalyzedAccess(node_loop_map[a]) ||
+        hasUnanalyzedAccess(node_loop_map[b])) {
+      candidate.reason = "unanalyzed memory access";
+      return candidate;
+    }
+    candidate.levels = getFusableLevels(nest_a, nest_b);
+    if (candidate.levels == 0) {
+      candidate.reason = "different loop bounds";
+      return candidate;
+    }
+    if (!checkFusion(nest_a, nest_b, candidate)) {
+      return candidate;
+    }
+    candidate.legal = true;
+    estimateFusionSavings(candidate, nest_a, nest_b, getCacheConfig());
+    return candidate;
+  }
+
+  // Fusion candidates among the loops under n and, recursively, under each
+  // of them: every pair of loops the first of which flows into the second
+  void fusionAnalysis(LoopMemPatNode *n, std::vector<LoopMemPatNode *> &chain) {
+    std::vector<LoopMemPatNode *> loops;
+    for (auto child : n->getChildren()) {
+      if (child->getType() == LOOP_NODE && node_loop_map.count(child)) {
+        loops.push_back(child);
+      }
+    }
+    for (auto a : loops) {
+      for (auto b : loops) {
+        if (a == b || !areAdjacentLoops(node_loop_map[a], node_loop_map[b])) {
+          continue;
+        }
+        func_stats.fusion.push_back(checkFusionPair(a, b, chain));
+        fusion_report.add(func_stats.name, func_stats.fusion.back());
+      }
+    }
+    for (auto child : loops) {
+      chain.push_back(child);
+      fusionAnalysis(child, chain);
+      chain.pop_back();
+    }
+  }
+
+  void parallelAnalysis(LoopMemPatNode *n, std::vector<LoopMemPatNode *> &chain) {
+    for (auto child : n->getChildren()) {
+      if (child->getType() != LOOP_NODE) {
+        continue;
+      }
+      chain.push_back(child);
+      LoopStats &loop_stats = func_stats.loops[child];
+      {
+        PhaseRegion region(stats.getTimer(PHASE_PARALLEL),
+                           func_stats.time[PHASE_PARALLEL]);
+        loop_stats.parallel = isLoopParallel(chain);
+        if (loop_stats.parallel) {
+          Loop *L = node_loop_map[child];
+          int num_reductions = 0;
+          for (auto recurrence : child->getRecurrences()) {
+            num_reductions += recurrence->getKind() == "reduction";
+          }
+          parallel_report.write(func_stats.name,
+                                child->getLoopPat()->getIndVar(), chain.size(),
+                                L->getStartLoc(), !child->hasLoopChild(),
+                                num_reductions);
+          if (DFGParallelMetadata) {
+            addParallelMetadata(L);
+          }
+        }
+      }
+      if (!child->hasLoopChild()) {
+        waveFrontAnalysis(chain);
+        vectorAnalysis(chain);
+        interchangeAnalysis(chain);
+      }
+      parallelAnalysis(child, chain);
+      chain.pop_back();
+    }
+  }
+
+  void getDFGMemUsage(mem_usage_t &usage) {
+    for (auto &n : nodes) {
+      usage.add(MEM_DFG, 1, listNodeBytes<node>() + heapBytes(n.second));
+    }
+    for (edge_list *list : {&edges, &inst_edges}) {
+      for (auto &e : *list) {
+        usage.add(MEM_DFG, 1,
+                  listNodeBytes<edge>() + heapBytes(e.first.second) +
+                      heapBytes(e.second.second));
+      }
+    }
+  }
+
+  void funcDFG(Function *F, Module &M) {
+    func_stats = FuncStats();
+    func_stats.name = F->getName().str();
+    progress.setFunction(func_stats.name);
+    func_start = std::chrono::steady_clock::now();
+    func_iters = 0;
+    mem_usage_t mem_start = MemAccount::live;
+
+    LoopInfo *LI;
+    ScalarEvolution *SE;
+    {
+      PhaseRegion region(stats.getTimer(PHASE_ANALYSIS),
+                         func_stats.time[PHASE_ANALYSIS]);
+      LI = &getAnalysis<LoopInfoWrapperPass>(*F).getLoopInfo();
+      SE = &getAnalysis<ScalarEvolutionWrapperPass>(*F).getSE();
+    }
+    std::error_code error;
+    enum sys::fs::OpenFlags F_None;
+    // errs() << func_id << ": " << F->getName().str() << "\n";
+    StringRef fileName(std::to_string(func_id) + ".dot");
+    func_id++;
+    raw_fd_ostream file(fileName, error, F_None);
+
+    edges.clear();
+    nodes.clear();
+    inst_edges.clear();
+    loop_node_map.clear();
+    node_loop_map.clear();
+    acs_pat_map.clear();
+
+    DataLayout *DL = new DataLayout(&M);
+
+    LoopMemPatNode* func_node = new LoopMemPatNode(FUNC_NODE, F->getName().str());
+
+    {
+      PhaseRegion region(stats.getTimer(PHASE_PATTERN),
+                         func_stats.time[PHASE_PATTERN]);
+      for (LoopInfo::iterator LL = LI->begin(), LEnd = LI->end(); LL != LEnd;
+           ++LL) {
+        Loop *L = *LL;
+        handleLoop(L, *LI, DL, *SE, F, func_node);
+      }
+    }
+
+    {
+      PhaseRegion region(stats.getTimer(PHASE_DFG),
+                         func_stats.time[PHASE_DFG]);
+      for (Loop *L : *LI) {
+        buildLoopDFG(L, *LI);
+      }
+    }
+
+    // dumpGraph(file, F);
+
+    {
+      PhaseRegion region(stats.getTimer(PHASE_RECURRENCE),
+                         func_stats.time[PHASE_RECURRENCE]);
+      recurrenceAnalysis(*LI);
+    }
+
+    {
+      PhaseRegion region(stats.getTimer(PHASE_PATTERN_TREE),
+                         func_stats.time[PHASE_PATTERN_TREE]);
+      dumpLoopMemPatTree(func_node, 0);
+    }
+
+    loopDepAnalysis(func_node);
+
+    std::vector<LoopMemPatNode *> chain;
+    parallelAnalysis(func_node, chain);
+    {
+      PhaseRegion region(stats.getTimer(PHASE_FUSION),
+                         func_stats.time[PHASE_FUSION]);
+      fusionAnalysis(func_node, chain);
+    }
+
+    func_stats.mem = MemAccount::live;
+    func_stats.mem.sub(mem_start);
+    getDFGMemUsage(func_stats.mem);
+    if (func_stats.peak_loop) {
+      func_stats.mem.add(func_stats.loops[func_stats.peak_loop].mem);
+    }
+    if (DFGMemSummary) {
+      stats.printMemSummary(func_stats, errs());
+    }
+    stats.writeFunction(func_node, func_stats);
+
+    file.close();
+
+    return;
+  }
+
+  bool runOnModule(Module &M) override {
+    // Mark all recursive functions
+    // unordered_map<CallGraphNode *, Function *> callGraphNodeMap;
+    // auto &cg = getAnalysis<CallGraph>();
+    // for (auto &f: M) {
+    // 	auto cgn = cg[&f];
+    // 	callGraphNodeMap[cgn] = &f;
+    // }
+    // scc_iterator<CallGraph *> cgSccIter = scc_begin(&cg);
+    // while (!cgSccIter.isAtEnd()) {
+    // 	if (cgSccIter.hasLoop()) {
+    // 		const vector<CallGraphNode*>& nodeVec = *cgSccIter;
+    // 		for (auto cgn: nodeVec) {
+    // 			auto f = callGraphNodeMap[cgn];
+    // 			recSet.insert(f);
+    // 		}
+    // 	}
+    // 	++cgSccIter;
+    // }
+
+    if (!DFGStatsFile.empty()) {
+      stats.openReport(DFGStatsFile, M.getModuleIdentifier());
+    }
+    if (!DFGParallelLoops.empty()) {
+      parallel_report.open(DFGParallelLoops);
+    }
+    if (!DFGTiling.empty()) {
+      tiling_report.open(DFGTiling);
+    }
+    if (!DFGTraffic.empty()) {
+      traffic_report.open(DFGTraffic);
+    }
+    if (!DFGStrides.empty()) {
+      stride_report.open(DFGStrides);
+    }
+    if (!DFGInterchange.empty()) {
+      interchange_report.open(DFGInterchange);
+    }
+    if (!DFGFusion.empty()) {
+      fusion_report.open(DFGFusion);
+    }
+    if (!DFGStencils.empty()) {
+      stencil_report.open(DFGStencils);
+    }
+
+    for (auto &F : M) {
+      if (!(F.isDeclaration())) {
+        funcDFG(&F, M);
+      }
+    }
+
+    stats.closeReport();
+    parallel_report.close();
+    tiling_report.close();
+    traffic_report.close();
+    stride_report.close();
+    interchange_report.close();
+    fusion_report.close();
+    stencil_report.close();
+    return true;
+  }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,526 @@
+#ifndef DFG_STATS_H_
+#define DFG_STATS_H_
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "loop_mem_pat_node.h"
+#include "mem_stats.h"
+#include "stencil.h"
+#include "stride.h"
+#include "cache_model.h"
+#include "cache_sim.h"
+#include "tiling.h"
+#include "fusion.h"
+#include "interchange.h"
+#include "json_report.h"
+#include "unroll.h"
+#include "wavefront.h"
+
+enum dfg_phase_t {
+    PHASE_ANALYSIS = 0,     // LoopInfo / ScalarEvolution
+    PHASE_PATTERN = 1,      // handleLoop
+    PHASE_DFG = 2,          // buildLoopDFG
+    PHASE_RECURRENCE = 3,   // recurrenceAnalysis
+    PHASE_PATTERN_TREE = 4, // dumpLoopMemPatTree
+    PHASE_DEPENDENCE = 5,   // checkDependence
+    PHASE_OUTPUT = 6,       // dumpDependence
+    PHASE_UNROLL = 7,       // adviseUnroll
+    PHASE_PARALLEL = 8,     // isLoopParallel
+    PHASE_WAVEFRONT = 9,    // scheduleWavefront
+    PHASE_TILING = 10,      // adviseTiling
+    PHASE_REUSE = 11,       // estimateReuse
+    PHASE_CACHE_SIM = 12,   // simulateCache
+    PHASE_STRIDES = 13,     // classifyStrides
+    PHASE_INTERCHANGE = 14, // adviseInterchange
+    PHASE_FUSION = 15,      // fusionAnalysis
+    PHASE_STENCIL = 16,     // recognizeStencil
+    NUM_PHASES = 17
+};
+
+static const char* phase_names[NUM_PHASES] = {
+    "analysis", "pattern", "dfg", "recurrence",
+    "pattern_tree", "dependence", "output", "unroll", "parallel", "wavefront",
+    "tiling", "reuse", "cache_sim", "strides", "interchange", "fusion",
+    "stencil"};
+
+static const char* phase_descs[NUM_PHASES] = {
+    "Analysis acquisition",
+    "Pattern extraction (handleLoop)",
+    "DFG edge construction",
+    "Recurrence analysis",
+    "Pattern tree dump",
+    "Dependence enumeration (checkDependence)",
+    "Dependence output",
+    "Unroll advice (adviseUnroll)",
+    "Parallel loop detection (parallelAnalysis)",
+    "Wavefront scheduling (scheduleWavefront)",
+    "Tiling advice (adviseTiling)",
+    "Reuse estimation (estimateReuse)",
+    "Cache simulation (simulateCache)",
+    "Stride classification (classifyStrides)",
+    "Interchange advice (adviseInterchange)",
+    "Fusion analysis (fusionAnalysis)",
+    "Stencil recognition (recognizeStencil)"};
+
+struct LoopStats {
+    int num_geps = 0;
+    long long num_iters = 0; // enumerated iterations, leaf loops only
+    long long num_acs = 0;
+    long long num_pairs = 0;
+    double dep_time = 0;     // seconds in checkDependence
+    int num_skipped_acs = 0; // accesses dropped by the range pre-screen
+    bool skipped = false;    // not enumerated, all accesses disjoint
+    int num_dense_tables = 0;
+    long long window = -1;   // outer iterations of writes kept, -1 = all
+    long long spill_bytes = 0; // written to spill runs, 0 = in memory
+    bool jit = false;        // enumerated by a compiled kernel
+    bool specialized = false; // by a kernel specialized on depth and subscripts
+    unroll_advice_t unroll;
+    bool unroll_metadata = false; // written into the IR
+    std::vector<bool> flow_carried; // levels carrying enumerated dependences
+    bool parallel = false;          // no loop-carried memory dependence
+    wavefront_t wavefront;          // leaf nests none of whose loops is parallel
+    tiling_advice_t tiling;
+    interchange_advice_t interchange;
+    bool interchange_metadata = false; // written into the IR
+    reuse_report_t reuse;
+    cache_sim_report_t cache_sim; // with -dfg-cache-sim
+    stencil_t stencil;
+    std::vector<access_stride_t> strides;
+    std::vector<vector_verdict_t> vectorization; // per loop of the nest
+    mem_usage_t mem;         // write table and pairs at their peak
+};
+
+struct FuncStats {
+    std::string name;
+    double time[NUM_PHASES] = {0};
+    std::unordered_map<LoopMemPatNode*, LoopStats> loops;
+    // High-water mark: pattern trees and DFG lists of the function, plus
+    // the leaf loop using the most memory (they are analyzed one by one)
+    mem_usage_t mem;
+    LoopMemPatNode* peak_loop = nullptr;
+    // Pairs of adjacent sibling loop nests, in the order they were found
+    std::vector<fusion_candidate_t> fusion;
+};
+
+// Times one phase: adds the wall time to acc and, if timer is not null,
+// runs the phase timer reported under -time-passes
+class PhaseRegion {
+private:
+    llvm::TimeRegion _region;
+    double& _acc;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    PhaseRegion(llvm::Timer* timer, double& acc)
+        : _region(timer), _acc(acc), _start(std::chrono::steady_clock::now()) {}
+
+    ~PhaseRegion() {
+        _acc += std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - _start).count();
+    }
+};
+
+// Phase timers of the pass, and the JSON statistics report:
+//   {"module": ..., "functions": [
+//     {"name": ..., "loops": n, "geps": n, "mem_acs": n, "iterations": n,
+//      "pairs": n, "time": {phase: s}, "loop_nest": [
+//        {"ind_var": ..., "depth": d, "geps": n, "mem_acs": n, ...,
+//         "loops": [...]}]}],
+//    "time": {phase: s}}
+class DFGStats {
+private:
+    llvm::TimerGroup _timer_group;
+    llvm::Timer _timers[NUM_PHASES];
+    double _total_time[NUM_PHASES] = {0};
+
+    std::unique_ptr<llvm::raw_fd_ostream> _os;
+    std::unique_ptr<llvm::json::OStream> _json;
+
+    struct loop_total_t {
+        int num_loops = 0;
+        int num_assumed_dep = 0;
+        int num_geps = 0;
+        int num_mem_acs = 0;
+        long long num_iters = 0;
+        long long num_pairs = 0;
+    };
+
+    void writeTimes(const double* time) {
+        _json->attributeObject("time", [&] {
+            for (int p = 0; p < NUM_PHASES; p++) {
+                _json->attribute(phase_names[p], time[p]);
+            }
+        });
+    }
+
+    void writeMemory(const mem_usage_t& mem) {
+        _json->attributeObject("memory", [&] {
+            _json->attribute("peak_bytes", mem.getTotalBytes());
+            for (int c = 0; c < NUM_MEM_CATEGORIES; c++) {
+                if (mem.objects[c] == 0 && mem.bytes[c] == 0) {
+                    continue;
+                }
+                _json->attributeObject(mem_category_names[c], [&] {
+                    _json->attribute("objects", mem.objects[c]);
+                    _json->attribute("bytes", mem.bytes[c]);
+                });
+            }
+        });
+    }
+
+    void writeLevels(const char* key, const double* values) {
+        _json->attributeObject(key, [&] {
+            for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                _json->attribute(cache_level_names[c], values[c]);
+            }
+        });
+    }
+
+    void writeReuse(const reuse_report_t& reuse) {
+        _json->attributeObject("reuse", [&] {
+            writeLevels("misses_per_iteration", reuse.misses);
+            writeLevels("traffic", reuse.traffic);
+            _json->attributeObject("local_level", [&] {
+                for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                    _json->attribute(cache_level_names[c], reuse.local_level[c]);
+                }
+            });
+            _json->attributeArray("refs", [&] {
+                for (auto& ref : reuse.refs) {
+                    _json->object([&] {
+                        _json->attribute("array", ref.array);
+                        _json->attribute("write", ref.write);
+                        _json->attribute("reuse", reuse_kind_names[ref.kind]);
+                        if (ref.level >= 0) {
+                            _json->attribute("level", ref.level);
+                            _json->attribute("distance_lines", ref.distance);
+                        }
+                        writeLevels("misses_per_iteration", ref.misses);
+                    });
+                }
+            });
+        });
+    }
+
+    // Ind vars of the loops around leaf, from the outermost
+    std::vector<std::string> getIndVars(LoopMemPatNode* leaf) {
+        std::vector<std::string> ind_vars;
+        for (auto node = leaf; node && node->getType() == LOOP_NODE;
+             node = node->getParent()) {
+            ind_vars.insert(ind_vars.begin(), node->getLoopPat()->getIndVar());
+        }
+        return ind_vars;
+    }
+
+    void writeStrides(LoopMemPatNode* leaf, const LoopStats& ls) {
+        std::vector<std::string> ind_vars = getIndVars(leaf);
+        _json->attributeArray("vectorization", [&] {
+            for (size_t k = 0; k < ls.vectorization.size(); k++) {
+                _json->object([&] {
+                    _json->attribute("ind_var", ind_vars[k]);
+                    _json->attribute("verdict",
+                                     vector_verdict_names[ls.vectorization[k]]);
+                });
+            }
+        });
+        _json->attributeArray("strides", [&] {
+            for (auto& access : ls.strides) {
+                _json->object([&] {
+                    _json->attribute("array", access.array);
+                    _json->attribute("write", access.write);
+                    _json->attribute("element_bytes", access.elem_bytes);
+                    _json->attributeObject("loops", [&] {
+                        for (size_t k = 0; k < access.cls.size(); k++) {
+                            _json->attributeObject(ind_vars[k], [&] {
+                                _json->attribute("stride",
+                                                 stride_class_names[access.cls[k]]);
+                                _json->attribute("bytes", access.bytes[k]);
+                            });
+                        }
+                    });
+                });
+            }
+        });
+    }
+
+    void writeCounts(const cache_counts_t* counts) {
+        for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+            _json->attributeObject(cache_level_names[c], [&] {
+                _json->attribute("hits", counts[c].hits);
+                _json->attribute("misses", counts[c].misses);
+                _json->attribute("evictions", counts[c].evictions);
+            });
+        }
+    }
+
+    void writeCacheSim(const cache_sim_report_t& sim) {
+        _json->attributeObject("cache_sim", [&] {
+            _json->attribute("accesses", sim.accesses);
+            _json->attribute("seconds", sim.seconds);
+            writeCounts(sim.counts);
+            _json->attributeArray("refs", [&] {
+                for (auto& ref : sim.refs) {
+                    _json->object([&] {
+                        _json->attribute("array", ref.array);
+                        _json->attribute("write", ref.write);
+                        writeCounts(ref.counts);
+                    });
+                }
+            });
+        });
+    }
+
+    void sumLoops(LoopMemPatNode* node, FuncStats& fs, loop_total_t& total) {
+        for (auto child : node->getChildren()) {
+            if (child->getType() == MEM_ACS_NODE) {
+                total.num_mem_acs++;
+            } else if (child->getType() == LOOP_NODE) {
+                LoopStats& ls = fs.loops[child];
+                total.num_loops++;
+                total.num_assumed_dep += child->isAssumedDependent();
+                total.num_geps += ls.num_geps;
+                total.num_iters += ls.num_iters;
+                total.num_pairs += ls.num_pairs;
+                sumLoops(child, fs, total);
+            }
+        }
+    }
+
+    void writeLoops(const char* key, LoopMemPatNode* node, FuncStats& fs,
+                    int depth) {
+        _json->attributeArray(key, [&] {
+            for (auto child : node->getChildren()) {
+                if (child->getType() != LOOP_NODE) {
+                    continue;
+                }
+                LoopStats& ls = fs.loops[child];
+                int num_mem_acs = 0;
+                for (auto grandchild : child->getChildren()) {
+                    num_mem_acs += grandchild->getType() == MEM_ACS_NODE;
+                }
+                _json->object([&] {
+                    auto loop_pat = child->getLoopPat();
+                    _json->attribute("ind_var",
+                                     loop_pat ? loop_pat->getIndVar() : "");
+                    _json->attribute("depth", depth);
+                    _json->attribute("geps", ls.num_geps);
+                    _json->attribute("mem_acs", num_mem_acs);
+                    _json->attributeArray("recurrences", [&] {
+                        for (auto rec : child->getRecurrences()) {
+                            _json->object([&] {
+                                _json->attribute("kind", rec->getKind());
+                                _json->attribute("nodes", rec->getNumNodes());
+                                _json->attribute("ops", rec->getNumOps());
+                                _json->attribute("chain", rec->getPathLen());
+                            });
+                        }
+                    });
+                    _json->attribute("recurrence_bound",
+                                     child->isRecurrenceBound());
+                    _json->attribute("parallel", ls.parallel);
+                    if (child->isAssumedDependent()) {
+                        _json->attribute("assumed_dependent",
+                                         child->getAssumedDepReason());
+                    }
+                    if (!child->hasLoopChild()) {
+                        _json->attribute("iterations", ls.num_iters);
+                        _json->attribute("accesses", ls.num_acs);
+                        _json->attribute("pairs", ls.num_pairs);
+                        _json->attribute("dependence_s", ls.dep_time);
+                        _json->attribute("prescreen_skipped_accesses",
+                                         ls.num_skipped_acs);
+                        _json->attribute("prescreen_skipped_loop", ls.skipped);
+                        _json->attribute("dense_tables", ls.num_dense_tables);
+                        _json->attribute("window", ls.window);
+                        _json->attribute("spill_bytes", ls.spill_bytes);
+                        _json->attribute("jit", ls.jit);
+                        _json->attribute("specialized", ls.specialized);
+                        if (ls.unroll.valid) {
+                            _json->attributeObject("unroll", [&] {
+                                _json->attribute("count", ls.unroll.unroll);
+                                _json->attribute("unroll_and_jam",
+                                                 ls.unroll.unroll_and_jam);
+                                _json->attribute("max_legal_jam",
+                                                 ls.unroll.max_legal_jam);
+                                _json->attribute("inner_distance",
+                                                 ls.unroll.inner_dist);
+                                _json->attribute("outer_reuse",
+                                                 ls.unroll.outer_reuse);
+                                _json->attribute("metadata", ls.unroll_metadata);
+                            });
+                        }
+                        if (ls.wavefront.valid) {
+                            auto& wf = ls.wavefront;
+                            _json->attributeObject("wavefront", [&] {
+                                _json->attributeArray("hyperplane", [&] {
+                                    for (int c: wf.hyperplane) {
+                                        _json->value(c);
+                                    }
+                                });
+                                _json->attribute("time_level", wf.time_level);
+                                _json->attribute("distances", wf.num_distances);
+                                _json->attribute("wavefronts", wf.num_wavefronts);
+                                _json->attribute("max_parallelism", wf.max_parallelism);
+                                _json->attribute("avg_parallelism", wf.avg_parallelism);
+                                _json->attributeArray("schedule", [&] {
+                                    for (auto& line: wf.schedule) {
+                                        _json->value(line);
+                                    }
+                                });
+                            });
+                        } else if (!ls.wavefront.reason.empty()) {
+                            _json->attribute("wavefront", ls.wavefront.reason);
+                        }
+                        if (ls.stencil.valid) {
+                            _json->attributeObject("stencil", [&] {
+                                StencilReport::writeStencil(*_json, ls.stencil);
+                            });
+                        } else if (!ls.stencil.reason.empty()) {
+                            _json->attribute("stencil", ls.stencil.reason);
+                        }
+                        if (ls.tiling.valid) {
+                            _json->attributeObject("tiling", [&] {
+                                _json->attribute("band", ls.tiling.band);
+                                _json->attribute("nest_bytes", ls.tiling.nest_bytes);
+                                TilingReport::writeTiles(*_json, ls.tiling);
+                            });
+                        } else if (!ls.tiling.reason.empty()) {
+                            _json->attribute("tiling", ls.tiling.reason);
+                        }
+                        if (ls.interchange.valid) {
+                            _json->attributeObject("interchange", [&] {
+                                InterchangeReport::writeAdvice(*_json, getIndVars(child),
+                                                               ls.interchange);
+                                _json->attribute("metadata", ls.interchange_metadata);
+                            });
+                        } else if (!ls.interchange.reason.empty()) {
+                            _json->attribute("interchange", ls.interchange.reason);
+                        }
+                        if (ls.reuse.valid) {
+                            writeReuse(ls.reuse);
+                        }
+                        if (!ls.strides.empty()) {
+                            writeStrides(child, ls);
+                        }
+                        if (ls.cache_sim.valid) {
+                            writeCacheSim(ls.cache_sim);
+                        } else if (!ls.cache_sim.reason.empty()) {
+                            _json->attribute("cache_sim", ls.cache_sim.reason);
+                        }
+                        writeMemory(ls.mem);
+                    }
+                    writeLoops("loops", child, fs, depth + 1);
+                });
+            }
+        });
+    }
+
+public:
+    DFGStats() : _timer_group("dfg", "DFGPass phases") {
+        for (int p = 0; p < NUM_PHASES; p++) {
+            _timers[p].init(phase_names[p], phase_descs[p], _timer_group);
+        }
+    }
+
+    // Phase timer, or null if -time-passes is off
+    llvm::Timer* getTimer(dfg_phase_t phase) {
+        return llvm::TimePassesIsEnabled ? &_timers[phase] : nullptr;
+    }
+
+    bool isReporting() { return _json != nullptr; }
+
+    bool openReport(const std::string& file, const std::string& module_name) {
+        _os = openReportFile(file);
+        if (!_os) {
+            return false;
+        }
+        for (int p = 0; p < NUM_PHASES; p++) {
+            _total_time[p] = 0;
+        }
+        _json.reset(new llvm::json::OStream(*_os, 2));
+        _json->objectBegin();
+        _json->attribute("module", module_name);
+        _json->attributeBegin("functions");
+        _json->arrayBegin();
+        return true;
+    }
+
+    void writeFunction(LoopMemPatNode* func_node, FuncStats& fs) {
+        for (int p = 0; p < NUM_PHASES; p++) {
+            _total_time[p] += fs.time[p];
+        }
+        if (!_json) {
+            return;
+        }
+        loop_total_t total;
+        sumLoops(func_node, fs, total);
+        _json->object([&] {
+            _json->attribute("name", fs.name);
+            _json->attribute("loops", total.num_loops);
+            _json->attribute("geps", total.num_geps);
+            _json->attribute("mem_acs", total.num_mem_acs);
+            _json->attribute("iterations", total.num_iters);
+            _json->attribute("pairs", total.num_pairs);
+            _json->attribute("assumed_dependent_loops", total.num_assumed_dep);
+            writeTimes(fs.time);
+            writeMemory(fs.mem);
+            if (!fs.fusion.empty()) {
+                _json->attributeArray("fusion", [&] {
+                    for (auto& candidate: fs.fusion) {
+                        _json->object([&] { FusionReport::writeCandidate(*_json, candidate); });
+                    }
+                });
+            }
+            writeLoops("loop_nest", func_node, fs, 1);
+        });
+    }
+
+    // One line per function: peak bytes, split into pattern trees, DFG lists
+    // and the largest leaf loop
+    void printMemSummary(FuncStats& fs, llvm::raw_ostream& os) {
+        const mem_usage_t& mem = fs.mem;
+        long long pattern = mem.bytes[MEM_PAT_NODE] +
+                            mem.bytes[MEM_LOOP_MEM_PAT_NODE] +
+                            mem.bytes[MEM_MEM_ACS_PAT];
+        long long loop = mem.bytes[MEM_WRITE_TABLE] + mem.bytes[MEM_ARRAY_POS] +
+                         mem.bytes[MEM_DEP_PAIRS];
+        os << "DFGPass memory: " << fs.name << ": peak "
+           << mem.getTotalBytes() << " B, patterns " << pattern << " B ("
+           << mem.objects[MEM_PAT_NODE] << " PatNode, "
+           << mem.objects[MEM_LOOP_MEM_PAT_NODE] << " LoopMemPatNode, "
+           << mem.objects[MEM_MEM_ACS_PAT] << " MemAcsPat), dfg "
+           << mem.bytes[MEM_DFG] << " B (" << mem.objects[MEM_DFG]
+           << " entries), largest loop " << loop << " B";
+        if (fs.peak_loop) {
+            auto loop_pat = fs.peak_loop->getLoopPat();
+            os << " (" << (loop_pat ? loop_pat->getIndVar() : "") << ": "
+               << mem.objects[MEM_WRITE_TABLE] << " writes, "
+               << mem.objects[MEM_DEP_PAIRS] << " distances)";
+        }
+        os << "\n";
+    }
+
+    void closeReport() {
+        if (!_json) {
+            return;
+        }
+        _json->arrayEnd();
+        _json->attributeEnd();
+        writeTimes(_total_time);
+        _json->objectEnd();
+        _json->flush();
+        *_os << "\n";
+        _json.reset();
+        _os.reset();
+    }
+};
+
+#endif
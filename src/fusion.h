@@ -0,0 +1,419 @@
+#ifndef FUSION_H_
+#define FUSION_H_
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "affine.h"
+#include "cache_model.h"
+#include "json_report.h"
+#include "loop_mem_pat_node.h"
+#include "unroll.h"
+
+// Fusion of two adjacent sibling loop nests of the pattern tree, the first
+// one running entirely before the second. The leading loops of the two
+// perfect nests with the same bounds are fused; below them, the inner
+// loops of the first nest run before those of the second in every fused
+// iteration. Fusion is legal unless an element touched by the first nest
+// at some fused iteration, with a write on either side, is touched by the
+// second nest at an earlier one.
+
+// Blocks followed from the exit block of the first loop, through single
+// successors, to reach the preheader of the second, both included. Loops
+// further apart are not adjacent and are not considered for fusion.
+static const int FUSION_MAX_BLOCKS_BETWEEN = 8;
+
+// A perfect loop nest and the loops around it
+struct fusion_nest_t {
+    int outer = 0;                     // loops around the nest
+    std::vector<std::string> ind_vars; // loops around the nest, then the nest
+    std::vector<int> start;
+    std::vector<int> end;
+    std::vector<int> step;
+    std::vector<long long> trip;       // 1 for loops around with unknown bounds
+    std::map<std::string, Interval> ranges;
+    std::vector<MemAcsPat*> refs;      // of the innermost loop
+
+    int getDepth() const { return ind_vars.size() - outer; }
+};
+
+// The perfect nest from n, inside the loops of chain; false, with the
+// reason, if it is not perfect or its bounds or accesses are not known
+inline bool getFusionNest(LoopMemPatNode* n, const std::vector<LoopMemPatNode*>& chain,
+                          fusion_nest_t& nest, std::string& reason) {
+    std::vector<LoopMemPatNode*> loops = chain;
+    nest.outer = chain.size();
+    for (auto node = n; node; ) {
+        loops.push_back(node);
+        LoopMemPatNode* inner = nullptr;
+        for (auto child: node->getChildren()) {
+            if (child->getType() == LOOP_NODE) {
+                inner = child;
+            }
+        }
+        if (inner && node->getChildren().size() != 1) {
+            reason = "imperfect nest";
+            return false;
+        }
+        node = inner;
+    }
+    for (size_t k = 0; k < loops.size(); k++) {
+        auto loop_pat = loops[k]->getLoopPat();
+        bool known = loop_pat && loop_pat->hasConstantBounds();
+        if ((int)k >= nest.outer) {
+            if (loops[k]->isAssumedDependent()) {
+                reason = loops[k]->getAssumedDepReason();
+                return false;
+            }
+            if (!known) {
+                reason = "non-constant loop bounds";
+                return false;
+            }
+        }
+        int start = known ? loop_pat->getStartVal() : 0;
+        int end = known ? loop_pat->getEndVal() : 1;
+        int step = known ? loop_pat->getStepVal() : 1;
+        nest.ind_vars.push_back(loop_pat ? loop_pat->getIndVar() : "");
+        nest.start.push_back(start);
+        nest.end.push_back(end);
+        nest.step.push_back(step);
+        long long trip = 1;
+        if (known) {
+            trip = step > 0 && end > start ? (end - start + step - 1) / step : 0;
+        }
+        nest.trip.push_back(trip);
+        if (known) {
+            nest.ranges[nest.ind_vars.back()] = getIndVarRange(start, end, step);
+        }
+    }
+    for (auto child: loops.back()->getChildren()) {
+        if (child->getType() != MEM_ACS_NODE) {
+            continue;
+        }
+        auto mode = child->getMemAcsPat()->getAccessMode();
+        if (mode != READ && mode != WRITE) {
+            reason = "unknown access mode";
+            return false;
+        }
+        nest.refs.push_back(child->getMemAcsPat());
+    }
+    return true;
+}
+
+// Leading loops of the nests a and b with the same bounds
+inline int getFusableLevels(const fusion_nest_t& a, const fusion_nest_t& b) {
+    int levels = 0;
+    while (levels < a.getDepth() && levels < b.getDepth()) {
+        int k_a = a.outer + levels, k_b = b.outer + levels;
+        if (a.start[k_a] != b.start[k_b] || a.end[k_a] != b.end[k_b] ||
+            a.step[k_a] != b.step[k_b]) {
+            break;
+        }
+        levels++;
+    }
+    return levels;
+}
+
+// Distance y - x over the fused loops between an iteration x of nest a
+// and an iteration y of nest b where references pa and pb touch the same
+// element. The loops around both nests are at the same iteration;
+// subscripts over the ind vars of unfused loops constrain nothing.
+inline dep_dist_kind_t getFusionDistance(PatNode* pa, PatNode* pb, const fusion_nest_t& a,
+                                         const fusion_nest_t& b, int levels,
+                                         std::vector<dist_t>& dist) {
+    if (pa->getValueName() != pb->getValueName()) {
+        return DEP_NONE;
+    }
+    if (!mayOverlap(pa, pb, a.ranges, b.ranges)) {
+        return DEP_NONE;
+    }
+    // The fused loops of b under the ind vars of a
+    std::vector<AffineExpr> b_subs = getAffineSubscripts(pb);
+    for (auto& sub: b_subs) {
+        for (int k = 0; k < levels; k++) {
+            const std::string& ind_var = b.ind_vars[b.outer + k];
+            long long c = sub.getCoeff(ind_var);
+            sub.add(AffineExpr::indVar(ind_var), -c);
+            sub.add(AffineExpr::indVar(a.ind_vars[a.outer + k]), c);
+        }
+    }
+    int depth = a.outer + levels;
+    std::vector<std::string> ind_vars(a.ind_vars.begin(), a.ind_vars.begin() + depth);
+    std::vector<int> step(a.step.begin(), a.step.begin() + depth);
+    std::vector<long long> trip(a.trip.begin(), a.trip.begin() + depth);
+    auto kind = getSeparableDistance(getAffineSubscripts(pa), b_subs, ind_vars, step, trip,
+                                     a.outer, true, dist);
+    if (kind == DEP_DIST) {
+        dist.erase(dist.begin(), dist.begin() + a.outer);
+    }
+    return kind;
+}
+
+// Whether some distance y - x of dist is lexicographically negative, i.e.
+// the fused loops run the iteration of the second nest first
+inline bool isFusionPreventing(const std::vector<dist_t>& dist,
+                               const std::vector<long long>& trip) {
+    for (size_t k = 0; k < dist.size(); k++) {
+        if (dist[k].any) {
+            if (trip[k] > 1) {
+                return true;
+            }
+            continue;
+        }
+        if (dist[k].val != 0) {
+            return dist[k].val < 0;
+        }
+    }
+    return false;
+}
+
+// An array the second nest reads after the first one touched it
+struct fusion_array_t {
+    std::string name;
+    bool produced = false; // written by the first nest
+    double lines = 0;      // lines of it both nests touch
+};
+
+struct fusion_candidate_t {
+    bool legal = false;
+    std::string reason;          // why the nests cannot be fused, if not legal
+    std::vector<std::string> loops[2]; // ind vars of the first and second nest
+    std::string file;
+    unsigned line[2] = {0, 0};
+    int levels = 0;              // loops fused
+    // Outermost fused loop a dependence between the nests crosses
+    // iterations of (levels if none), and the largest such distance
+    int reuse_level = 0;
+    long long reuse_dist = 0;
+    std::vector<fusion_array_t> arrays;
+    double saved[NUM_CACHE_LEVELS] = {0}; // bytes no longer filled into each level
+};
+
+// Whether the first candidate.levels loops of a and b can be fused;
+// false, with the reason, if not
+inline bool checkFusion(const fusion_nest_t& a, const fusion_nest_t& b,
+                        fusion_candidate_t& candidate) {
+    int levels = candidate.levels;
+    std::vector<long long> trip(a.trip.begin() + a.outer, a.trip.begin() + a.outer + levels);
+    std::vector<dist_t> dist;
+    candidate.reuse_level = levels;
+    candidate.reuse_dist = 0;
+    for (auto ra: a.refs) {
+        for (auto rb: b.refs) {
+            if (ra->getAccessMode() != WRITE && rb->getAccessMode() != WRITE) {
+                continue;
+            }
+            auto kind = getFusionDistance(ra->getPatNode(), rb->getPatNode(), a, b, levels, dist);
+            if (kind == DEP_UNKNOWN) {
+                candidate.reason = "non-uniform dependence between the loops";
+                return false;
+            }
+            if (kind != DEP_DIST) {
+                continue;
+            }
+            if (isFusionPreventing(dist, trip)) {
+                candidate.reason = "fusion-preventing dependence on " +
+                                   ra->getPatNode()->getValueName();
+                return false;
+            }
+            for (int k = 0; k < levels; k++) {
+                if (!dist[k].any && dist[k].val != 0) {
+                    if (k < candidate.reuse_level) {
+                        candidate.reuse_level = k;
+                        candidate.reuse_dist = 0;
+                    }
+                    if (k == candidate.reuse_level) {
+                        candidate.reuse_dist = std::max(candidate.reuse_dist, dist[k].val);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Lines of each array that the affine references of nest touch over its
+// loops from level m, the other loops at their first iteration; arrays
+// with a non-affine reference are left out
+inline std::map<std::string, double> getArrayLines(const fusion_nest_t& nest, int m,
+                                                   bool reads_only, int line_bytes) {
+    std::map<std::string, double> sum;
+    std::map<std::string, Interval> spans;
+    std::set<std::string> unknown;
+    for (auto ref: nest.refs) {
+        PatNode* pn = ref->getPatNode();
+        if (reads_only && ref->getAccessMode() != READ) {
+            continue;
+        }
+        ref_address_t addr;
+        if (!getRefAddress(pn, nest.ind_vars, nest.start, nest.step, addr) || !addr.affine) {
+            unknown.insert(pn->getValueName());
+            continue;
+        }
+        ref_footprint_t fp = getAffineFootprint(addr, nest.trip, m, line_bytes);
+        sum[pn->getValueName()] += fp.lines;
+        Interval& span = spans[pn->getValueName()];
+        if (!span.known) {
+            span = fp.span;
+        }
+        span.lo = std::min(span.lo, fp.span.lo);
+        span.hi = std::max(span.hi, fp.span.hi);
+    }
+    std::map<std::string, double> lines;
+    for (auto& array: sum) {
+        if (unknown.count(array.first)) {
+            continue;
+        }
+        const Interval& span = spans[array.first];
+        lines[array.first] = std::min(array.second,
+                                      std::floor((double)span.hi / line_bytes) -
+                                          std::floor((double)span.lo / line_bytes) + 1);
+    }
+    return lines;
+}
+
+// Loads of the second nest that fusion turns into hits: the lines of the
+// arrays it reads after the first nest touched them. A cache level saves
+// them when the footprint of the first nest overflows it, so that they
+// are evicted before the second nest runs, and the footprint of the fused
+// iterations between a producer and its consumer fits.
+inline void estimateFusionSavings(fusion_candidate_t& candidate, const fusion_nest_t& a,
+                                  const fusion_nest_t& b, const cache_config_t& cache) {
+    std::map<std::string, double> a_lines = getArrayLines(a, a.outer, false, cache.line_bytes);
+    std::map<std::string, double> b_reads = getArrayLines(b, b.outer, true, cache.line_bytes);
+    std::set<std::string> produced;
+    for (auto ref: a.refs) {
+        if (ref->getAccessMode() == WRITE) {
+            produced.insert(ref->getPatNode()->getValueName());
+        }
+    }
+    double reused = 0;
+    for (auto& array: b_reads) {
+        auto iter = a_lines.find(array.first);
+        if (iter == a_lines.end()) {
+            continue;
+        }
+        fusion_array_t shared;
+        shared.name = array.first;
+        shared.produced = produced.count(array.first) > 0;
+        shared.lines = std::min(array.second, iter->second);
+        candidate.arrays.push_back(shared);
+        reused += shared.lines;
+    }
+    double a_total = 0, fused = 0;
+    for (auto& array: a_lines) {
+        a_total += array.second;
+    }
+    int m = std::min(candidate.reuse_level + 1, candidate.levels);
+    for (auto& array: getArrayLines(a, a.outer + m, false, cache.line_bytes)) {
+        fused += array.second;
+    }
+    for (auto& array: getArrayLines(b, b.outer + m, false, cache.line_bytes)) {
+        fused += array.second;
+    }
+    fused *= candidate.reuse_dist + 1;
+    for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+        double cache_lines = (double)cache.capacity[c] / cache.line_bytes;
+        if (a_total > cache_lines && fused <= cache_lines) {
+            candidate.saved[c] = reused * cache.line_bytes;
+        }
+    }
+}
+
+// JSON list of the pairs of adjacent sibling loop nests, the legal ones
+// first, ranked by the bytes fusion saves loading from memory (LLC fills),
+// then L2 and L1 fills:
+//   [{"function": ..., "file": ..., "first": {"loops": [ind_var, ...],
+//     "line": n}, "second": {...}, "legal": b, "levels": n,
+//     "arrays": [{"array": ..., "produced": b, "lines": x}, ...],
+//     "saved_bytes": {"L1": x, ...}}, ...]
+class FusionReport : public JSONListReport {
+private:
+    struct entry_t {
+        std::string func_name;
+        fusion_candidate_t candidate;
+    };
+
+    std::vector<entry_t> _entries;
+
+public:
+    // Everything but the function, as object attributes
+    static void writeCandidate(llvm::json::OStream& json, const fusion_candidate_t& candidate) {
+        if (!candidate.file.empty()) {
+            json.attribute("file", candidate.file);
+        }
+        const char* names[2] = {"first", "second"};
+        for (int n = 0; n < 2; n++) {
+            json.attributeObject(names[n], [&] {
+                json.attributeArray("loops", [&] {
+                    for (auto& ind_var: candidate.loops[n]) {
+                        json.value(ind_var);
+                    }
+                });
+                if (candidate.line[n]) {
+                    json.attribute("line", (int64_t)candidate.line[n]);
+                }
+            });
+        }
+        json.attribute("legal", candidate.legal);
+        if (!candidate.legal) {
+            json.attribute("reason", candidate.reason);
+            return;
+        }
+        json.attribute("levels", candidate.levels);
+        json.attributeArray("arrays", [&] {
+            for (auto& array: candidate.arrays) {
+                json.object([&] {
+                    json.attribute("array", array.name);
+                    json.attribute("produced", array.produced);
+                    json.attribute("lines", array.lines);
+                });
+            }
+        });
+        json.attributeObject("saved_bytes", [&] {
+            for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                json.attribute(cache_level_names[c], candidate.saved[c]);
+            }
+        });
+    }
+
+    void add(const std::string& func_name, const fusion_candidate_t& candidate) {
+        if (!_json) {
+            return;
+        }
+        _entries.push_back({func_name, candidate});
+    }
+
+    void close() {
+        if (!_json) {
+            return;
+        }
+        std::stable_sort(_entries.begin(), _entries.end(), [](const entry_t& a, const entry_t& b) {
+            if (a.candidate.legal != b.candidate.legal) {
+                return a.candidate.legal;
+            }
+            for (int c = NUM_CACHE_LEVELS - 1; c >= 0; c--) {
+                if (a.candidate.saved[c] != b.candidate.saved[c]) {
+                    return a.candidate.saved[c] > b.candidate.saved[c];
+                }
+            }
+            return false;
+        });
+        for (auto& entry: _entries) {
+            _json->object([&] {
+                _json->attribute("function", entry.func_name);
+                writeCandidate(*_json, entry.candidate);
+            });
+        }
+        JSONListReport::close();
+        _entries.clear();
+    }
+};
+
+#endif
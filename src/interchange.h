@@ -0,0 +1,173 @@
+#ifndef INTERCHANGE_H_
+#define INTERCHANGE_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cache_model.h"
+#include "json_report.h"
+#include "stride.h"
+#include "wavefront.h"
+
+// Loop orders of a perfect leaf loop nest that its dependences allow, ranked
+// by the cache-line traffic the miss model of cache_model.h predicts for
+// them, then by the accesses the innermost loop does not walk with unit
+// stride.
+
+// Deepest nest whose depth! orders are tried
+static const int INTERCHANGE_MAX_DEPTH = 6;
+
+// An order lists the loops of the nest by their original level, from the
+// outermost one. It is legal when every distance vector, its components
+// permuted the same way, stays lexicographically nonnegative. The distances
+// of collectDistances are the corners of boxes of distances, and a box is
+// lexicographically nonnegative in every order its corners are.
+inline bool isLegalOrder(const std::set<dist_vec_t>& deps, const std::vector<int>& order) {
+    for (auto& d: deps) {
+        for (int k: order) {
+            if (d[k] < 0) {
+                return false;
+            }
+            if (d[k] > 0) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// Misses of the affine references addrs, with their arrays, when the loops
+// run in order
+inline reuse_report_t getOrderMisses(const std::vector<ref_address_t>& addrs,
+                                     const std::vector<ref_reuse_t>& refs,
+                                     const std::vector<long long>& trip,
+                                     const std::vector<int>& order,
+                                     long long iterations, const cache_config_t& cache) {
+    int depth = order.size();
+    std::vector<long long> order_trip(depth);
+    for (int k = 0; k < depth; k++) {
+        order_trip[k] = trip[order[k]];
+    }
+    reuse_report_t report;
+    report.valid = true;
+    report.iterations = iterations;
+    report.refs = refs;
+    std::vector<std::vector<ref_footprint_t>> footprints;
+    for (auto& addr: addrs) {
+        ref_address_t order_addr = addr;
+        for (int k = 0; k < depth; k++) {
+            order_addr.coeff[k] = addr.coeff[order[k]];
+        }
+        std::vector<ref_footprint_t> fps(depth + 1);
+        for (int m = 0; m <= depth; m++) {
+            fps[m] = getAffineFootprint(order_addr, order_trip, m, cache.line_bytes);
+        }
+        footprints.push_back(fps);
+    }
+    estimateMisses(report, footprints, order_trip, cache);
+    return report;
+}
+
+// References the loop at level does not walk with unit stride, or leave in
+// place
+inline int getNonUnitStrides(const std::vector<ref_address_t>& addrs, int level) {
+    int num = 0;
+    for (auto& addr: addrs) {
+        stride_class_t cls = classifyStride(addr.affine, addr.coeff[level], addr.elem_bytes);
+        num += cls != STRIDE_UNIT && cls != STRIDE_INVARIANT;
+    }
+    return num;
+}
+
+struct interchange_advice_t {
+    bool valid = false;
+    std::string reason;   // why there is no advice, if not valid
+    int num_orders = 0;   // orders tried
+    int num_legal = 0;    // of which legal, the original one included
+    std::vector<int> order; // best legal order, by original level
+    double traffic[NUM_CACHE_LEVELS] = {0};      // bytes filled, original order
+    double best_traffic[NUM_CACHE_LEVELS] = {0}; // bytes filled, best order
+    int non_unit = 0;      // non-unit innermost strides, original order
+    int best_non_unit = 0; // non-unit innermost strides, best order
+
+    bool isIdentity() const {
+        for (size_t k = 0; k < order.size(); k++) {
+            if (order[k] != (int)k) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Whether the traffic and strides of a are better than those of b: less
+// traffic from the outermost cache level in, then fewer non-unit strides
+inline bool isBetterOrder(const double* traffic_a, int non_unit_a, const double* traffic_b,
+                          int non_unit_b) {
+    for (int c = NUM_CACHE_LEVELS - 1; c >= 0; c--) {
+        // Orders with the same footprints differ by rounding only
+        double tolerance = 1e-9 * std::max(traffic_a[c], traffic_b[c]);
+        if (traffic_a[c] < traffic_b[c] - tolerance) {
+            return true;
+        }
+        if (traffic_a[c] > traffic_b[c] + tolerance) {
+            return false;
+        }
+    }
+    return non_unit_a < non_unit_b;
+}
+
+// JSON list of the interchange advice of every perfect leaf loop nest:
+//   [{"function": ..., "loops": [ind_var, ...], "file": ..., "line": n,
+//     "valid": b, "legal_orders": n, "orders": n, "best": [ind_var, ...],
+//     "traffic": {"L1": {"before": bytes, "after": bytes}, ...},
+//     "non_unit_strides": {"before": n, "after": n}}, ...]
+class InterchangeReport : public JSONListReport {
+public:
+    // Everything but the function, loops and location, as object attributes
+    static void writeAdvice(llvm::json::OStream& json, const std::vector<std::string>& ind_vars,
+                            const interchange_advice_t& advice) {
+        json.attribute("valid", advice.valid);
+        if (!advice.valid) {
+            json.attribute("reason", advice.reason);
+            return;
+        }
+        json.attribute("legal_orders", advice.num_legal);
+        json.attribute("orders", advice.num_orders);
+        json.attributeArray("best", [&] {
+            for (int k: advice.order) {
+                json.value(ind_vars[k]);
+            }
+        });
+        json.attributeObject("traffic", [&] {
+            for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                json.attributeObject(cache_level_names[c], [&] {
+                    json.attribute("before", advice.traffic[c]);
+                    json.attribute("after", advice.best_traffic[c]);
+                });
+            }
+        });
+        json.attributeObject("non_unit_strides", [&] {
+            json.attribute("before", advice.non_unit);
+            json.attribute("after", advice.best_non_unit);
+        });
+    }
+
+    void write(const std::string& func_name, const std::vector<std::string>& ind_vars,
+               const llvm::DebugLoc& loc, const interchange_advice_t& advice) {
+        if (!_json) {
+            return;
+        }
+        _json->object([&] {
+            writeLoopNest(func_name, ind_vars, loc);
+            writeAdvice(*_json, ind_vars, advice);
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,408 @@
+#ifndef JIT_H_
+#define JIT_H_
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "affine.h"
+#include "pattern.h"
+
+// Native dependence enumeration kernels. A kernel walks the iteration
+// space of one leaf loop nest with the bounds and subscript arithmetic
+// compiled in, updates the dense last-writer tables itself and calls back
+// into the analysis for the hash-table accesses and dependent pairs.
+
+// Callbacks of a kernel, ctx is the analysis
+struct jit_callbacks_t {
+    // Hash-table read / write of an element of an object
+    void (*read)(void* ctx, int object_id, int num_subs, const int* subs, long long iter);
+    void (*write)(void* ctx, int object_id, int num_subs, const int* subs, long long iter);
+    // Dense-table read of iteration iter that hit write_iter
+    void (*pair)(void* ctx, long long iter, long long write_iter);
+    // Every SAMPLE_MASK + 1 iterations; nonzero stops the kernel
+    int (*sample)(void* ctx, long long iters);
+};
+
+// Returns the number of iterations run: all of them, limit, or where
+// sample() stopped it
+typedef long long (*jit_kernel_t)(void* ctx, long long** tables, long long limit,
+                                  const jit_callbacks_t* callbacks);
+
+// A memory access of the nest, in the order the walk evaluates them
+struct jit_access_t {
+    PatNode* node;
+    bool write;
+    int object_id;
+    int table = -1; // index into the tables argument, -1: hash table
+    std::vector<long long> lo, extent, stride; // dense table geometry
+};
+
+struct jit_nest_t {
+    std::vector<int> start, end, step;
+    std::vector<std::string> ind_vars; // from the outermost loop
+    std::vector<jit_access_t> accesses;
+    long long sample_mask;
+};
+
+class DFGJIT {
+private:
+    std::unique_ptr<llvm::orc::LLJIT> _jit;
+    bool _failed = false;
+    // Kernels by the structure of their nest
+    std::unordered_map<std::string, jit_kernel_t> _kernels;
+
+    int _num_compiled = 0;
+    long long _num_hits = 0;
+    double _compile_time = 0;
+
+    // Kernels are not worth optimizing harder than this
+    static llvm::Expected<llvm::orc::ThreadSafeModule>
+    optimize(llvm::orc::ThreadSafeModule tsm, llvm::orc::MaterializationResponsibility&) {
+        tsm.withModuleDo([](llvm::Module& m) {
+            llvm::LoopAnalysisManager lam;
+            llvm::FunctionAnalysisManager fam;
+            llvm::CGSCCAnalysisManager cgam;
+            llvm::ModuleAnalysisManager mam;
+            llvm::PassBuilder pb;
+            pb.registerModuleAnalyses(mam);
+            pb.registerCGSCCAnalyses(cgam);
+            pb.registerFunctionAnalyses(fam);
+            pb.registerLoopAnalyses(lam);
+            pb.crossRegisterProxies(lam, fam, cgam, mam);
+            pb.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O2).run(m, mam);
+        });
+        return std::move(tsm);
+    }
+
+    bool init() {
+        if (_jit || _failed) {
+            return !_failed;
+        }
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        auto jit = llvm::orc::LLJITBuilder().create();
+        if (!jit) {
+            llvm::errs() << "DFGPass: cannot create JIT: "
+                         << llvm::toString(jit.takeError()) << "\n";
+            _failed = true;
+            return false;
+        }
+        _jit = std::move(*jit);
+        _jit->getIRTransformLayer().setTransform(optimize);
+        return true;
+    }
+
+    static void serialize(PatNode* pn, std::string& key) {
+        key += std::to_string(pn->getType()) + "(" + pn->getOp() + "," +
+               pn->getConstantNum() + "," + pn->getValueName();
+        for (auto child: pn->getChildren()) {
+            key += ",";
+            serialize(child, key);
+        }
+        key += ")";
+    }
+
+    static std::string getStructure(const jit_nest_t& nest) {
+        std::string key;
+        for (size_t k = 0; k < nest.start.size(); k++) {
+            key += nest.ind_vars[k] + "=" + std::to_string(nest.start[k]) + ":" +
+                   std::to_string(nest.end[k]) + ":" + std::to_string(nest.step[k]) + ";";
+        }
+        key += std::to_string(nest.sample_mask) + ";";
+        for (auto& acs: nest.accesses) {
+            key += (acs.write ? "W" : "R") + std::to_string(acs.object_id) + "/" +
+                   std::to_string(acs.table);
+            for (size_t d = 0; d < acs.lo.size(); d++) {
+                key += "/" + std::to_string(acs.lo[d]) + "," +
+                       std::to_string(acs.extent[d]) + "," + std::to_string(acs.stride[d]);
+            }
+            key += ":";
+            serialize(acs.node, key);
+            key += ";";
+        }
+        return key;
+    }
+
+    // IR of one kernel, following LoopUnrollAnalysis::getPatNodeValue
+    class KernelBuilder {
+    private:
+        const jit_nest_t& _nest;
+        llvm::LLVMContext& _ctx;
+        llvm::IRBuilder<> _b;
+        llvm::Function* _func;
+        llvm::Value* _ctx_arg;
+        llvm::Value* _limit;
+        llvm::Value* _read;
+        llvm::Value* _write;
+        llvm::Value* _pair;
+        llvm::Value* _sample;
+        llvm::FunctionType* _acs_type;
+        llvm::FunctionType* _pair_type;
+        llvm::FunctionType* _sample_type;
+        std::vector<llvm::Value*> _ind_vars; // allocas
+        std::vector<llvm::Value*> _tables;
+        llvm::Value* _iter;
+        llvm::Value* _subs;
+        std::map<std::string, llvm::Value*> _values; // ind vars in the body
+
+        llvm::Value* emitValue(PatNode* pn) {
+            auto type = pn->getType();
+            auto& children = pn->getChildren();
+            llvm::Value* unknown = _b.getInt32(-1000);
+            if (type == CONSTANT) {
+                long long value;
+                return parseConstant(pn, value) ? _b.getInt32((int)value) : unknown;
+            } else if (type == LOOP_IND_VAR) {
+                auto iter = _values.find(pn->getValueName());
+                return iter == _values.end() ? _b.getInt32(0) : iter->second;
+            } else if (type == CAST_INST) {
+                return children.size() == 1 ? emitValue(children[0]) : unknown;
+            } else if (type != BIN_OP) {
+                return unknown;
+            }
+            auto& op = pn->getOp();
+            if (op == "+") {
+                llvm::Value* sum = _b.getInt32(0);
+                for (auto child: children) {
+                    sum = _b.CreateAdd(sum, emitValue(child));
+                }
+                return sum;
+            }
+            if (children.size() != 2) {
+                return unknown;
+            }
+            llvm::Value* a = emitValue(children[0]);
+            llvm::Value* b = emitValue(children[1]);
+            if (op == "-") {
+                return _b.CreateSub(a, b);
+            } else if (op == "*") {
+                return _b.CreateMul(a, b);
+            } else if (op == "/") {
+                llvm::Value* zero = _b.CreateICmpEQ(b, _b.getInt32(0));
+                llvm::Value* quot = _b.CreateSDiv(a, _b.CreateSelect(zero, _b.getInt32(1), b));
+                return _b.CreateSelect(zero, unknown, quot);
+            } else if (op == "<<") {
+                // Shift counts wrap as on x86
+                return _b.CreateShl(a, _b.CreateAnd(b, 31));
+            } else if (op == ">>") {
+                return _b.CreateAShr(a, _b.CreateAnd(b, 31));
+            }
+            return unknown;
+        }
+
+        llvm::BasicBlock* newBlock(const char* name) {
+            return llvm::BasicBlock::Create(_ctx, name, _func);
+        }
+
+        void emitAccess(const jit_access_t& acs, llvm::Value* iter) {
+            auto& subscripts = acs.node->getChildren();
+            llvm::BasicBlock* next = newBlock("next");
+            if (acs.table < 0) {
+                for (size_t d = 0; d < subscripts.size(); d++) {
+                    _b.CreateStore(emitValue(subscripts[d]),
+                                   _b.CreateConstGEP1_32(_b.getInt32Ty(), _subs, d));
+                }
+                llvm::Value* args[] = {_ctx_arg, _b.getInt32(acs.object_id),
+                                       _b.getInt32(subscripts.size()), _subs, iter};
+                _b.CreateCall(_acs_type, acs.write ? _write : _read, args);
+                _b.CreateBr(next);
+                _b.SetInsertPoint(next);
+                return;
+            }
+
+            llvm::Value* idx = _b.getInt64(0);
+            llvm::Value* inside = _b.getTrue();
+            for (size_t d = 0; d < subscripts.size(); d++) {
+                llvm::Value* v = _b.CreateSub(_b.CreateSExt(emitValue(subscripts[d]), _b.getInt64Ty()),
+                                              _b.getInt64(acs.lo[d]));
+                inside = _b.CreateAnd(inside, _b.CreateICmpULT(v, _b.getInt64(acs.extent[d])));
+                idx = _b.CreateAdd(idx, _b.CreateMul(v, _b.getInt64(acs.stride[d])));
+            }
+            llvm::BasicBlock* hit = newBlock("dense");
+            _b.CreateCondBr(inside, hit, next);
+            _b.SetInsertPoint(hit);
+            llvm::Value* slot = _b.CreateGEP(_b.getInt64Ty(), _tables[acs.table], idx);
+            if (acs.write) {
+                _b.CreateStore(iter, slot);
+            } else {
+                llvm::Value* writer = _b.CreateLoad(_b.getInt64Ty(), slot);
+                llvm::BasicBlock* dep = newBlock("dep");
+                _b.CreateCondBr(_b.CreateICmpSGE(writer, _b.getInt64(0)), dep, next);
+                _b.SetInsertPoint(dep);
+                llvm::Value* args[] = {_ctx_arg, iter, writer};
+                _b.CreateCall(_pair_type, _pair, args);
+            }
+            _b.CreateBr(next);
+            _b.SetInsertPoint(next);
+        }
+
+        void emitBody() {
+            llvm::Value* iter = _b.CreateLoad(_b.getInt64Ty(), _iter);
+            llvm::BasicBlock* stop = newBlock("stop");
+            llvm::BasicBlock* run = newBlock("run");
+            _b.CreateCondBr(_b.CreateICmpEQ(iter, _limit), stop, run);
+            _b.SetInsertPoint(stop);
+            _b.CreateRet(iter);
+
+            _b.SetInsertPoint(run);
+            llvm::Value* done = _b.CreateAdd(iter, _b.getInt64(1));
+            llvm::BasicBlock* sample = newBlock("sample");
+            llvm::BasicBlock* body = newBlock("body");
+            _b.CreateCondBr(_b.CreateICmpEQ(_b.CreateAnd(done, _nest.sample_mask), _b.getInt64(0)),
+                            sample, body);
+            _b.SetInsertPoint(sample);
+            llvm::Value* args[] = {_ctx_arg, done};
+            llvm::Value* halt = _b.CreateCall(_sample_type, _sample, args);
+            _b.CreateCondBr(_b.CreateICmpNE(halt, _b.getInt32(0)), stop, body);
+
+            _b.SetInsertPoint(body);
+            for (size_t k = 0; k < _ind_vars.size(); k++) {
+                _values[_nest.ind_vars[k]] = _b.CreateLoad(_b.getInt32Ty(), _ind_vars[k]);
+            }
+            for (auto& acs: _nest.accesses) {
+                emitAccess(acs, iter);
+            }
+            _b.CreateStore(done, _iter);
+        }
+
+        void emitLoop(size_t k) {
+            llvm::BasicBlock* header = newBlock("header");
+            llvm::BasicBlock* body = newBlock("loop");
+            llvm::BasicBlock* exit = newBlock("exit");
+            _b.CreateStore(_b.getInt32(_nest.start[k]), _ind_vars[k]);
+            _b.CreateBr(header);
+            _b.SetInsertPoint(header);
+            llvm::Value* v = _b.CreateLoad(_b.getInt32Ty(), _ind_vars[k]);
+            _b.CreateCondBr(_b.CreateICmpSLT(v, _b.getInt32(_nest.end[k])), body, exit);
+            _b.SetInsertPoint(body);
+            if (k + 1 < _ind_vars.size()) {
+                emitLoop(k + 1);
+            } else {
+                emitBody();
+            }
+            v = _b.CreateLoad(_b.getInt32Ty(), _ind_vars[k]);
+            _b.CreateStore(_b.CreateAdd(v, _b.getInt32(_nest.step[k])), _ind_vars[k]);
+            _b.CreateBr(header);
+            _b.SetInsertPoint(exit);
+        }
+
+    public:
+        KernelBuilder(const jit_nest_t& nest, llvm::LLVMContext& ctx)
+            : _nest(nest), _ctx(ctx), _b(ctx) {}
+
+        void build(llvm::Module& m, const std::string& name) {
+            llvm::Type* i8p = _b.getInt8PtrTy();
+            llvm::Type* i32 = _b.getInt32Ty();
+            llvm::Type* i64 = _b.getInt64Ty();
+            llvm::Type* i64p = i64->getPointerTo();
+            _acs_type = llvm::FunctionType::get(_b.getVoidTy(),
+                                                {i8p, i32, i32, i32->getPointerTo(), i64}, false);
+            _pair_type = llvm::FunctionType::get(_b.getVoidTy(), {i8p, i64, i64}, false);
+            _sample_type = llvm::FunctionType::get(i32, {i8p, i64}, false);
+            llvm::StructType* callbacks_type = llvm::StructType::get(
+                _ctx, {_acs_type->getPointerTo(), _acs_type->getPointerTo(),
+                       _pair_type->getPointerTo(), _sample_type->getPointerTo()});
+            auto func_type = llvm::FunctionType::get(
+                i64, {i8p, i64p->getPointerTo(), i64, callbacks_type->getPointerTo()}, false);
+            _func = llvm::Function::Create(func_type, llvm::Function::ExternalLinkage, name, m);
+
+            auto args = _func->arg_begin();
+            _ctx_arg = &*args++;
+            llvm::Value* tables = &*args++;
+            _limit = &*args++;
+            llvm::Value* callbacks = &*args++;
+
+            _b.SetInsertPoint(newBlock("entry"));
+            auto getCallback = [&](int field) {
+                return _b.CreateLoad(callbacks_type->getElementType(field),
+                                     _b.CreateStructGEP(callbacks_type, callbacks, field));
+            };
+            _read = getCallback(0);
+            _write = getCallback(1);
+            _pair = getCallback(2);
+            _sample = getCallback(3);
+            size_t max_subs = 1;
+            for (auto& acs: _nest.accesses) {
+                max_subs = std::max(max_subs, acs.node->getChildren().size());
+                if (acs.table >= (int)_tables.size()) {
+                    _tables.resize(acs.table + 1);
+                }
+            }
+            for (size_t t = 0; t < _tables.size(); t++) {
+                _tables[t] = _b.CreateLoad(i64p, _b.CreateConstGEP1_32(i64p, tables, t));
+            }
+            for (size_t k = 0; k < _nest.start.size(); k++) {
+                _ind_vars.push_back(_b.CreateAlloca(i32));
+            }
+            _iter = _b.CreateAlloca(i64);
+            _subs = _b.CreateAlloca(i32, _b.getInt32(max_subs));
+            _b.CreateStore(_b.getInt64(0), _iter);
+
+            emitLoop(0);
+            _b.CreateRet(_b.CreateLoad(i64, _iter));
+        }
+    };
+
+public:
+    // Kernel of the nest, compiled on first use; null if the JIT is not
+    // available
+    jit_kernel_t getKernel(const jit_nest_t& nest) {
+        std::string structure = getStructure(nest);
+        auto iter = _kernels.find(structure);
+        if (iter != _kernels.end()) {
+            _num_hits++;
+            return iter->second;
+        }
+        if (nest.start.empty() || !init()) {
+            return nullptr;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::string name = "dfg_kernel_" + std::to_string(_num_compiled);
+        auto ctx = std::make_unique<llvm::LLVMContext>();
+        auto m = std::make_unique<llvm::Module>(name, *ctx);
+        m->setDataLayout(_jit->getDataLayout());
+        KernelBuilder(nest, *ctx).build(*m, name);
+        if (llvm::verifyModule(*m, &llvm::errs())) {
+            _failed = true;
+            return nullptr;
+        }
+        jit_kernel_t kernel = nullptr;
+        auto error = _jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(m), std::move(ctx)));
+        if (!error) {
+            auto sym = _jit->lookup(name);
+            if (sym) {
+                kernel = (jit_kernel_t)sym->getAddress();
+            } else {
+                error = sym.takeError();
+            }
+        }
+        if (error) {
+            llvm::errs() << "DFGPass: cannot compile kernel: "
+                         << llvm::toString(std::move(error)) << "\n";
+        }
+        _num_compiled++;
+        _compile_time += std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start).count();
+        _kernels[structure] = kernel;
+        return kernel;
+    }
+
+    int getNumCompiled() { return _num_compiled; }
+    long long getNumHits() { return _num_hits; }
+    double getCompileTime() { return _compile_time; }
+};
+
+#endif
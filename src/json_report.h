@@ -0,0 +1,73 @@
+#ifndef JSON_REPORT_H_
+#define JSON_REPORT_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Report file of the pass; null, with a message, if it cannot be written
+inline std::unique_ptr<llvm::raw_fd_ostream> openReportFile(const std::string& file) {
+    std::error_code error;
+    std::unique_ptr<llvm::raw_fd_ostream> os(
+        new llvm::raw_fd_ostream(file, error, llvm::sys::fs::OF_Text));
+    if (error) {
+        llvm::errs() << "Cannot open " << file << ": " << error.message() << "\n";
+        os.reset();
+    }
+    return os;
+}
+
+// A report written as a JSON list: open begins the list, the write methods
+// of each report add its elements, close ends it. Nothing is written while
+// the report is not open.
+class JSONListReport {
+protected:
+    std::unique_ptr<llvm::raw_fd_ostream> _os;
+    std::unique_ptr<llvm::json::OStream> _json;
+
+    // The function, ind vars and location of a loop nest, as object
+    // attributes
+    void writeLoopNest(const std::string& func_name, const std::vector<std::string>& ind_vars,
+                       const llvm::DebugLoc& loc) {
+        _json->attribute("function", func_name);
+        _json->attributeArray("loops", [&] {
+            for (auto& ind_var: ind_vars) {
+                _json->value(ind_var);
+            }
+        });
+        if (loc) {
+            _json->attribute("file", loc->getFilename());
+            _json->attribute("line", (int64_t)loc.getLine());
+        }
+    }
+
+public:
+    bool open(const std::string& file) {
+        _os = openReportFile(file);
+        if (!_os) {
+            return false;
+        }
+        _json.reset(new llvm::json::OStream(*_os, 2));
+        _json->arrayBegin();
+        return true;
+    }
+
+    bool isOpen() { return _json != nullptr; }
+
+    void close() {
+        if (!_json) {
+            return;
+        }
+        _json->arrayEnd();
+        _json->flush();
+        *_os << "\n";
+        _json.reset();
+        _os.reset();
+    }
+};
+
+#endif
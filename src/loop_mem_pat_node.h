@@ -1,5 +1,6 @@
 #ifndef LOOP_MEM_PAT_NODE_H_
 #define LOOP_MEM_PAT_NODE_H_
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -15,16 +16,27 @@ enum loop_mem_pat_node_type_t {
 class LoopPat {
 private:
     std::string _ind_var; // for loop ind var
-    PatNode* _start;
-    PatNode* _end;
-    PatNode* _step;
+    PatNode* _start = nullptr;
+    PatNode* _end = nullptr;
+    PatNode* _step = nullptr;
 
 public:
-    LoopPat() {_ind_var = std::string(" ");}
+    LoopPat() {
+        _ind_var = std::string(" ");
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, getMemBytes());
+    }
     LoopPat(std::string& ind_var) :
-        _ind_var(std::string(ind_var)) {}
+        _ind_var(std::string(ind_var)) {
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, getMemBytes());
+    }
     LoopPat(std::string& ind_var, PatNode* start, PatNode* end, PatNode* step) :
-        _ind_var(std::string(ind_var)), _start(start), _end(end), _step(step) {}    
+        _ind_var(std::string(ind_var)), _start(start), _end(end), _step(step) {
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, getMemBytes());
+    }
+    ~LoopPat() { MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, -getMemBytes()); }
+
+    long long getMemBytes() { return sizeof(LoopPat) + heapBytes(_ind_var); }
+
     void dump(int depth) {
         // do nothing now
         std::cout << _ind_var << std::endl;
@@ -37,28 +49,44 @@ public:
         return _ind_var;
     }
 
-    int getStartVal() {
-        if (_start->getType() == CONSTANT) {
-            int val = stoi(_start->getConstantNum());
-            return val;
+    // Value of a bound if it is an integer constant (loop-invariant values
+    // and outer ind vars are CONSTANT nodes too, named after the value)
+    static bool getConstVal(PatNode* pn, int& val) {
+        if (!pn || pn->getType() != CONSTANT) {
+            return false;
+        }
+        const std::string& str = pn->getConstantNum();
+        char* end;
+        long v = strtol(str.c_str(), &end, 10);
+        if (end == str.c_str() || *end != '\0') {
+            return false;
         }
-        return 0;
+        val = v;
+        return true;
+    }
+
+    bool hasConstantBounds() {
+        int val;
+        return getConstVal(_start, val) && getConstVal(_end, val) &&
+               getConstVal(_step, val);
+    }
+
+    int getStartVal() {
+        int val = 0;
+        getConstVal(_start, val);
+        return val;
     }
 
     int getEndVal() {
-        if (_end->getType() == CONSTANT) {
-            int val = stoi(_end->getConstantNum());
-            return val;
-        }
-        return 0;
+        int val = 0;
+        getConstVal(_end, val);
+        return val;
     }
 
     int getStepVal() {
-        if (_step->getType() == CONSTANT) {
-            int val = stoi(_step->getConstantNum());
-            return val;
-        }
-        return 0;
+        int val = 0;
+        getConstVal(_step, val);
+        return val;
     }
 };
 
@@ -73,7 +101,10 @@ private:
     access_mode_t _mode;
 public:
     MemAcsPat(PatNode* pat, access_mode_t mode)
-     : _pat(pat), _mode(mode) {}
+     : _pat(pat), _mode(mode) {
+        MemAccount::add(MEM_MEM_ACS_PAT, 1, sizeof(MemAcsPat));
+    }
+    ~MemAcsPat() { MemAccount::add(MEM_MEM_ACS_PAT, -1, -(long long)sizeof(MemAcsPat)); }
     void dump(int depth) {
         dumpPattern(_pat, depth);
     }
@@ -85,6 +116,50 @@ public:
     }
 };
 
+// A cycle (strongly connected component) of the data-flow graph whose
+// instructions all belong to one loop
+class RecurrencePat {
+private:
+    std::string _kind; // induction, reduction (scalar phi), memory, other
+    int _num_nodes;
+    int _num_phis;
+    int _num_loads;
+    int _num_stores;
+    int _num_ops; // arithmetic instructions on the cycle
+    int _path_len; // longest chain of recurrences ending at this one
+
+public:
+    RecurrencePat(const std::string& kind, int num_nodes, int num_phis,
+                  int num_loads, int num_stores, int num_ops, int path_len)
+     : _kind(kind), _num_nodes(num_nodes), _num_phis(num_phis),
+       _num_loads(num_loads), _num_stores(num_stores), _num_ops(num_ops),
+       _path_len(path_len) {
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, getMemBytes());
+    }
+    ~RecurrencePat() { MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, -getMemBytes()); }
+
+    long long getMemBytes() { return sizeof(RecurrencePat) + heapBytes(_kind); }
+
+    void dump(int depth) {
+        for (int i = 0; i < depth; i++) {
+            std::cout << ' ';
+        }
+        std::cout << "recurrence: " << _kind << " nodes=" << _num_nodes
+                  << " phis=" << _num_phis << " loads=" << _num_loads
+                  << " stores=" << _num_stores << " ops=" << _num_ops
+                  << " chain=" << _path_len << std::endl;
+    }
+
+    const std::string& getKind() { return _kind; }
+    int getNumNodes() { return _num_nodes; }
+    int getNumOps() { return _num_ops; }
+    int getPathLen() { return _path_len; }
+
+    // Induction variable cycles are present in every loop and do not bound
+    // its throughput
+    bool isBounding() { return _kind != "induction"; }
+};
+
 class LoopMemPatNode {
 private:
     loop_mem_pat_node_type_t type;
@@ -94,6 +169,10 @@ private:
     int num_children;
     std::vector<LoopMemPatNode *> children;
     LoopMemPatNode* _parent = nullptr;
+    std::vector<RecurrencePat *> _recurrences;
+    // Why the loop is assumed to carry dependences without analyzing it,
+    // empty if it was analyzed
+    std::string _assumed_dep_reason;
 
 public:
     LoopMemPatNode(loop_mem_pat_node_type_t type, const std::string& func_name)
@@ -101,27 +180,40 @@ public:
         num_children = 0; 
         loop_pat = nullptr;
         mem_acs_pat = nullptr; 
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 1, getMemBytes());
      }
     LoopMemPatNode(loop_mem_pat_node_type_t type, LoopPat* _loop_pat)
      : type(static_cast<loop_mem_pat_node_type_t>(type)) {
         loop_pat = _loop_pat;
         num_children = 0; 
         mem_acs_pat = nullptr;
-
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 1, getMemBytes());
      }
     LoopMemPatNode(loop_mem_pat_node_type_t type, MemAcsPat* _mem_acs_pat)
      : type(static_cast<loop_mem_pat_node_type_t>(type)) { 
         num_children = 0; 
         loop_pat = nullptr;
         mem_acs_pat = _mem_acs_pat;
-
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 1, getMemBytes());
      }
-    
+    ~LoopMemPatNode() {
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, -1, -getMemBytes());
+    }
+
+    // Not including the LoopPat / RecurrencePat, which account for
+    // themselves
+    long long getMemBytes() {
+        return sizeof(LoopMemPatNode) + heapBytes(func_name) +
+               heapBytes(children) + heapBytes(_recurrences);
+    }
+
 
     void addChild(LoopMemPatNode * child) {
+        long long old_bytes = heapBytes(children);
         num_children ++; 
         children.push_back(child);
         child->addParent(this);
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, heapBytes(children) - old_bytes);
     }
 
     void addParent(LoopMemPatNode * parent){
@@ -183,6 +275,37 @@ public:
         }
     }
 
+    void addRecurrence(RecurrencePat* rec) {
+        long long old_bytes = heapBytes(_recurrences);
+        _recurrences.push_back(rec);
+        MemAccount::add(MEM_LOOP_MEM_PAT_NODE, 0, heapBytes(_recurrences) - old_bytes);
+    }
+
+    std::vector<RecurrencePat *>& getRecurrences() {
+        return _recurrences;
+    }
+
+    bool isRecurrenceBound() {
+        for (auto rec: _recurrences) {
+            if (rec->isBounding()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void setAssumedDependent(const std::string& reason) {
+        _assumed_dep_reason = reason;
+    }
+
+    bool isAssumedDependent() {
+        return !_assumed_dep_reason.empty();
+    }
+
+    const std::string& getAssumedDepReason() {
+        return _assumed_dep_reason;
+    }
+
     MemAcsPat* getMemAcsPat() {
         //         if (mem_acs_pat == nullptr) {
         //     std::cout << "mem_acs_pat is nullptr" << std::endl;
@@ -216,6 +339,16 @@ void dumpLoopMemPatTree(LoopMemPatNode *node, int depth) {
     } else {
         std::cout << "none loop_pat";
     }
+    for (auto rec : node->getRecurrences()) {
+        rec->dump(depth);
+    }
+    if (node->isAssumedDependent()) {
+        for (int i = 0; i < depth; i++) {
+            std::cout << ' ';
+        }
+        std::cout << "assumed dependent: " << node->getAssumedDepReason()
+                  << std::endl;
+    }
   } else if (type == MEM_ACS_NODE) {
     auto mem_acs_pat = node->getMemAcsPat();
     if (mem_acs_pat) {
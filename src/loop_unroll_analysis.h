@@ -1,53 +1,969 @@
 #ifndef LOOP_UNROLL_ANALYSIS_H_
 #define LOOP_UNROLL_ANALYSIS_H_
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <set>
 #include <unordered_map>
+#include <utility>
 #include <map>
 #include <string>
 #include <vector>
 
+#include "affine.h"
+#include "jit.h"
 #include "loop_mem_pat_node.h"
+#include "mem_stats.h"
+#include "progress.h"
+#include "spill.h"
+#include "stencil.h"
+#include "stride.h"
+#include "unroll.h"
+#include "cache_model.h"
+#include "cache_sim.h"
+#include "interchange.h"
+#include "tiling.h"
+#include "wavefront.h"
 
 class ArrayPos {
 private:
-    int _i;
-    int _j;
+    std::vector<int> _pos; // ind var values, from the outermost loop
 public:
     // ArrayPos(ArrayPos ap) {
     //     _i = ap.getI();
     //     _j = ap.getJ();
     // }
 
-    ArrayPos(int i, int j):
-        _i(i), _j(j) {}
+    ArrayPos(const std::vector<int>& pos):
+        _pos(pos) {}
     
     void dump() {
-        std::cout << _i << "," << _j ;
+        for (size_t k = 0; k < _pos.size(); k++) {
+            if (k > 0) {
+                std::cout << ",";
+            }
+            std::cout << _pos[k];
+        }
     }
 
-    int getI() {return _i;}
-    int getJ() {return _j;}
+    std::vector<int>& getPos() {return _pos;}
 };
 
 // int convertToOffset(int i, int j, int nx, int ny) {
 //     return i * ny + j;
 // }
 
+// Last-writer table of one array over the bounding box of its subscripts,
+// indexed by the linearized subscript. Holds the iteration number of the
+// last write, -1 if none.
+struct dense_table_t {
+    std::vector<long long> lo;     // per subscript
+    std::vector<long long> extent;
+    std::vector<long long> stride;
+    std::vector<long long> last_writer;
+};
+
+typedef std::unordered_map<std::string, ArrayPos> offset_map_t;
+
+// Hash table entries written in one outer iteration, for windowed eviction.
+// Keys point into the table nodes, which stay put until erased.
+struct window_block_t {
+    int outer_pos; // ind var value of the outermost loop
+    std::vector<std::pair<offset_map_t*, const std::string*>> keys;
+};
+
+// A memory access of the leaf loop, with what the walk needs per iteration
+struct access_t {
+    PatNode* node;
+    std::string object;
+    int object_id;        // key prefix of spilled accesses
+    dense_table_t* dense; // nullptr: use the hash table
+};
+
+// Spilled accesses are records of
+//   long long seq;  // read sequence number, unused for writes
+//   long long iter; // iteration number
+//   int object_id, num_subscripts, subscripts[num_subscripts];
+// where everything after the two numbers is the key of the element.
+static const size_t SPILL_HEADER_SIZE = 2 * sizeof(long long);
+
+// Element of a hash-table access in the specialized kernels: object id and
+// up to three subscripts
+typedef std::array<int, 4> elem_key_t;
+
+struct elem_key_hash {
+    size_t operator()(const elem_key_t& key) const {
+        size_t h = key[0];
+        for (int i = 1; i < 4; i++) {
+            h = (h ^ (unsigned)key[i]) * 0x9e3779b97f4a7c15ULL;
+        }
+        return h ^ (h >> 29);
+    }
+};
+
+// Access with affine subscripts c[s] + sum(coeff[s][k] * ind var k), for
+// the kernels specialized on nest depth D and subscript count S. The sums
+// wrap like the int arithmetic of getPatNodeValue.
+template <int D, int S>
+struct affine_access_t {
+    unsigned coeff[S][D];
+    unsigned c[S];
+    int object_id;
+    dense_table_t* dense;
+};
+
+template <int D, int S>
+struct affine_walk_t {
+    int iv[D];
+    int end[D];
+    long long iter = 0;   // iterations run
+    long long limit = -1; // iteration budget, -1 = none
+    bool stopped = false; // by the deadline
+    std::vector<affine_access_t<D, S>> reads, writes;
+};
+
+template <int D, size_t... K>
+inline unsigned affineSum(const unsigned* coeff, const int* iv, std::index_sequence<K...>) {
+    return (0u + ... + (coeff[K] * (unsigned)iv[K]));
+}
+
+template <int D, int S, size_t... I>
+inline void evalAffine(const affine_access_t<D, S>& acs, const int* iv, int* subs,
+                       std::index_sequence<I...>) {
+    ((subs[I] = (int)(acs.c[I] + affineSum<D>(acs.coeff[I], iv, std::make_index_sequence<D>()))),
+     ...);
+}
+
+// Dependent pair found by the out-of-core join
+struct spill_pair_t {
+    long long seq;        // read sequence number, the order of the pairs
+    long long read_iter;
+    long long write_iter;
+};
+
 class LoopUnrollAnalysis {
 private:
     // A -> offset -> position 
 
     LoopMemPatNode* _loop; // must be a leaf loop node
 
-    std::unordered_map<std::string, std::unordered_map<std::string, ArrayPos*>> _w_mem_acs; 
+    std::unordered_map<std::string, offset_map_t> _w_mem_acs; 
     
     std::map<std::string, int> _cur_ind_var_value_map;
 
-    std::vector<std::pair<ArrayPos, ArrayPos>> _intra_iter_dep;
+    // Dependent pairs are printed to _dep_os as they are found. Only what
+    // the analyses after checkDependence use is kept of them.
+    std::ostream* _dep_os = &std::cout; // nullptr: do not print
+    long long _num_pairs = 0;
+    std::vector<bool> _carried;            // levels carrying a pair
+    std::set<dist_vec_t> _flow_dists;      // up to WAVEFRONT_MAX_DISTANCES + 1
+    long long _flow_max_jam = LLONG_MAX;   // getMaxLegalJam over the pairs
+    long long _flow_outer_reuse = 0;       // smallest outer distance, 0 = none
+    long long _flow_inner_dist = 0;        // smallest leaf distance, 0 = none
+    std::vector<dist_t> _pair_dist;
+    dist_vec_t _pair_dist_vec;
+
+    long long _num_iters = 0; // enumerated iterations
+    long long _num_acs = 0;   // evaluated memory accesses
+
+    ProgressReporter* _progress = nullptr;
+
+    // Budget of checkDependence; when it runs out the loop is assumed
+    // dependent for the given reason
+    long long _max_iters = 0; // 0 = unlimited
+    std::string _iters_reason;
+    bool _has_deadline = false;
+    std::chrono::steady_clock::time_point _deadline;
+    std::string _deadline_reason;
+
+    std::string _assumed_dep_reason;
+
+    // Dense last-writer tables, by object name
+    std::map<std::string, dense_table_t> _dense_tables;
+    long long _dense_limit = 0; // bytes, 0 = never use dense tables
+
+    // Iteration space of the nest, to decode iteration numbers
+    std::vector<int> _start;
+    std::vector<int> _step;
+    std::vector<long long> _trip;
+
+    // Sliding window over outer iterations for the hash tables: writes more
+    // than _window outer iterations old are evicted
+    bool _windowed = false;
+    int _window_param = -1; // -1: derive from the subscripts
+    long long _window = -1; // in effect, -1: keep everything
+    std::deque<window_block_t> _window_blocks;
+
+    // Out-of-core enumeration, for nests whose hash tables would not fit
+    // in memory: hash-table accesses are appended to on-disk runs,
+    // partitioned by element, and reads are joined with writes one
+    // partition at a time
+    std::string _spill_dir;          // empty = never spill
+    long long _spill_threshold = 0;  // bytes of in-memory tables to spill at
+    int _num_partitions = 1;
+    bool _spilled = false;
+    std::map<std::string, int> _object_ids;
+    std::vector<std::unique_ptr<SpillRun>> _spill_reads;
+    std::vector<std::unique_ptr<SpillRun>> _spill_writes;
+    // Runs of spill_pair_t, each sorted by seq: pairs of the dense tables
+    // first, then one run per joined partition
+    std::vector<std::unique_ptr<SpillRun>> _spill_pairs;
+    long long _spill_bytes = 0;
+    mem_usage_t _spill_join_mem; // largest partition join table
+    std::string _key; // element key of spilled and JIT hash-table accesses
+    std::vector<int> _subs;
+
+    // JIT-compiled enumeration of nests of at least _jit_min_iters
+    // iterations. Its hash table maps element keys to the last writer.
+    DFGJIT* _jit = nullptr;
+    long long _jit_min_iters = 0;
+    bool _jitted = false;
+    bool _jit_stopped = false; // by the deadline
+    long long _jit_iters_start = 0;
+    std::unordered_map<std::string, long long> _jit_last_writer;
+
+    // Kernels specialized on nest depth and subscript count, for nests of
+    // affine accesses
+    bool _specialize = false;
+    bool _specialized = false;
+    std::unordered_map<elem_key_t, long long, elem_key_hash> _elem_last_writer;
+
+    // Range pre-screen
+    bool _prescreen = true;
+    int _num_skipped_acs = 0;  // accesses dropped by the pre-screen
+    bool _skipped_loop = false; // no read may hit any write
+
+    void assumeDependent(const std::string& reason) {
+        _assumed_dep_reason = reason;
+        // Partial results are meaningless, free them
+        _carried.assign(_carried.size(), false);
+        _flow_dists.clear();
+        _flow_max_jam = LLONG_MAX;
+        _flow_outer_reuse = 0;
+        _flow_inner_dist = 0;
+        _w_mem_acs.clear();
+        _dense_tables.clear();
+        _window_blocks.clear();
+        _spill_reads.clear();
+        _spill_writes.clear();
+        _spill_pairs.clear();
+        _jit_last_writer.clear();
+        _elem_last_writer.clear();
+    }
+
+    static long long floorDiv(long long a, long long b) {
+        long long q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    // Largest distance of the outermost ind var between a read and a write
+    // that can touch the same element, or -1 if there is no bound. For a subscript
+    // c * o + e_r of the read and c * o + e_w of the write (o the outermost
+    // ind var, e_r and e_w free of o), equal values need
+    // c * (r_o - w_o) = e_w - e_r.
+    long long deriveWindow(std::vector<access_t>& reads, std::vector<access_t>& writes,
+                           const std::string& outer,
+                           const std::map<std::string, Interval>& ind_var_ranges) {
+        long long window = 0;
+        for (auto& r: reads) {
+            for (auto& w: writes) {
+                auto& r_subs = r.node->getChildren();
+                auto& w_subs = w.node->getChildren();
+                if (r.dense || w.dense || r.object != w.object ||
+                    r_subs.size() != w_subs.size()) {
+                    continue;
+                }
+                long long pair_window = -1;
+                for (size_t d = 0; d < r_subs.size(); d++) {
+                    AffineExpr e_r = AffineExpr::fromPattern(r_subs[d]);
+                    AffineExpr e_w = AffineExpr::fromPattern(w_subs[d]);
+                    long long c = e_r.getCoeff(outer);
+                    if (!e_r.isValid() || !e_w.isValid() || c == 0 ||
+                        e_w.getCoeff(outer) != c) {
+                        continue;
+                    }
+                    e_r.add(AffineExpr::indVar(outer), -c);
+                    e_w.add(AffineExpr::indVar(outer), -c);
+                    Interval range_r = e_r.getRange(ind_var_ranges);
+                    Interval range_w = e_w.getRange(ind_var_ranges);
+                    if (!range_r.known || !range_w.known) {
+                        continue;
+                    }
+                    long long lo = range_w.lo - range_r.hi;
+                    long long hi = range_w.hi - range_r.lo;
+                    long long dist = c > 0 ? floorDiv(hi, c) : floorDiv(lo, c);
+                    dist = std::max(dist, 0LL);
+                    if (pair_window < 0 || dist < pair_window) {
+                        pair_window = dist;
+                    }
+                }
+                if (pair_window < 0) {
+                    return -1;
+                }
+                window = std::max(window, pair_window);
+            }
+        }
+        return window;
+    }
+
+    // Drop the hash table entries of outer iterations that fell out of the
+    // window, unless a later iteration overwrote them
+    void evictWindow(int outer_pos, int outer_step) {
+        while (!_window_blocks.empty() &&
+               (outer_pos - _window_blocks.front().outer_pos) / outer_step > _window) {
+            window_block_t& block = _window_blocks.front();
+            for (auto& key: block.keys) {
+                auto iter = key.first->find(*key.second);
+                if (iter->second.getPos()[0] == block.outer_pos) {
+                    key.first->erase(iter);
+                }
+            }
+            _window_blocks.pop_front();
+        }
+    }
+
+    // Ind var values of an iteration number
+    ArrayPos decodeIteration(long long iter) {
+        std::vector<int> pos(_trip.size());
+        for (int k = _trip.size() - 1; k >= 0; k--) {
+            pos[k] = _start[k] + (iter % _trip[k]) * _step[k];
+            iter /= _trip[k];
+        }
+        return ArrayPos(pos);
+    }
+
+    // Linearized subscript in the dense table, -1 if outside of it
+    long long getDenseIndex(access_t& acs) {
+        dense_table_t& table = *acs.dense;
+        auto& subscripts = acs.node->getChildren();
+        long long idx = 0;
+        for (size_t d = 0; d < subscripts.size(); d++) {
+            long long v = getPatNodeValue(subscripts[d]) - table.lo[d];
+            if (v < 0 || v >= table.extent[d]) {
+                return -1;
+            }
+            idx += v * table.stride[d];
+        }
+        return idx;
+    }
+
+    // Give dense tables to the written objects whose accesses all have
+    // known subscript ranges and the same number of subscripts, smallest
+    // first, as long as they fit under the memory limit
+    void selectDenseTables(std::vector<MemAcsPat*>& reads, std::vector<MemAcsPat*>& writes,
+                           const std::map<std::string, Interval>& ind_var_ranges) {
+        std::map<std::string, std::vector<Interval>> boxes;
+        std::map<std::string, bool> eligible;
+        std::map<std::string, bool> written;
+        for (auto mode: {READ, WRITE}) {
+            for (auto mem_acs_pat: (mode == READ ? reads : writes)) {
+                auto node = mem_acs_pat->getPatNode();
+                const std::string& object = node->getValueName();
+                std::vector<Interval> ranges;
+                bool known = true;
+                for (auto child: node->getChildren()) {
+                    ranges.push_back(getPatternRange(child, ind_var_ranges));
+                    known = known && ranges.back().known;
+                }
+                if (mode == WRITE) {
+                    written[object] = true;
+                }
+                auto iter = boxes.find(object);
+                if (iter == boxes.end()) {
+                    boxes[object] = ranges;
+                    eligible[object] = known;
+                    continue;
+                }
+                auto& box = iter->second;
+                if (!known || box.size() != ranges.size()) {
+                    eligible[object] = false;
+                    continue;
+                }
+                for (size_t d = 0; d < box.size(); d++) {
+                    box[d].lo = std::min(box[d].lo, ranges[d].lo);
+                    box[d].hi = std::max(box[d].hi, ranges[d].hi);
+                }
+            }
+        }
+
+        std::vector<std::pair<long long, std::string>> candidates;
+        long long max_slots = _dense_limit / sizeof(long long);
+        for (auto& obj: boxes) {
+            if (!eligible[obj.first] || !written[obj.first]) {
+                continue;
+            }
+            long long slots = 1;
+            for (auto& range: obj.second) {
+                slots *= range.hi - range.lo + 1;
+                if (slots > max_slots) {
+                    break;
+                }
+            }
+            if (slots <= max_slots) {
+                candidates.push_back(std::make_pair(slots, obj.first));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        long long total_slots = 0;
+        for (auto& candidate: candidates) {
+            if (total_slots + candidate.first > max_slots) {
+                break;
+            }
+            total_slots += candidate.first;
+            auto& box = boxes[candidate.second];
+            dense_table_t& table = _dense_tables[candidate.second];
+            int dims = box.size();
+            table.lo.resize(dims);
+            table.extent.resize(dims);
+            table.stride.resize(dims);
+            long long stride = 1;
+            for (int d = dims - 1; d >= 0; d--) {
+                table.lo[d] = box[d].lo;
+                table.extent[d] = box[d].hi - box[d].lo + 1;
+                table.stride[d] = stride;
+                stride *= table.extent[d];
+            }
+            table.last_writer.assign(candidate.first, -1);
+        }
+    }
+
+    std::vector<access_t> getAccesses(std::vector<MemAcsPat*>& mem_acs_pats) {
+        std::vector<access_t> accesses;
+        for (auto mem_acs_pat: mem_acs_pats) {
+            access_t acs;
+            acs.node = mem_acs_pat->getPatNode();
+            acs.object = acs.node->getValueName();
+            acs.object_id = _object_ids.emplace(acs.object, _object_ids.size()).first->second;
+            auto iter = _dense_tables.find(acs.object);
+            acs.dense = iter == _dense_tables.end() ? nullptr : &iter->second;
+            accesses.push_back(acs);
+        }
+        return accesses;
+    }
+
+    // Worst case of the in-memory tables of the hash-table accesses: every
+    // write a new element and every read dependent
+    long long estimateTableBytes(std::vector<access_t>& read_acs,
+                                 std::vector<access_t>& write_acs, long long num_iters) {
+        long long pos_bytes = _trip.size() * sizeof(int);
+        long long per_iter = 0;
+        for (auto& acs: write_acs) {
+            if (!acs.dense) {
+                per_iter += hashNodeBytes<std::pair<const std::string, ArrayPos>>() +
+                            pos_bytes + 8 * acs.node->getChildren().size();
+            }
+        }
+        for (auto& acs: read_acs) {
+            if (!acs.dense) {
+                per_iter += sizeof(std::pair<ArrayPos, ArrayPos>) + 2 * pos_bytes;
+            }
+        }
+        if (per_iter > 0 && num_iters > LLONG_MAX / per_iter) {
+            return LLONG_MAX;
+        }
+        return num_iters * per_iter;
+    }
+
+    bool openSpill() {
+        _spilled = true;
+        for (int p = 0; p < _num_partitions; p++) {
+            _spill_reads.emplace_back(new SpillRun());
+            _spill_writes.emplace_back(new SpillRun());
+            if (!_spill_reads.back()->open(_spill_dir) ||
+                !_spill_writes.back()->open(_spill_dir)) {
+                return false;
+            }
+        }
+        _spill_pairs.emplace_back(new SpillRun());
+        return _spill_pairs.back()->open(_spill_dir);
+    }
+
+    static size_t getSpillKeySize(const char* record) {
+        int num_subscripts;
+        memcpy(&num_subscripts, record + SPILL_HEADER_SIZE + sizeof(int), sizeof(int));
+        return (2 + num_subscripts) * sizeof(int);
+    }
+
+    // Element key: object id, number of subscripts and their values
+    void makeKey(int object_id, int num_subs, const int* subs) {
+        _key.resize((2 + num_subs) * sizeof(int));
+        int header[2] = {object_id, num_subs};
+        memcpy(&_key[0], header, sizeof(header));
+        memcpy(&_key[sizeof(header)], subs, num_subs * sizeof(int));
+    }
+
+    // Append the access to the run of the partition of its element
+    void spillAccess(access_t& acs, long long seq, long long iter,
+                     std::vector<std::unique_ptr<SpillRun>>& runs) {
+        auto& subscripts = acs.node->getChildren();
+        _subs.resize(subscripts.size());
+        for (size_t d = 0; d < subscripts.size(); d++) {
+            _subs[d] = getPatNodeValue(subscripts[d]);
+        }
+        makeKey(acs.object_id, _subs.size(), _subs.data());
+        SpillRun& run = *runs[std::hash<std::string>()(_key) % runs.size()];
+        long long header[2] = {seq, iter};
+        run.append(header, sizeof(header));
+        run.append(_key.data(), _key.size());
+    }
+
+    // Replay the writes of a partition in iteration order, and look every
+    // read up in the last-writer table of the iterations before it
+    bool joinPartition(int p) {
+        SpillRun& reads = *_spill_reads[p];
+        SpillRun& writes = *_spill_writes[p];
+        std::unique_ptr<SpillRun> pairs(new SpillRun());
+        if (!reads.map() || !writes.map() || !pairs->open(_spill_dir)) {
+            return false;
+        }
+        std::unordered_map<std::string, long long> last_writer;
+        const char* w = writes.begin();
+        for (const char* r = reads.begin(); r < reads.end();) {
+            long long r_header[2];
+            memcpy(r_header, r, sizeof(r_header));
+            while (w < writes.end()) {
+                long long w_header[2];
+                memcpy(w_header, w, sizeof(w_header));
+                if (w_header[1] >= r_header[1]) {
+                    break;
+                }
+                size_t size = getSpillKeySize(w);
+                last_writer[std::string(w + SPILL_HEADER_SIZE, size)] = w_header[1];
+                w += SPILL_HEADER_SIZE + size;
+            }
+            size_t size = getSpillKeySize(r);
+            auto iter = last_writer.find(std::string(r + SPILL_HEADER_SIZE, size));
+            if (iter != last_writer.end()) {
+                spill_pair_t pair = {r_header[0], r_header[1], iter->second};
+                pairs->append(&pair, sizeof(pair));
+            }
+            r += SPILL_HEADER_SIZE + size;
+        }
+
+        mem_usage_t join_mem;
+        join_mem.add(MEM_WRITE_TABLE, 0, last_writer.bucket_count() * sizeof(void*));
+        for (auto& entry: last_writer) {
+            join_mem.add(MEM_WRITE_TABLE, 1,
+                         hashNodeBytes<std::pair<const std::string, long long>>() +
+                         heapBytes(entry.first));
+        }
+        if (join_mem.getTotalBytes() > _spill_join_mem.getTotalBytes()) {
+            _spill_join_mem = join_mem;
+        }
+        _spill_bytes += reads.getBytes() + writes.getBytes() + pairs->getBytes();
+        _spill_reads[p].reset();
+        _spill_writes[p].reset();
+        if (!pairs->map()) {
+            return false;
+        }
+        _spill_pairs.push_back(std::move(pairs));
+        return true;
+    }
+
+    void joinSpill() {
+        SpillRun& dense_pairs = *_spill_pairs[0];
+        if (!dense_pairs.map()) {
+            assumeDependent("spill I/O error in " + _spill_dir);
+            return;
+        }
+        _spill_bytes += dense_pairs.getBytes();
+        for (int p = 0; p < _num_partitions; p++) {
+            if (_has_deadline && std::chrono::steady_clock::now() >= _deadline) {
+                assumeDependent(_deadline_reason);
+                return;
+            }
+            if (!joinPartition(p)) {
+                assumeDependent("spill I/O error in " + _spill_dir);
+                return;
+            }
+        }
+        mergeSpilledPairs();
+        _spill_pairs.clear();
+    }
+
+    // Add the spilled pairs in enumeration order, merged from their runs
+    // by read sequence number
+    void mergeSpilledPairs() {
+        typedef std::pair<long long, size_t> head_t; // seq, run
+        std::priority_queue<head_t, std::vector<head_t>, std::greater<head_t>> heads;
+        std::vector<const char*> cur(_spill_pairs.size());
+        auto push = [&](size_t run) {
+            if (cur[run] < _spill_pairs[run]->end()) {
+                long long seq;
+                memcpy(&seq, cur[run], sizeof(seq));
+                heads.push(std::make_pair(seq, run));
+            }
+        };
+        for (size_t run = 0; run < _spill_pairs.size(); run++) {
+            cur[run] = _spill_pairs[run]->begin();
+            push(run);
+        }
+        while (!heads.empty()) {
+            size_t run = heads.top().second;
+            heads.pop();
+            spill_pair_t pair;
+            memcpy(&pair, cur[run], sizeof(pair));
+            cur[run] += sizeof(pair);
+            addPair(decodeIteration(pair.read_iter).getPos().data(),
+                    decodeIteration(pair.write_iter).getPos().data());
+            push(run);
+        }
+    }
+
+    // Print a dependent pair as [[read position],[write position]], and
+    // fold its distance into the summaries of the pairs
+    void addPair(const int* read, const int* write) {
+        int depth = _trip.size();
+        _num_pairs++;
+        if (_dep_os) {
+            std::ostream& os = *_dep_os;
+            os << "[[";
+            for (int k = 0; k < depth; k++) {
+                os << (k > 0 ? "," : "") << read[k];
+            }
+            os << "],[";
+            for (int k = 0; k < depth; k++) {
+                os << (k > 0 ? "," : "") << write[k];
+            }
+            os << "]],\n";
+        }
+
+        // The first loop whose ind var differs carries the pair
+        int outer = depth - 2;
+        bool outer_zero = true;
+        bool carried = false;
+        for (int k = 0; k < depth; k++) {
+            long long d = (read[k] - write[k]) / _step[k];
+            _pair_dist[k].val = d;
+            _pair_dist_vec[k] = d;
+            if (!carried && read[k] != write[k]) {
+                _carried[k] = true;
+                carried = true;
+            }
+            if (k < outer) {
+                outer_zero = outer_zero && d == 0;
+            }
+        }
+        if (_flow_dists.size() <= WAVEFRONT_MAX_DISTANCES) {
+            _flow_dists.insert(_pair_dist_vec);
+        }
+        if (depth >= 2) {
+            _flow_max_jam = getMaxLegalJam(_pair_dist, _flow_max_jam);
+            long long d = _pair_dist[outer].val;
+            if (outer_zero && d > 0 && (_flow_outer_reuse == 0 || d < _flow_outer_reuse)) {
+                _flow_outer_reuse = d;
+            }
+        }
+        long long d = _pair_dist[depth - 1].val;
+        if (outer_zero && (depth < 2 || _pair_dist[outer].val == 0) && d > 0 &&
+            (_flow_inner_dist == 0 || d < _flow_inner_dist)) {
+            _flow_inner_dist = d;
+        }
+    }
+
+    static void jitRead(void* ctx, int object_id, int num_subs, const int* subs,
+                        long long iter) {
+        auto a = (LoopUnrollAnalysis*)ctx;
+        a->makeKey(object_id, num_subs, subs);
+        auto writer = a->_jit_last_writer.find(a->_key);
+        if (writer != a->_jit_last_writer.end()) {
+            a->addPair(a->decodeIteration(iter).getPos().data(),
+                       a->decodeIteration(writer->second).getPos().data());
+        }
+    }
+
+    static void jitWrite(void* ctx, int object_id, int num_subs, const int* subs,
+                         long long iter) {
+        auto a = (LoopUnrollAnalysis*)ctx;
+        a->makeKey(object_id, num_subs, subs);
+        a->_jit_last_writer.insert_or_assign(a->_key, iter);
+    }
+
+    static void jitPair(void* ctx, long long iter, long long write_iter) {
+        auto a = (LoopUnrollAnalysis*)ctx;
+        a->addPair(a->decodeIteration(iter).getPos().data(),
+                   a->decodeIteration(write_iter).getPos().data());
+    }
+
+    static int jitSample(void* ctx, long long iters) {
+        auto a = (LoopUnrollAnalysis*)ctx;
+        if (a->_progress && a->_progress->isEnabled()) {
+            a->_progress->sample(a->_jit_iters_start + iters);
+        }
+        if (a->_has_deadline && std::chrono::steady_clock::now() >= a->_deadline) {
+            a->_jit_stopped = true;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Enumerate the nest with a compiled kernel; false if there is none and
+    // the walk has to interpret the patterns
+    bool runKernel(std::vector<access_t>& read_acs, std::vector<access_t>& write_acs,
+                   std::vector<std::string>& ind_var, std::vector<int>& end,
+                   long long total) {
+        jit_nest_t nest;
+        nest.start = _start;
+        nest.end = end;
+        nest.step = _step;
+        nest.ind_vars = ind_var;
+        nest.sample_mask = ProgressReporter::SAMPLE_MASK;
+        std::vector<long long*> tables;
+        for (auto acs_list: {&read_acs, &write_acs}) {
+            for (auto& acs: *acs_list) {
+                jit_access_t jit_acs;
+                jit_acs.node = acs.node;
+                jit_acs.write = acs_list == &write_acs;
+                jit_acs.object_id = acs.object_id;
+                if (acs.dense) {
+                    jit_acs.table = tables.size();
+                    tables.push_back(acs.dense->last_writer.data());
+                    jit_acs.lo = acs.dense->lo;
+                    jit_acs.extent = acs.dense->extent;
+                    jit_acs.stride = acs.dense->stride;
+                }
+                nest.accesses.push_back(jit_acs);
+            }
+        }
+        jit_kernel_t kernel = _jit->getKernel(nest);
+        if (!kernel) {
+            return false;
+        }
+
+        static const jit_callbacks_t callbacks = {jitRead, jitWrite, jitPair, jitSample};
+        _jitted = true;
+        _jit_iters_start = _num_iters;
+        long long iters = kernel(this, tables.data(), _max_iters > 0 ? _max_iters : -1,
+                                 &callbacks);
+        _num_iters += iters;
+        _num_acs += iters * (read_acs.size() + write_acs.size());
+        if (_jit_stopped) {
+            assumeDependent(_deadline_reason);
+        } else if (iters < total) {
+            assumeDependent(_iters_reason);
+        }
+        return true;
+    }
+
+    template <int D, int S>
+    bool getAffineAccesses(std::vector<access_t>& accesses, std::vector<std::string>& ind_var,
+                           std::vector<affine_access_t<D, S>>& affine_accesses) {
+        for (auto& acs: accesses) {
+            auto& subscripts = acs.node->getChildren();
+            if ((int)subscripts.size() != S) {
+                return false;
+            }
+            affine_access_t<D, S> affine_acs;
+            for (int i = 0; i < S; i++) {
+                AffineExpr expr = AffineExpr::fromPattern(subscripts[i]);
+                if (!expr.isValid()) {
+                    return false;
+                }
+                affine_acs.c[i] = (unsigned)expr.getConstant();
+                // Ind vars of other loops evaluate to 0
+                for (int k = 0; k < D; k++) {
+                    affine_acs.coeff[i][k] = (unsigned)expr.getCoeff(ind_var[k]);
+                }
+            }
+            affine_acs.object_id = acs.object_id;
+            affine_acs.dense = acs.dense;
+            affine_accesses.push_back(affine_acs);
+        }
+        return true;
+    }
+
+    template <int S>
+    static long long getDenseIndex(dense_table_t& table, const int* subs) {
+        long long idx = 0;
+        for (int i = 0; i < S; i++) {
+            long long v = subs[i] - table.lo[i];
+            if (v < 0 || v >= table.extent[i]) {
+                return -1;
+            }
+            idx += v * table.stride[i];
+        }
+        return idx;
+    }
+
+    template <int D, int S>
+    bool affineIteration(affine_walk_t<D, S>& w) {
+        if (w.iter == w.limit) {
+            return false;
+        }
+        long long cur_iter = w.iter++;
+        if (((_num_iters + w.iter) & ProgressReporter::SAMPLE_MASK) == 0) {
+            if (_progress && _progress->isEnabled()) {
+                _progress->sample(_num_iters + w.iter);
+            }
+            if (_has_deadline && std::chrono::steady_clock::now() >= _deadline) {
+                w.stopped = true;
+                return false;
+            }
+        }
+        int subs[S];
+        for (auto& acs: w.reads) {
+            evalAffine<D, S>(acs, w.iv, subs, std::make_index_sequence<S>());
+            long long writer = -1;
+            if (acs.dense) {
+                long long idx = getDenseIndex<S>(*acs.dense, subs);
+                writer = idx < 0 ? -1 : acs.dense->last_writer[idx];
+            } else {
+                elem_key_t key = {acs.object_id};
+                std::copy(subs, subs + S, key.begin() + 1);
+                auto iter = _elem_last_writer.find(key);
+                writer = iter == _elem_last_writer.end() ? -1 : iter->second;
+            }
+            if (writer >= 0) {
+                addPair(w.iv, decodeIteration(writer).getPos().data());
+            }
+        }
+        for (auto& acs: w.writes) {
+            evalAffine<D, S>(acs, w.iv, subs, std::make_index_sequence<S>());
+            if (acs.dense) {
+                long long idx = getDenseIndex<S>(*acs.dense, subs);
+                if (idx >= 0) {
+                    acs.dense->last_writer[idx] = cur_iter;
+                }
+            } else {
+                elem_key_t key = {acs.object_id};
+                std::copy(subs, subs + S, key.begin() + 1);
+                _elem_last_writer[key] = cur_iter;
+            }
+        }
+        return true;
+    }
+
+    // Loop K of the nest; false once the walk has to stop
+    template <int D, int S, int K>
+    bool affineLoop(affine_walk_t<D, S>& w) {
+        for (w.iv[K] = _start[K]; w.iv[K] < w.end[K]; w.iv[K] += _step[K]) {
+            if constexpr (K + 1 < D) {
+                if (!affineLoop<D, S, K + 1>(w)) {
+                    return false;
+                }
+            } else if (!affineIteration<D, S>(w)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <int D, int S>
+    bool runAffine(std::vector<access_t>& read_acs, std::vector<access_t>& write_acs,
+                   std::vector<std::string>& ind_var, std::vector<int>& end, long long total) {
+        affine_walk_t<D, S> w;
+        if (!getAffineAccesses<D, S>(read_acs, ind_var, w.reads) ||
+            !getAffineAccesses<D, S>(write_acs, ind_var, w.writes)) {
+            return false;
+        }
+        std::copy(end.begin(), end.end(), w.end);
+        w.limit = _max_iters > 0 ? _max_iters : -1;
+        _specialized = true;
+        affineLoop<D, S, 0>(w);
+        _num_iters += w.iter;
+        _num_acs += w.iter * (read_acs.size() + write_acs.size());
+        if (w.stopped) {
+            assumeDependent(_deadline_reason);
+        } else if (w.iter < total) {
+            assumeDependent(_iters_reason);
+        }
+        return true;
+    }
+
+    template <int D>
+    bool runAffine(int num_subs, std::vector<access_t>& read_acs, std::vector<access_t>& write_acs,
+                   std::vector<std::string>& ind_var, std::vector<int>& end, long long total) {
+        switch (num_subs) {
+        case 1:
+            return runAffine<D, 1>(read_acs, write_acs, ind_var, end, total);
+        case 2:
+            return runAffine<D, 2>(read_acs, write_acs, ind_var, end, total);
+        case 3:
+            return runAffine<D, 3>(read_acs, write_acs, ind_var, end, total);
+        }
+        return false;
+    }
+
+    // Enumerate the nest with the kernel specialized on its depth and
+    // subscript count; false if there is none, or if a subscript is not
+    // affine
+    bool runSpecialized(std::vector<access_t>& read_acs, std::vector<access_t>& write_acs,
+                        std::vector<std::string>& ind_var, std::vector<int>& end,
+                        long long total) {
+        auto& some_acs = read_acs.empty() ? write_acs : read_acs;
+        if (some_acs.empty()) {
+            return false;
+        }
+        int num_subs = some_acs[0].node->getChildren().size();
+        switch (ind_var.size()) {
+        case 1:
+            return runAffine<1>(num_subs, read_acs, write_acs, ind_var, end, total);
+        case 2:
+            return runAffine<2>(num_subs, read_acs, write_acs, ind_var, end, total);
+        case 3:
+            return runAffine<3>(num_subs, read_acs, write_acs, ind_var, end, total);
+        case 4:
+            return runAffine<4>(num_subs, read_acs, write_acs, ind_var, end, total);
+        }
+        return false;
+    }
 
 public:
     LoopUnrollAnalysis(LoopMemPatNode* loop) :
         _loop(loop) {}
 
+    void setProgress(ProgressReporter* progress) { _progress = progress; }
+
+    void setIterBudget(long long max_iters, const std::string& reason) {
+        _max_iters = max_iters;
+        _iters_reason = reason;
+    }
+
+    void setDeadline(std::chrono::steady_clock::time_point deadline,
+                     const std::string& reason) {
+        _has_deadline = true;
+        _deadline = deadline;
+        _deadline_reason = reason;
+    }
+
+    void setPrescreen(bool prescreen) { _prescreen = prescreen; }
+
+    void setDenseLimit(long long bytes) { _dense_limit = bytes; }
+
+    // Enumerate out of core in dir when the hash tables could exceed
+    // threshold bytes; dir empty to never do so
+    void setSpill(const std::string& dir, long long threshold, int num_partitions) {
+        _spill_dir = dir;
+        _spill_threshold = threshold;
+        _num_partitions = std::max(num_partitions, 1);
+    }
+
+    void setSpecialize(bool specialize) { _specialize = specialize; }
+
+    // Stream to print the dependent pairs to, nullptr to only count them
+    void setOutput(std::ostream* os) { _dep_os = os; }
+
+    // Enumerate nests of at least min_iters iterations with kernels of jit
+    void setJIT(DFGJIT* jit, long long min_iters) {
+        _jit = jit;
+        _jit_min_iters = min_iters;
+    }
+
+    // window: outer iterations to keep, -1 to derive it
+    void setWindow(bool windowed, int window) {
+        _windowed = windowed;
+        _window_param = window;
+    }
+
+    bool isAssumedDependent() { return !_assumed_dep_reason.empty(); }
+    const std::string& getAssumedDepReason() { return _assumed_dep_reason; }
 
     int getPatNodeValue(PatNode* pn) {
         auto children = pn->getChildren();
@@ -58,12 +974,18 @@ public:
         }
         auto type = pn->getType();
         if (type == CONSTANT) {
-            int const_value = stoi(pn->getConstantNum());
-            return const_value;
+            long long const_value;
+            if (parseConstant(pn, const_value)) {
+                return const_value;
+            }
         } else if (type == LOOP_IND_VAR) {
             std::string ind_var = std::string(pn->getValueName());
             int ind_var_value = _cur_ind_var_value_map[ind_var];
             return ind_var_value;
+        } else if (type == CAST_INST) {
+            if (child_values.size() == 1) {
+                return child_values[0];
+            }
         } else if (type == BIN_OP) {
             auto op = pn->getOp();
             if (op.compare("+") == 0) {
@@ -73,6 +995,20 @@ public:
                 }
                 return sum;
             }
+            if (child_values.size() != 2) {
+                return -1000;
+            }
+            if (op.compare("-") == 0) {
+                return child_values[0] - child_values[1];
+            } else if (op.compare("*") == 0) {
+                return child_values[0] * child_values[1];
+            } else if (op.compare("/") == 0 && child_values[1] != 0) {
+                return child_values[0] / child_values[1];
+            } else if (op.compare("<<") == 0) {
+                return child_values[0] << child_values[1];
+            } else if (op.compare(">>") == 0) {
+                return child_values[0] >> child_values[1];
+            }
         }
         return -1000;
     }
@@ -90,88 +1026,1082 @@ public:
         return offset;
     }
 
+    // A read and a write may touch the same element only if they access the
+    // same object with the same number of subscripts (the offset strings
+    // compared by checkDependence differ otherwise) and every subscript
+    // range overlaps
+    static bool mayOverlap(MemAcsPat* a, const std::vector<Interval>& a_ranges,
+                           MemAcsPat* b, const std::vector<Interval>& b_ranges) {
+        if (a->getPatNode()->getValueName() != b->getPatNode()->getValueName() ||
+            a_ranges.size() != b_ranges.size()) {
+            return false;
+        }
+        for (size_t d = 0; d < a_ranges.size(); d++) {
+            if (!a_ranges[d].intersects(b_ranges[d])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Drop the reads that cannot hit any write, and the writes that no read
+    // can hit, from the subscript ranges over the loop bounds
+    void prescreen(std::vector<MemAcsPat*>& reads, std::vector<MemAcsPat*>& writes,
+                   const std::map<std::string, Interval>& ind_var_ranges) {
+        auto getRanges = [&](MemAcsPat* mem_acs_pat) {
+            std::vector<Interval> ranges;
+            for (auto child: mem_acs_pat->getPatNode()->getChildren()) {
+                ranges.push_back(getPatternRange(child, ind_var_ranges));
+            }
+            return ranges;
+        };
+        std::vector<std::vector<Interval>> read_ranges, write_ranges;
+        for (auto r: reads) {
+            read_ranges.push_back(getRanges(r));
+        }
+        for (auto w: writes) {
+            write_ranges.push_back(getRanges(w));
+        }
+
+        std::vector<bool> read_live(reads.size(), false);
+        std::vector<bool> write_live(writes.size(), false);
+        for (size_t i = 0; i < reads.size(); i++) {
+            for (size_t j = 0; j < writes.size(); j++) {
+                if (mayOverlap(reads[i], read_ranges[i], writes[j], write_ranges[j])) {
+                    read_live[i] = true;
+                    write_live[j] = true;
+                }
+            }
+        }
+
+        std::vector<MemAcsPat*> live_reads, live_writes;
+        for (size_t i = 0; i < reads.size(); i++) {
+            if (read_live[i]) {
+                live_reads.push_back(reads[i]);
+            }
+        }
+        for (size_t j = 0; j < writes.size(); j++) {
+            if (write_live[j]) {
+                live_writes.push_back(writes[j]);
+            }
+        }
+        _num_skipped_acs = reads.size() + writes.size() -
+                           live_reads.size() - live_writes.size();
+        reads.swap(live_reads);
+        writes.swap(live_writes);
+    }
+
+    // Enclosing loops of the leaf loop, from the outermost one
+    std::vector<LoopMemPatNode*> getLoopNest() {
+        std::vector<LoopMemPatNode*> loop_stack;
+        auto node = _loop;
+        while (node && node->getType() == LOOP_NODE) {
+            loop_stack.insert(loop_stack.begin(), node);
+            node = node->getParent();
+        }
+        return loop_stack;
+    }
+
     void checkDependence() {
+        if (_loop->isAssumedDependent()) {
+            assumeDependent(_loop->getAssumedDepReason());
+            return;
+        }
         auto children = _loop->getChildren();
 
         // get all loops
-        std::vector<LoopMemPatNode*> loop_stack;
-        loop_stack.push_back(_loop);
-        auto parent = _loop->getParent();
-        while (parent) {
-            loop_stack.push_back(parent);
-            parent = parent->getParent();
-        }
-        if (!loop_stack[1] || !loop_stack[0]) {return;}
-        auto outer_loop_pat = loop_stack[1]->getLoopPat();
-        auto inner_loop_pat = loop_stack[0]->getLoopPat();
-        
-        int outer_start = outer_loop_pat->getStartVal();
-        int outer_end = outer_loop_pat->getEndVal();
-        int outer_step = outer_loop_pat->getStepVal();
-
-        int inner_start = inner_loop_pat->getStartVal();
-        int inner_end = inner_loop_pat->getEndVal();
-        int inner_step = inner_loop_pat->getStepVal();
-
-        std::string outer_ind_var = std::string(outer_loop_pat->getIndVar());
-        std::string inner_ind_var = std::string(inner_loop_pat->getIndVar());
-
-
-        for (int i = outer_start; i < outer_end; i += outer_step) {
-            _cur_ind_var_value_map[outer_ind_var] = i;
-            for (int j = inner_start; j < inner_end; j += inner_step){
-                _cur_ind_var_value_map[inner_ind_var] = j;
-                for (auto child: children) {
-                    if (child->getType() != MEM_ACS_NODE) {
+        std::vector<LoopMemPatNode*> loop_stack = getLoopNest();
+        int depth = loop_stack.size();
+        if (depth == 0) {return;}
+
+        std::vector<int> start(depth), end(depth), step(depth);
+        std::vector<std::string> ind_var(depth);
+        for (int k = 0; k < depth; k++) {
+            auto loop_pat = loop_stack[k]->getLoopPat();
+            if (!loop_pat || !loop_pat->hasConstantBounds()) {
+                assumeDependent("non-constant loop bounds");
+                return;
+            }
+            start[k] = loop_pat->getStartVal();
+            end[k] = loop_pat->getEndVal();
+            step[k] = loop_pat->getStepVal();
+            ind_var[k] = std::string(loop_pat->getIndVar());
+            if (step[k] <= 0 || start[k] >= end[k]) {
+                return;
+            }
+        }
+
+        bool report = _progress && _progress->isEnabled();
+        if (report) {
+            long long total = 1;
+            std::string loop_name;
+            for (int k = 0; k < depth; k++) {
+                total *= (end[k] - start[k] + step[k] - 1) / step[k];
+                loop_name += (k > 0 ? "/" : "") + ind_var[k];
+            }
+            _progress->beginLoop(loop_name, total);
+        }
+
+        std::vector<MemAcsPat*> reads, writes;
+        for (auto child: children) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            auto mem_acs_pat = child->getMemAcsPat();
+            auto mode = mem_acs_pat->getAccessMode();
+            if (mode == READ) {
+                reads.push_back(mem_acs_pat);
+            } else if (mode == WRITE) {
+                writes.push_back(mem_acs_pat);
+            }
+        }
+
+        std::map<std::string, Interval> ind_var_ranges;
+        for (int k = 0; k < depth; k++) {
+            ind_var_ranges[ind_var[k]] = getIndVarRange(start[k], end[k], step[k]);
+        }
+        _start = start;
+        _step = step;
+        _trip.resize(depth);
+        for (int k = 0; k < depth; k++) {
+            _trip[k] = (end[k] - start[k] + step[k] - 1) / step[k];
+        }
+        _carried.assign(depth, false);
+        _pair_dist.assign(depth, dist_t{false, 0});
+        _pair_dist_vec.assign(depth, 0);
+        if (_prescreen) {
+            prescreen(reads, writes, ind_var_ranges);
+            if (reads.empty() || writes.empty()) {
+                _skipped_loop = true;
+                return;
+            }
+        }
+
+        if (_dense_limit > 0) {
+            selectDenseTables(reads, writes, ind_var_ranges);
+        }
+        std::vector<access_t> read_acs = getAccesses(reads);
+        std::vector<access_t> write_acs = getAccesses(writes);
+        long long total = 1;
+        for (int k = 0; k < depth; k++) {
+            total *= _trip[k];
+        }
+        if (!_spill_dir.empty()) {
+            if (estimateTableBytes(read_acs, write_acs, total) > _spill_threshold &&
+                !openSpill()) {
+                assumeDependent("cannot create spill files in " + _spill_dir);
+                return;
+            }
+        }
+        // Kernels keep every write in memory, they take precedence over the
+        // window
+        _window = -1;
+        if (_jit && !_spilled && total >= _jit_min_iters &&
+            runKernel(read_acs, write_acs, ind_var, end, total)) {
+            if (report) {
+                _progress->endLoop(_num_iters);
+            }
+            return;
+        }
+        if (_spilled) {
+            // Nothing in memory to evict
+        } else if (_window_param >= 0) {
+            _window = _window_param;
+        } else if (_windowed) {
+            // Value distance of the outer ind var to iterations
+            long long dist = deriveWindow(read_acs, write_acs, ind_var[0], ind_var_ranges);
+            _window = dist < 0 ? -1 : dist / step[0];
+        }
+
+        // The specialized kernels do not evict, so only take nests whose
+        // hash tables are not windowed
+        bool has_hash = false;
+        for (auto acs_list: {&read_acs, &write_acs}) {
+            for (auto& acs: *acs_list) {
+                has_hash = has_hash || !acs.dense;
+            }
+        }
+        if (_specialize && !_spilled && (_window < 0 || !has_hash) &&
+            runSpecialized(read_acs, write_acs, ind_var, end, total)) {
+            _window = -1;
+            if (report) {
+                _progress->endLoop(_num_iters);
+            }
+            return;
+        }
+
+        // Walk the iteration space in execution order. Reads see the last
+        // write to the same element in an earlier iteration.
+        std::vector<int> pos(start);
+        for (int k = 0; k < depth; k++) {
+            _cur_ind_var_value_map[ind_var[k]] = pos[k];
+        }
+        long long num_iters_start = _num_iters;
+        long long read_seq = 0;
+        while (true) {
+            if (_max_iters > 0 && _num_iters - num_iters_start >= _max_iters) {
+                assumeDependent(_iters_reason);
+                break;
+            }
+            _num_iters++;
+            if ((_num_iters & ProgressReporter::SAMPLE_MASK) == 0) {
+                if (report) {
+                    _progress->sample(_num_iters);
+                }
+                if (_has_deadline && std::chrono::steady_clock::now() >= _deadline) {
+                    assumeDependent(_deadline_reason);
+                    break;
+                }
+            }
+            long long cur_iter = _num_iters - num_iters_start - 1;
+            for (auto& acs: read_acs) {
+                _num_acs++;
+                long long seq = read_seq++;
+                if (acs.dense) {
+                    long long idx = getDenseIndex(acs);
+                    if (idx < 0 || acs.dense->last_writer[idx] < 0) {
                         continue;
                     }
-                    
-
-                    auto mem_acs_pat = child->getMemAcsPat();
-                    auto mode = mem_acs_pat->getAccessMode();
-                    if (mode == READ) {
-                        auto mem_acs_pat_node = mem_acs_pat->getPatNode();
-                        std::string object_name = std::string(mem_acs_pat_node->getValueName());
-                        std::string offset = convertToOffset(mem_acs_pat_node);
-                        // dbg(offset);
-                        // std::cout << "R:" << offset << " at " ;
-
-                        if (_w_mem_acs.find(object_name) != _w_mem_acs.end()) {
-                            auto& tmp_map = _w_mem_acs[object_name];
-
-                            if (tmp_map.find(offset) != tmp_map.end()) {
-                                std::cout << "[["<< i << "," << j << "],[";
-                                auto array_pos = tmp_map[offset];
-                                array_pos->dump();
-                                std::cout <<"]],"<< std::endl;
-                            }
-                        }
-                        // std::cout << std::endl;
+                    if (_spilled) {
+                        spill_pair_t pair = {seq, cur_iter, acs.dense->last_writer[idx]};
+                        _spill_pairs[0]->append(&pair, sizeof(pair));
+                    } else {
+                        addPair(pos.data(),
+                                decodeIteration(acs.dense->last_writer[idx]).getPos().data());
+                    }
+                    continue;
+                }
+                if (_spilled) {
+                    spillAccess(acs, seq, cur_iter, _spill_reads);
+                    continue;
+                }
+                std::string offset = convertToOffset(acs.node);
+                // dbg(offset);
+
+                auto obj_iter = _w_mem_acs.find(acs.object);
+                if (obj_iter != _w_mem_acs.end()) {
+                    auto& tmp_map = obj_iter->second;
+                    auto iter = tmp_map.find(offset);
+                    if (iter != tmp_map.end()) {
+                        addPair(pos.data(), iter->second.getPos().data());
+                    }
+                }
+            }
+
+            for (auto& acs: write_acs) {
+                _num_acs++;
+                if (acs.dense) {
+                    long long idx = getDenseIndex(acs);
+                    if (idx >= 0) {
+                        acs.dense->last_writer[idx] = cur_iter;
                     }
+                    continue;
+                }
+                if (_spilled) {
+                    spillAccess(acs, -1, cur_iter, _spill_writes);
+                    continue;
+                }
+                std::string offset = convertToOffset(acs.node);
+                // dbg(offset);
+                auto& tmp_map = _w_mem_acs[acs.object];
+                if (_window < 0) {
+                    tmp_map.insert_or_assign(std::move(offset), ArrayPos(pos));
+                    continue;
+                }
+                // Each entry is listed once in the block of its last writer
+                if (_window_blocks.empty() || _window_blocks.back().outer_pos != pos[0]) {
+                    _window_blocks.push_back(window_block_t{pos[0], {}});
+                }
+                auto iter = tmp_map.find(offset);
+                if (iter == tmp_map.end()) {
+                    iter = tmp_map.emplace(std::move(offset), ArrayPos(pos)).first;
+                } else if (iter->second.getPos()[0] != pos[0]) {
+                    iter->second = ArrayPos(pos);
+                } else {
+                    iter->second = ArrayPos(pos);
+                    continue;
+                }
+                _window_blocks.back().keys.push_back(std::make_pair(&tmp_map, &iter->first));
+            }
+
+            // next iteration
+            int k = depth - 1;
+            while (k >= 0) {
+                pos[k] += step[k];
+                if (pos[k] < end[k]) {
+                    break;
+                }
+                pos[k] = start[k];
+                k--;
+            }
+            if (k < 0) {
+                break;
+            }
+            if (k == 0 && _window >= 0) {
+                evictWindow(pos[0], step[0]);
+            }
+            for (int l = k; l < depth; l++) {
+                _cur_ind_var_value_map[ind_var[l]] = pos[l];
+            }
+        }
+        if (report) {
+            _progress->endLoop(_num_iters);
+        }
+        if (_spilled && !isAssumedDependent()) {
+            joinSpill();
+        }
+    }
+
+    // End the dependent pairs printed by checkDependence with the reason
+    // the loop is assumed dependent, if it is
+    void dumpDependence() {
+        if (isAssumedDependent() && _dep_os) {
+            *_dep_os << "assumed dependent: " << _assumed_dep_reason << std::endl;
+        }
+    }
+
+    // Unroll factor of the leaf loop and unroll-and-jam factor of the loop
+    // around it, after checkDependence. Jamming needs every pair of
+    // references with a write to have separable subscripts, and pays off
+    // when elements are reused across outer iterations. The leaf loop is
+    // unrolled no further than its shortest carried dependence.
+    unroll_advice_t adviseUnroll(int max_unroll, int max_jam) {
+        unroll_advice_t advice;
+        int depth = _trip.size();
+        if (depth == 0 || isAssumedDependent()) {
+            return advice;
+        }
+        advice.valid = true;
+        std::vector<LoopMemPatNode*> nest = getLoopNest();
+        std::vector<std::string> ind_vars;
+        for (auto node: nest) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+        }
+        int outer = depth - 2;
+        advice.max_legal_jam = depth >= 2 ? _trip[outer] : 1;
+        // Jamming also moves the accesses of the outer loop before or after
+        // the inner one across the copies of the inner body, and none of
+        // their dependences is known here
+        for (size_t c = 0; depth >= 2 && c < nest[outer]->getChildren().size(); c++) {
+            LoopMemPatNode* child = nest[outer]->getChildren()[c];
+            if (child->getType() == MEM_ACS_NODE &&
+                child->getMemAcsPat()->getAccessMode() != 0) {
+                advice.max_legal_jam = 1;
+            }
+        }
+
+        advice.max_legal_jam = std::min(advice.max_legal_jam, _flow_max_jam);
+        advice.outer_reuse = _flow_outer_reuse;
+        advice.inner_dist = _flow_inner_dist;
+
+        std::vector<dist_t> dist(depth);
+
+        std::vector<MemAcsPat*> refs;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() == MEM_ACS_NODE &&
+                child->getMemAcsPat()->getAccessMode() != 0) {
+                refs.push_back(child->getMemAcsPat());
+            }
+        }
+        for (size_t i = 0; i < refs.size() && depth >= 2; i++) {
+            for (size_t j = i; j < refs.size(); j++) {
+                bool has_write = refs[i]->getAccessMode() == WRITE ||
+                                 refs[j]->getAccessMode() == WRITE;
+                auto kind = getSeparableDistance(refs[i]->getPatNode(), refs[j]->getPatNode(),
+                                                 ind_vars, _step, _trip, 0, false, dist);
+                if (kind == DEP_UNKNOWN) {
+                    advice.max_legal_jam = has_write ? 1 : advice.max_legal_jam;
+                    continue;
+                }
+                if (kind == DEP_NONE) {
+                    continue;
+                }
+                if (has_write) {
+                    advice.max_legal_jam = getMaxLegalJam(dist, advice.max_legal_jam);
+                }
+                // Elements shared by copies of the loop body a fixed number
+                // of outer iterations apart
+                bool reused = !dist[outer].any && dist[outer].val != 0 &&
+                              !dist[depth - 1].any;
+                for (int k = 0; k < outer; k++) {
+                    reused = reused && !dist[k].any && dist[k].val == 0;
+                }
+                long long d = std::abs(dist[outer].val);
+                if (reused && (advice.outer_reuse == 0 || d < advice.outer_reuse)) {
+                    advice.outer_reuse = d;
+                }
+            }
+        }
+
+        long long unroll_limit = max_unroll;
+        if (advice.inner_dist > 0) {
+            unroll_limit = std::min(unroll_limit, advice.inner_dist);
+        }
+        advice.unroll = getDividingFactor(unroll_limit, _trip[depth - 1]);
+        if (depth >= 2 && advice.outer_reuse > 0) {
+            long long jam = getDividingFactor(std::min((long long)max_jam, advice.max_legal_jam),
+                                              _trip[outer]);
+            // Copies further apart than the reuse distance share nothing
+            advice.unroll_and_jam = jam > advice.outer_reuse ? jam : 1;
+        }
+        return advice;
+    }
+
+    // Levels of the nest that carry an enumerated dependence: the first
+    // loop whose ind var differs between read and write
+    std::vector<bool> getCarriedLevels() {
+        return _carried;
+    }
+
+    // Distance vectors of the nest: the enumerated flow distances and the
+    // separable distances of every pair of references with a write, which
+    // also cover anti and output dependences. False, with the reason, if
+    // some dependence cannot be described.
+    bool collectDistances(std::set<dist_vec_t>& deps, std::string& reason) {
+        std::vector<std::string> ind_vars;
+        for (auto node: getLoopNest()) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+        }
+        deps.insert(_flow_dists.begin(), _flow_dists.end());
+        std::vector<MemAcsPat*> refs;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            auto mode = child->getMemAcsPat()->getAccessMode();
+            if (mode != READ && mode != WRITE) {
+                reason = "unknown access mode";
+                return false;
+            }
+            refs.push_back(child->getMemAcsPat());
+        }
+        std::vector<dist_t> dist;
+        for (size_t i = 0; i < refs.size(); i++) {
+            for (size_t j = i; j < refs.size(); j++) {
+                if (refs[i]->getAccessMode() != WRITE && refs[j]->getAccessMode() != WRITE) {
+                    continue;
+                }
+                auto kind = getSeparableDistance(refs[i]->getPatNode(), refs[j]->getPatNode(),
+                                                 ind_vars, _step, _trip, 0, false, dist);
+                if (kind == DEP_UNKNOWN) {
+                    reason = "non-uniform dependence";
+                    return false;
+                }
+                if (kind == DEP_DIST) {
+                    addDistanceCorners(dist, _trip, deps);
+                }
+            }
+        }
+        if (deps.size() > WAVEFRONT_MAX_DISTANCES) {
+            reason = "too many distance vectors";
+            return false;
+        }
+        return true;
+    }
+
+    // Hyperplane schedule of the nest over its distance vectors
+    wavefront_t scheduleWavefront() {
+        wavefront_t wf;
+        int depth = _trip.size();
+        if (depth < 2 || isAssumedDependent()) {
+            wf.reason = depth < 2 ? "single loop" : getAssumedDepReason();
+            return wf;
+        }
+        if (depth > WAVEFRONT_MAX_DEPTH) {
+            wf.reason = "nest too deep";
+            return wf;
+        }
+        std::vector<std::string> ind_vars;
+        for (auto node: getLoopNest()) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+        }
+        std::set<dist_vec_t> deps;
+        if (!collectDistances(deps, wf.reason)) {
+            return wf;
+        }
+        wf.num_distances = deps.size();
+        if (!findHyperplane(deps, _trip, wf.hyperplane)) {
+            wf.reason = "no hyperplane";
+            return wf;
+        }
+        wf.valid = true;
+        for (int k = 0; k < depth; k++) {
+            if (std::abs(wf.hyperplane[k]) == 1) {
+                wf.time_level = k;
+            }
+        }
+        wf.num_wavefronts = getNumWavefronts(wf.hyperplane, _trip);
+        long long total = 0;
+        for (long long n: getWavefrontSizes(wf.hyperplane, _trip)) {
+            wf.max_parallelism = std::max(wf.max_parallelism, n);
+            total += n;
+        }
+        wf.avg_parallelism = (double)total / wf.num_wavefronts;
+        wf.schedule = describeSchedule(wf.hyperplane, wf.time_level, ind_vars,
+                                       _start, _step, _trip);
+        return wf;
+    }
+
+    // Tile sizes of the outermost permutable band of the nest for each
+    // cache level
+    tiling_advice_t adviseTiling(const cache_config_t& cache) {
+        tiling_advice_t advice;
+        int depth = _trip.size();
+        if (depth < 2 || isAssumedDependent()) {
+            advice.reason = depth < 2 ? "single loop" : getAssumedDepReason();
+            return advice;
+        }
+        auto loop_nest = getLoopNest();
+        std::vector<std::string> ind_vars;
+        for (auto node: loop_nest) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+            if (node != _loop && node->getChildren().size() != 1) {
+                advice.reason = "imperfect nest";
+                return advice;
+            }
+        }
+        std::set<dist_vec_t> deps;
+        if (!collectDistances(deps, advice.reason)) {
+            return advice;
+        }
+        advice.band = getPermutableBand(deps, depth);
+        if (advice.band < 2) {
+            advice.reason = "no permutable band of two loops";
+            return advice;
+        }
+
+        std::map<std::string, tile_array_t> arrays;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            PatNode* pn = child->getMemAcsPat()->getPatNode();
+            tile_array_t& array = arrays[pn->getValueName()];
+            array.elem_bytes = getElementBytes(pn);
+            std::vector<AffineExpr> subs;
+            for (auto sub: pn->getChildren()) {
+                subs.push_back(AffineExpr::fromPattern(sub));
+            }
+            array.refs.push_back(subs);
+        }
+        advice.nest_bytes = getTileBytes(arrays, ind_vars, _start, _step, _trip,
+                                         cache.line_bytes);
+        if (advice.nest_bytes < 0) {
+            advice.reason = "non-affine subscript";
+            return advice;
+        }
+        advice.valid = true;
+        for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+            advice.levels[c] = fitTile(arrays, ind_vars, _start, _step, _trip,
+                                       advice.band, cache.capacity[c], cache.line_bytes);
+        }
+        return advice;
+    }
+
+    // Byte address of a reference over the loops of the nest
+    bool getRefAddress(PatNode* pn, ref_address_t& addr) {
+        std::vector<std::string> ind_vars;
+        for (auto node: getLoopNest()) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+        }
+        if (ind_vars.size() != _trip.size()) {
+            return false;
+        }
+        return ::getRefAddress(pn, ind_vars, _start, _step, addr);
+    }
+
+    // Footprint of the non-affine references pns to one array over the
+    // loops from level m, the outer loops at their first iteration: the
+    // distinct lines of the first REUSE_SAMPLE_ITERS iterations, scaled to
+    // the whole loops
+    ref_footprint_t sampleFootprint(const std::vector<PatNode*>& pns, long long elem_bytes,
+                                    int m, int line_bytes) {
+        int depth = _trip.size();
+        std::vector<std::string> ind_vars;
+        for (auto node: getLoopNest()) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+        }
+        long long total = 1;
+        for (int k = m; k < depth; k++) {
+            total *= _trip[k];
+        }
+        std::vector<long long> x(depth, 0);
+        std::set<long long> lines;
+        long long lo = LLONG_MAX, hi = LLONG_MIN;
+        long long visited = 0;
+        std::vector<std::vector<long long>> strides;
+        for (auto pn: pns) {
+            strides.push_back(getSubscriptStrides(pn));
+        }
+        while (visited < total && visited < REUSE_SAMPLE_ITERS) {
+            for (int k = 0; k < depth; k++) {
+                _cur_ind_var_value_map[ind_vars[k]] = _start[k] + x[k] * _step[k];
+            }
+            for (size_t r = 0; r < pns.size(); r++) {
+                auto& subs = pns[r]->getChildren();
+                long long addr = 0;
+                for (size_t d = 0; d < subs.size(); d++) {
+                    addr += strides[r][d] * getPatNodeValue(subs[d]);
                 }
+                lines.insert(addr >= 0 ? addr / line_bytes
+                                       : (addr - line_bytes + 1) / line_bytes);
+                lo = std::min(lo, addr);
+                hi = std::max(hi, addr + elem_bytes - 1);
+            }
+            visited++;
+            for (int k = depth - 1; k >= m; k--) {
+                if (++x[k] < _trip[k]) {
+                    break;
+                }
+                x[k] = 0;
+            }
+        }
+        ref_footprint_t fp;
+        fp.lines = (double)lines.size() * total / visited;
+        if (visited == total) {
+            fp.span = Interval(lo, hi);
+        }
+        return fp;
+    }
 
-                for (auto child: children) {
-                    if (child->getType() != MEM_ACS_NODE) {
+    // Reuse of every reference and misses per iteration in each cache
+    // level: closed form footprints for affine subscripts, sampled ones
+    // otherwise
+    reuse_report_t estimateReuse(const cache_config_t& cache) {
+        reuse_report_t report;
+        int depth = _trip.size();
+        if (depth == 0 || isAssumedDependent()) {
+            report.reason = depth == 0 ? "no loop" : getAssumedDepReason();
+            return report;
+        }
+        report.iterations = 1;
+        for (long long trip: _trip) {
+            report.iterations *= trip;
+        }
+        if (report.iterations == 0) {
+            report.reason = "no iteration";
+            return report;
+        }
+        std::vector<std::vector<ref_footprint_t>> footprints;
+        // Non-affine references of each array, sampled together
+        std::map<std::string, std::vector<PatNode*>> sampled;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            PatNode* pn = child->getMemAcsPat()->getPatNode();
+            ref_address_t addr;
+            if (!getRefAddress(pn, addr)) {
+                report.reason = "unknown element layout";
+                return report;
+            }
+            ref_reuse_t ref;
+            ref.array = pn->getValueName();
+            ref.write = child->getMemAcsPat()->getAccessMode() == WRITE;
+            std::vector<ref_footprint_t> fps(depth + 1);
+            if (!addr.affine) {
+                ref.kind = REUSE_SAMPLED;
+                sampled[ref.array].push_back(pn);
+            } else {
+                for (int m = 0; m <= depth; m++) {
+                    fps[m] = getAffineFootprint(addr, _trip, m, cache.line_bytes);
+                }
+                for (int k = depth - 1; k >= 0 && ref.kind == REUSE_NONE; k--) {
+                    if (_trip[k] < 2) {
                         continue;
                     }
-                    auto mem_acs_pat = child->getMemAcsPat();
-                    auto mode = mem_acs_pat->getAccessMode();
-                    if (mode == WRITE) {
-                        auto mem_acs_pat_node = mem_acs_pat->getPatNode();
-                        std::string object_name = std::string(mem_acs_pat_node->getValueName());
-                        std::string offset = convertToOffset(mem_acs_pat_node);
-                        // dbg(offset);
-                        // std::cout << "W:" << offset << " at " << i << "," << j << std::endl;
-                        
-                        ArrayPos* cur_array_pos = new ArrayPos(i,j);
-                        _w_mem_acs[object_name].insert(std::make_pair<std::string, ArrayPos*>(std::move(offset), std::move(cur_array_pos)));
+                    if (addr.coeff[k] == 0) {
+                        ref.kind = REUSE_TEMPORAL;
+                    } else if (std::abs(addr.coeff[k]) < cache.line_bytes) {
+                        ref.kind = REUSE_SPATIAL;
+                    }
+                    ref.level = ref.kind != REUSE_NONE ? k : -1;
+                }
+            }
+            report.refs.push_back(ref);
+            footprints.push_back(fps);
+        }
+        // Each sampled reference gets an equal share of the lines of its array
+        for (auto& array: sampled) {
+            long long elem_bytes = getElementBytes(array.second.front());
+            for (int m = 0; m <= depth; m++) {
+                ref_footprint_t fp = sampleFootprint(array.second, elem_bytes, m,
+                                                     cache.line_bytes);
+                fp.lines /= array.second.size();
+                for (size_t r = 0; r < report.refs.size(); r++) {
+                    if (report.refs[r].kind == REUSE_SAMPLED &&
+                        report.refs[r].array == array.first) {
+                        footprints[r][m] = fp;
+                    }
+                }
+            }
+        }
+        report.valid = true;
+        estimateMisses(report, footprints, _trip, cache);
+        return report;
+    }
+
+    // Best legal order of the loops of a perfect nest for the miss model;
+    // every reference must be affine
+    interchange_advice_t adviseInterchange(const cache_config_t& cache) {
+        interchange_advice_t advice;
+        int depth = _trip.size();
+        if (depth < 2 || isAssumedDependent()) {
+            advice.reason = isAssumedDependent() ? getAssumedDepReason() : "single loop";
+            return advice;
+        }
+        if (depth > INTERCHANGE_MAX_DEPTH) {
+            advice.reason = "nest too deep";
+            return advice;
+        }
+        for (auto node: getLoopNest()) {
+            if (node != _loop && node->getChildren().size() != 1) {
+                advice.reason = "imperfect nest";
+                return advice;
+            }
+        }
+        long long iterations = 1;
+        for (long long trip: _trip) {
+            iterations *= trip;
+        }
+        if (iterations == 0) {
+            advice.reason = "no iteration";
+            return advice;
+        }
+        std::set<dist_vec_t> deps;
+        if (!collectDistances(deps, advice.reason)) {
+            return advice;
+        }
+        std::vector<ref_address_t> addrs;
+        std::vector<ref_reuse_t> refs;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            PatNode* pn = child->getMemAcsPat()->getPatNode();
+            ref_address_t addr;
+            if (!getRefAddress(pn, addr) || !addr.affine) {
+                advice.reason = "non-affine reference";
+                return advice;
+            }
+            ref_reuse_t ref;
+            ref.array = pn->getValueName();
+            ref.write = child->getMemAcsPat()->getAccessMode() == WRITE;
+            addrs.push_back(addr);
+            refs.push_back(ref);
+        }
+
+        std::vector<int> order(depth);
+        for (int k = 0; k < depth; k++) {
+            order[k] = k;
+        }
+        reuse_report_t misses = getOrderMisses(addrs, refs, _trip, order, iterations, cache);
+        std::copy(misses.traffic, misses.traffic + NUM_CACHE_LEVELS, advice.traffic);
+        std::copy(misses.traffic, misses.traffic + NUM_CACHE_LEVELS, advice.best_traffic);
+        advice.non_unit = advice.best_non_unit = getNonUnitStrides(addrs, depth - 1);
+        advice.order = order;
+        // From the original order on, ties keep the first order found
+        do {
+            advice.num_orders++;
+            if (!isLegalOrder(deps, order)) {
+                continue;
+            }
+            advice.num_legal++;
+            misses = getOrderMisses(addrs, refs, _trip, order, iterations, cache);
+            int non_unit = getNonUnitStrides(addrs, order.back());
+            if (isBetterOrder(misses.traffic, non_unit, advice.best_traffic,
+                              advice.best_non_unit)) {
+                advice.order = order;
+                std::copy(misses.traffic, misses.traffic + NUM_CACHE_LEVELS,
+                          advice.best_traffic);
+                advice.best_non_unit = non_unit;
+            }
+        } while (std::next_permutation(order.begin(), order.end()));
+        advice.valid = true;
+        return advice;
+    }
+
+    // Replay every access of the nest, in program order, through a cache
+    // hierarchy. Arrays are laid out one after another at page boundaries.
+    // The replay has the iteration budget and deadline of checkDependence.
+    cache_sim_report_t simulateCache(const cache_config_t& cache) {
+        cache_sim_report_t report;
+        int depth = _trip.size();
+        if (depth == 0 || isAssumedDependent()) {
+            report.reason = isAssumedDependent() ? getAssumedDepReason() : "no loop";
+            return report;
+        }
+        if (_skipped_loop) {
+            report.reason = "skipped by the prescreen";
+            return report;
+        }
+        std::vector<std::string> ind_vars;
+        std::map<std::string, Interval> ranges;
+        for (auto node: getLoopNest()) {
+            auto loop_pat = node->getLoopPat();
+            ind_vars.push_back(loop_pat->getIndVar());
+            ranges[loop_pat->getIndVar()] = getIndVarRange(
+                loop_pat->getStartVal(), loop_pat->getEndVal(), loop_pat->getStepVal());
+        }
+        std::vector<PatNode*> pns;
+        std::vector<ref_address_t> addrs;
+        std::map<std::string, Interval> spans;
+        bool has_sampled = false;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            PatNode* pn = child->getMemAcsPat()->getPatNode();
+            ref_address_t addr;
+            if (!getRefAddress(pn, addr)) {
+                report.reason = "unknown element layout";
+                return report;
+            }
+            // Byte range of the reference over the whole nest
+            Interval span(0, (1LL << 30) - 1);
+            if (addr.affine) {
+                span = getAffineFootprint(addr, _trip, 0, cache.line_bytes).span;
+            } else {
+                std::vector<long long> strides = getSubscriptStrides(pn);
+                long long lo = 0, hi = addr.elem_bytes - 1;
+                for (size_t d = 0; d < strides.size(); d++) {
+                    Interval range = getPatternRange(pn->getChildren()[d], ranges);
+                    if (!range.known) {
+                        lo = 0;
+                        hi = (1LL << 30) - 1;
+                        break;
+                    }
+                    lo += std::min(strides[d] * range.lo, strides[d] * range.hi);
+                    hi += std::max(strides[d] * range.lo, strides[d] * range.hi);
+                }
+                span = Interval(lo, hi);
+                has_sampled = true;
+            }
+            Interval& array_span = spans[pn->getValueName()];
+            if (!array_span.known) {
+                array_span = span;
+            }
+            array_span.lo = std::min(array_span.lo, span.lo);
+            array_span.hi = std::max(array_span.hi, span.hi);
+            sim_ref_t ref;
+            ref.array = pn->getValueName();
+            ref.write = child->getMemAcsPat()->getAccessMode() == WRITE;
+            report.refs.push_back(ref);
+            pns.push_back(pn);
+            addrs.push_back(addr);
+        }
+        // Address of byte 0 of each array
+        std::map<std::string, long long> bases;
+        long long next = 1 << 12;
+        for (auto& array: spans) {
+            bases[array.first] = next - array.second.lo;
+            next += (array.second.hi - array.second.lo + (1 << 12)) >> 12 << 12;
+        }
+        int num_refs = pns.size();
+        std::vector<long long> ref_bases(num_refs);
+        std::vector<std::vector<long long>> strides(num_refs);
+        for (int r = 0; r < num_refs; r++) {
+            ref_bases[r] = bases[report.refs[r].array] + (addrs[r].affine ? addrs[r].base : 0);
+            if (!addrs[r].affine) {
+                strides[r] = getSubscriptStrides(pns[r]);
+            }
+        }
 
+        bool progress = _progress && _progress->isEnabled();
+        if (progress) {
+            long long total = 1;
+            std::string loop_name;
+            for (int k = 0; k < depth; k++) {
+                total *= _trip[k];
+                loop_name += (k > 0 ? "/" : "") + ind_vars[k];
+            }
+            _progress->beginLoop(loop_name + " (cache simulation)", total);
+        }
+        auto sim_start = std::chrono::steady_clock::now();
+        CacheSim sim(cache, num_refs);
+        uint64_t batch[CACHE_SIM_BATCH];
+        int batch_refs[CACHE_SIM_BATCH];
+        int n = 0;
+        std::vector<long long> x(depth, 0);
+        bool done = num_refs == 0;
+        for (long long trip: _trip) {
+            done = done || trip <= 0;
+        }
+        long long iters = 0;
+        while (!done) {
+            if (_max_iters > 0 && iters >= _max_iters) {
+                report.reason = _iters_reason;
+                return report;
+            }
+            iters++;
+            if ((iters & ProgressReporter::SAMPLE_MASK) == 0) {
+                if (progress) {
+                    _progress->sample(iters);
+                }
+                if (_has_deadline && std::chrono::steady_clock::now() >= _deadline) {
+                    report.reason = _deadline_reason;
+                    return report;
+                }
+            }
+            if (has_sampled) {
+                for (int k = 0; k < depth; k++) {
+                    _cur_ind_var_value_map[ind_vars[k]] = _start[k] + x[k] * _step[k];
+                }
+            }
+            if (n + num_refs > CACHE_SIM_BATCH) {
+                sim.simulate(batch, batch_refs, n);
+                n = 0;
+            }
+            for (int r = 0; r < num_refs; r++) {
+                long long addr = ref_bases[r];
+                if (addrs[r].affine) {
+                    for (int k = 0; k < depth; k++) {
+                        addr += addrs[r].coeff[k] * x[k];
+                    }
+                } else {
+                    auto& subs = pns[r]->getChildren();
+                    for (size_t d = 0; d < subs.size(); d++) {
+                        addr += strides[r][d] * getPatNodeValue(subs[d]);
                     }
                 }
+                batch[n] = addr;
+                batch_refs[n++] = r;
+            }
+            report.accesses += num_refs;
+            int k = depth - 1;
+            for (; k >= 0; k--) {
+                if (++x[k] < _trip[k]) {
+                    break;
+                }
+                x[k] = 0;
+            }
+            done = k < 0;
+        }
+        sim.simulate(batch, batch_refs, n);
+        report.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - sim_start).count();
+        if (progress) {
+            _progress->endLoop(iters);
+        }
+
+        for (int r = 0; r < num_refs; r++) {
+            for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                const cache_counts_t& counts = sim.getCounts(r, c);
+                report.refs[r].counts[c] = counts;
+                report.counts[c].hits += counts.hits;
+                report.counts[c].misses += counts.misses;
+                report.counts[c].evictions += counts.evictions;
+            }
+        }
+        report.valid = true;
+        return report;
+    }
+
+    // Stencil formed by the accesses of a perfect nest
+    stencil_t recognizeStencil() {
+        stencil_t stencil;
+        std::vector<std::string> ind_vars;
+        for (auto node: getLoopNest()) {
+            ind_vars.push_back(node->getLoopPat()->getIndVar());
+            if (node != _loop && node->getChildren().size() != 1) {
+                stencil.reason = "imperfect nest";
+                return stencil;
+            }
+        }
+        std::vector<MemAcsPat*> refs;
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() == MEM_ACS_NODE) {
+                refs.push_back(child->getMemAcsPat());
+            }
+        }
+        return ::recognizeStencil(refs, ind_vars);
+    }
+
+    // Stride of every access with respect to each loop of the nest; empty
+    // if the bounds of the nest are unknown
+    std::vector<access_stride_t> classifyStrides() {
+        std::vector<access_stride_t> strides;
+        int depth = _trip.size();
+        if (depth == 0) {
+            return strides;
+        }
+        for (auto child: _loop->getChildren()) {
+            if (child->getType() != MEM_ACS_NODE) {
+                continue;
+            }
+            PatNode* pn = child->getMemAcsPat()->getPatNode();
+            ref_address_t addr;
+            bool known = getRefAddress(pn, addr);
+            access_stride_t access;
+            access.array = pn->getValueName();
+            access.write = child->getMemAcsPat()->getAccessMode() == WRITE;
+            access.elem_bytes = addr.elem_bytes;
+            access.inst = llvm::dyn_cast_or_null<llvm::Instruction>(pn->getValue());
+            for (int k = 0; k < depth; k++) {
+                bool affine = known && addr.affine;
+                access.bytes.push_back(affine ? addr.coeff[k] : 0);
+                access.cls.push_back(classifyStride(affine, access.bytes[k], addr.elem_bytes));
+            }
+            strides.push_back(access);
+        }
+        return strides;
+    }
 
+    long long getNumIters() { return _num_iters; }
+    long long getNumAccesses() { return _num_acs; }
+    long long getNumPairs() { return _num_pairs; }
+    int getNumSkippedAccesses() { return _num_skipped_acs; }
+    bool isSkippedLoop() { return _skipped_loop; }
+    int getNumDenseTables() { return _dense_tables.size(); }
+    long long getWindow() { return _window; }
+    bool isSpilled() { return _spilled; }
+    bool isJITted() { return _jitted; }
+    bool isSpecialized() { return _specialized; }
+    long long getSpillBytes() { return _spill_bytes; }
 
+    // Write table and distances of the dependent pairs. Only windowed
+    // eviction shrinks them during checkDependence, so after it this is
+    // about the high-water mark. Spilled runs count with their write
+    // buffers and the largest partition join table.
+    void getMemUsage(mem_usage_t& usage) {
+        if (_spilled) {
+            usage.add(MEM_WRITE_TABLE, 0, (2 * _num_partitions + 1) * SPILL_BUFFER_SIZE);
+            usage.add(_spill_join_mem);
+        }
+        usage.add(MEM_WRITE_TABLE, _elem_last_writer.size(),
+                  _elem_last_writer.bucket_count() * sizeof(void*) +
+                  _elem_last_writer.size() *
+                      hashNodeBytes<std::pair<const elem_key_t, long long>>());
+        usage.add(MEM_WRITE_TABLE, 0, _jit_last_writer.bucket_count() * sizeof(void*));
+        for (auto& entry: _jit_last_writer) {
+            usage.add(MEM_WRITE_TABLE, 1,
+                      hashNodeBytes<std::pair<const std::string, long long>>() +
+                      heapBytes(entry.first));
+        }
+        usage.add(MEM_WRITE_TABLE, 0, _w_mem_acs.bucket_count() * sizeof(void*));
+        for (auto& obj: _w_mem_acs) {
+            usage.add(MEM_WRITE_TABLE, 0,
+                      hashNodeBytes<std::pair<const std::string, offset_map_t>>() +
+                      heapBytes(obj.first) +
+                      obj.second.bucket_count() * sizeof(void*));
+            for (auto& w: obj.second) {
+                usage.add(MEM_WRITE_TABLE, 1,
+                          hashNodeBytes<std::pair<const std::string, ArrayPos>>() +
+                          heapBytes(w.first));
+                usage.add(MEM_ARRAY_POS, 1, heapBytes(w.second.getPos()));
             }
         }
+        for (auto& block: _window_blocks) {
+            usage.add(MEM_WRITE_TABLE, 0, sizeof(window_block_t) + heapBytes(block.keys));
+        }
+        for (auto& obj: _dense_tables) {
+            usage.add(MEM_WRITE_TABLE, obj.second.last_writer.size(),
+                      heapBytes(obj.second.last_writer) + heapBytes(obj.second.lo) * 3);
+        }
+        // Tree nodes of the distance set: the value, three links and a color
+        for (auto& d: _flow_dists) {
+            usage.add(MEM_DEP_PAIRS, 1, sizeof(d) + 4 * sizeof(void*) + heapBytes(d));
+        }
     }
 };
 
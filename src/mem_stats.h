@@ -0,0 +1,89 @@
+#ifndef MEM_STATS_H_
+#define MEM_STATS_H_
+#include <string>
+#include <vector>
+
+// Memory accounting of the analysis data structures. Bytes are estimates:
+// the object itself plus the heap storage of its strings and vectors, and
+// the node and bucket overhead of std containers.
+enum mem_category_t {
+    MEM_PAT_NODE = 0,          // PatNode
+    MEM_LOOP_MEM_PAT_NODE = 1, // LoopMemPatNode, with its LoopPat / RecurrencePat
+    MEM_MEM_ACS_PAT = 2,       // MemAcsPat
+    MEM_WRITE_TABLE = 3,       // _w_mem_acs entries (keys and hash nodes)
+    MEM_ARRAY_POS = 4,         // ArrayPos positions (their vectors)
+    MEM_DEP_PAIRS = 5,         // distance vectors of the dependent pairs
+    MEM_DFG = 6,               // DFG node and edge lists
+    NUM_MEM_CATEGORIES = 7
+};
+
+static const char* mem_category_names[NUM_MEM_CATEGORIES] = {
+    "pat_node", "loop_mem_pat_node", "mem_acs_pat", "write_table",
+    "array_pos", "dep_pairs", "dfg"};
+
+struct mem_usage_t {
+    long long objects[NUM_MEM_CATEGORIES] = {0};
+    long long bytes[NUM_MEM_CATEGORIES] = {0};
+
+    void add(mem_category_t cat, long long num_objects, long long num_bytes) {
+        objects[cat] += num_objects;
+        bytes[cat] += num_bytes;
+    }
+
+    void add(const mem_usage_t& other) {
+        for (int c = 0; c < NUM_MEM_CATEGORIES; c++) {
+            objects[c] += other.objects[c];
+            bytes[c] += other.bytes[c];
+        }
+    }
+
+    void sub(const mem_usage_t& other) {
+        for (int c = 0; c < NUM_MEM_CATEGORIES; c++) {
+            objects[c] -= other.objects[c];
+            bytes[c] -= other.bytes[c];
+        }
+    }
+
+    long long getTotalBytes() const {
+        long long total = 0;
+        for (int c = 0; c < NUM_MEM_CATEGORIES; c++) {
+            total += bytes[c];
+        }
+        return total;
+    }
+};
+
+// Live pattern objects. The pattern classes update it from their
+// constructors, destructors and when their children vectors grow.
+class MemAccount {
+public:
+    inline static mem_usage_t live;
+
+    static void add(mem_category_t cat, long long num_objects,
+                    long long num_bytes) {
+        live.add(cat, num_objects, num_bytes);
+    }
+};
+
+// Heap bytes of a string (none while it fits the small string buffer)
+inline long long heapBytes(const std::string& s) {
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+template <class T>
+inline long long heapBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// Node of a std::list / std::unordered_map holding a T
+template <class T>
+inline long long listNodeBytes() {
+    return sizeof(T) + 2 * sizeof(void*);
+}
+
+template <class T>
+inline long long hashNodeBytes() {
+    return sizeof(T) + sizeof(void*) + sizeof(size_t);
+}
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "affine.h"
+#include "json_report.h"
+#include "pattern.h"
+#include "unroll.h"
+
+// Whether references a and b may touch the same element in two iterations
+// of the loops ind_vars (from the outermost one) that differ first in the
+// last of them, i.e. whether that loop may carry a dependence between
+// them. Subscripts over the ind vars of inner loops constrain nothing;
+// ones that are not separable are assumed to overlap. trip 0 means
+// unknown.
+inline bool mayCarryDependence(PatNode* a, PatNode* b, const std::vector<std::string>& ind_vars,
+                               const std::vector<int>& step, const std::vector<long long>& trip,
+                               const std::map<std::string, Interval>& ranges) {
+    if (a->getValueName() != b->getValueName() || !mayOverlap(a, b, ranges, ranges)) {
+        return false;
+    }
+    int level = ind_vars.size() - 1;
+    std::vector<dist_t> dist;
+    auto kind = getSeparableDistance(a, b, ind_vars, step, trip, level, true, dist);
+    if (kind != DEP_DIST) {
+        return kind == DEP_UNKNOWN;
+    }
+    return dist[level].any || dist[level].val != 0;
+}
+
+// JSON list of the loops without loop-carried memory dependences:
+//   [{"function": ..., "ind_var": ..., "depth": d, "file": ..., "line": n,
+//     "column": n, "innermost": b, "reductions": n}, ...]
+class ParallelLoopReport : public JSONListReport {
+public:
+    void write(const std::string& func_name, const std::string& ind_var, int depth,
+               const llvm::DebugLoc& loc, bool innermost, int num_reductions) {
+        if (!_json) {
+            return;
+        }
+        _json->object([&] {
+            _json->attribute("function", func_name);
+            _json->attribute("ind_var", ind_var);
+            _json->attribute("depth", depth);
+            if (loc) {
+                _json->attribute("file", loc->getFilename());
+                _json->attribute("line", (int64_t)loc.getLine());
+                _json->attribute("column", (int64_t)loc.getCol());
+            }
+            _json->attribute("innermost", innermost);
+            _json->attribute("reductions", num_reductions);
+        });
+    }
+};
+
+#endif
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "mem_stats.h"
+
 enum pat_node_type_t {
   CONSTANT = 0,
   BIN_OP = 1,
@@ -70,6 +72,14 @@ public:
       constant = std::string(" ");
     }
     type_name = typeToString(type);
+    MemAccount::add(MEM_PAT_NODE, 1, getMemBytes());
+  }
+
+  ~PatNode() { MemAccount::add(MEM_PAT_NODE, -1, -getMemBytes()); }
+
+  long long getMemBytes() {
+    return sizeof(PatNode) + heapBytes(type_name) + heapBytes(constant) +
+           heapBytes(val_name) + heapBytes(op) + heapBytes(children);
   }
   // PatNode(llvm::Value *val, pat_node_type_t type, int value)
   //     : val(val), type(static_cast<int>(type)), constant(value) {}
@@ -115,8 +125,10 @@ public:
   }
 
   void addChild(PatNode *child) {
+    long long old_bytes = heapBytes(children);
     children.push_back(child);
     num_children++;
+    MemAccount::add(MEM_PAT_NODE, 0, heapBytes(children) - old_bytes);
   }
 
   std::vector<PatNode *> &getChildren() { return children; }
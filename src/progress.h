@@ -0,0 +1,102 @@
+#ifndef PROGRESS_H_
+#define PROGRESS_H_
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Progress of long dependence enumerations. The enumeration calls
+// sample() every few thousand iterations; only when a report interval
+// has passed is anything formatted. Reports go to stderr, or replace the
+// content of a status file.
+class ProgressReporter {
+private:
+    double _interval;  // seconds between reports, 0 = disabled
+    std::string _file; // status file, empty = stderr
+
+    std::string _func_name;
+    std::string _loop_name;
+    long long _total = 0; // iterations of the current loop nest
+
+    std::chrono::steady_clock::time_point _start;
+    std::chrono::steady_clock::time_point _next;
+    bool _reported = false;
+
+    double elapsed(std::chrono::steady_clock::time_point now) {
+        return std::chrono::duration<double>(now - _start).count();
+    }
+
+    void write(const char* state, long long done, double secs) {
+        double rate = secs > 0 ? done / secs : 0;
+        char line[512];
+        int len = snprintf(line, sizeof(line),
+                           "DFGPass progress: %s %s loop %s: %lld/%lld "
+                           "iterations (%.1f%%), %.3g iterations/s, ",
+                           state, _func_name.c_str(), _loop_name.c_str(),
+                           done, _total,
+                           _total > 0 ? 100.0 * done / _total : 100.0, rate);
+        if (done >= _total) {
+            len += snprintf(line + len, sizeof(line) - len, "%.1f s\n", secs);
+        } else if (rate > 0) {
+            len += snprintf(line + len, sizeof(line) - len, "ETA %.0f s\n",
+                            (_total - done) / rate);
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, "ETA unknown\n");
+        }
+
+        if (_file.empty()) {
+            fputs(line, stderr);
+            return;
+        }
+        // Write a new file and rename it, so readers never see a partial one
+        std::string tmp = _file + ".tmp";
+        FILE* fp = fopen(tmp.c_str(), "w");
+        if (!fp) {
+            return;
+        }
+        fputs(line, fp);
+        fclose(fp);
+        rename(tmp.c_str(), _file.c_str());
+    }
+
+public:
+    // Iterations between two clock reads
+    static const long long SAMPLE_MASK = 4095;
+
+    ProgressReporter(double interval, const std::string& file)
+        : _interval(interval), _file(file) {}
+
+    bool isEnabled() { return _interval > 0; }
+
+    void setFunction(const std::string& func_name) { _func_name = func_name; }
+
+    void beginLoop(const std::string& loop_name, long long total) {
+        _loop_name = loop_name;
+        _total = total;
+        _reported = false;
+        _start = std::chrono::steady_clock::now();
+        _next = _start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                             std::chrono::duration<double>(_interval));
+    }
+
+    // Called with the number of enumerated iterations every
+    // SAMPLE_MASK + 1 iterations
+    void sample(long long done) {
+        auto now = std::chrono::steady_clock::now();
+        if (now < _next) {
+            return;
+        }
+        _next = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double>(_interval));
+        _reported = true;
+        write("running", done, elapsed(now));
+    }
+
+    // Final report, only for loops that were reported on while running
+    void endLoop(long long done) {
+        if (_reported) {
+            write("finished", done, elapsed(std::chrono::steady_clock::now()));
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef SCC_H_
+#define SCC_H_
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Strongly connected components of a directed graph with nodes 0..n-1.
+// Pearce's iterative algorithm (no recursion, one index array per node),
+// followed by the condensation DAG over the components.
+class SCCAnalysis {
+private:
+    int _num_nodes;
+    // CSR adjacency
+    std::vector<int> _adj_offset;
+    std::vector<int> _adj;
+
+    int _num_scc = 0;
+    std::vector<int> _scc_id;                // node -> component
+    std::vector<int> _scc_size;              // component -> number of nodes
+    std::vector<bool> _scc_self_loop;        // component has an edge to itself
+    std::vector<std::pair<int, int>> _dag_edges;
+
+public:
+    SCCAnalysis(int num_nodes, const std::vector<std::pair<int, int>>& edges)
+        : _num_nodes(num_nodes) {
+        _adj_offset.assign(num_nodes + 1, 0);
+        for (auto& e : edges) {
+            _adj_offset[e.first + 1]++;
+        }
+        for (int v = 0; v < num_nodes; v++) {
+            _adj_offset[v + 1] += _adj_offset[v];
+        }
+        _adj.resize(edges.size());
+        std::vector<int> pos(_adj_offset.begin(), _adj_offset.end() - 1);
+        for (auto& e : edges) {
+            _adj[pos[e.first]++] = e.second;
+        }
+    }
+
+    void run() {
+        int n = _num_nodes;
+        // rindex[v] is the visit index while v is open, and a component
+        // number counting down from n - 1 once v is assigned (so it never
+        // compares smaller than an open index)
+        std::vector<int> rindex(n, 0);
+        std::vector<bool> root(n, false);
+        std::vector<int> stack;
+        std::vector<std::pair<int, int>> call_stack; // (node, next edge)
+        int index = 1;
+        int c = n - 1;
+
+        for (int s = 0; s < n; s++) {
+            if (rindex[s] != 0) {
+                continue;
+            }
+            rindex[s] = index++;
+            root[s] = true;
+            call_stack.push_back(std::make_pair(s, _adj_offset[s]));
+
+            while (!call_stack.empty()) {
+                int v = call_stack.back().first;
+                int& e = call_stack.back().second;
+                if (e < _adj_offset[v + 1]) {
+                    int w = _adj[e++];
+                    if (rindex[w] == 0) {
+                        rindex[w] = index++;
+                        root[w] = true;
+                        call_stack.push_back(std::make_pair(w, _adj_offset[w]));
+                    } else if (rindex[w] < rindex[v]) {
+                        rindex[v] = rindex[w];
+                        root[v] = false;
+                    }
+                    continue;
+                }
+
+                // v is finished
+                call_stack.pop_back();
+                if (root[v]) {
+                    index--;
+                    while (!stack.empty() && rindex[v] <= rindex[stack.back()]) {
+                        int w = stack.back();
+                        stack.pop_back();
+                        rindex[w] = c;
+                        index--;
+                    }
+                    rindex[v] = c;
+                    c--;
+                } else {
+                    stack.push_back(v);
+                }
+                if (!call_stack.empty()) {
+                    int u = call_stack.back().first;
+                    if (rindex[v] < rindex[u]) {
+                        rindex[u] = rindex[v];
+                        root[u] = false;
+                    }
+                }
+            }
+        }
+
+        // Components are completed in reverse topological order, number
+        // them so that edges of the condensation go from lower to higher ids
+        _num_scc = n - 1 - c;
+        _scc_id.resize(n);
+        _scc_size.assign(_num_scc, 0);
+        _scc_self_loop.assign(_num_scc, false);
+        for (int v = 0; v < n; v++) {
+            _scc_id[v] = rindex[v] - (c + 1);
+            _scc_size[_scc_id[v]]++;
+        }
+
+        // Condensation DAG
+        _dag_edges.clear();
+        for (int v = 0; v < n; v++) {
+            for (int e = _adj_offset[v]; e < _adj_offset[v + 1]; e++) {
+                int from = _scc_id[v];
+                int to = _scc_id[_adj[e]];
+                if (from != to) {
+                    _dag_edges.push_back(std::make_pair(from, to));
+                } else if (v == _adj[e]) {
+                    _scc_self_loop[from] = true;
+                }
+            }
+        }
+        std::sort(_dag_edges.begin(), _dag_edges.end());
+        _dag_edges.erase(std::unique(_dag_edges.begin(), _dag_edges.end()),
+                         _dag_edges.end());
+    }
+
+    int getNumSCC() { return _num_scc; }
+
+    int getSCCId(int node) { return _scc_id[node]; }
+
+    int getSCCSize(int scc) { return _scc_size[scc]; }
+
+    // A component is a cycle if it has more than one node or a self loop
+    bool isCyclic(int scc) {
+        return _scc_size[scc] > 1 || _scc_self_loop[scc];
+    }
+
+    // Edges of the condensation DAG, sorted, from lower to higher ids
+    std::vector<std::pair<int, int>>& getDAGEdges() { return _dag_edges; }
+
+    // Longest path (in components) of the condensation DAG ending at each
+    // component, weighted by weight[scc]
+    std::vector<int> getLongestPath(const std::vector<int>& weight) {
+        std::vector<int> dist(weight.begin(), weight.end());
+        // DAG edges are sorted by source and go from lower to higher ids, so
+        // visiting them in order is a topological relaxation
+        for (auto& e : _dag_edges) {
+            dist[e.second] = std::max(dist[e.second], dist[e.first] + weight[e.second]);
+        }
+        return dist;
+    }
+};
+
+#endif
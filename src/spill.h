@@ -0,0 +1,81 @@
+#ifndef SPILL_H_
+#define SPILL_H_
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <memory>
+#include <string>
+
+// Write buffer of each run; the file system only sees writes of this size
+static const size_t SPILL_BUFFER_SIZE = 256 << 10;
+
+// Append-only temporary file of records for the out-of-core dependence
+// enumeration. Records are written through a large buffer while the run
+// is open, and read back in place once it is mapped. The file is removed
+// when the run is destroyed.
+class SpillRun {
+private:
+    std::string _path;
+    std::unique_ptr<llvm::raw_fd_ostream> _os;
+    std::unique_ptr<llvm::MemoryBuffer> _buf;
+    long long _bytes = 0;
+
+public:
+    SpillRun() {}
+    SpillRun(const SpillRun&) = delete;
+    SpillRun& operator=(const SpillRun&) = delete;
+
+    ~SpillRun() {
+        _os.reset();
+        _buf.reset();
+        if (!_path.empty()) {
+            llvm::sys::fs::remove(_path);
+        }
+    }
+
+    // Create the file in dir; false if it cannot be created
+    bool open(const std::string& dir) {
+        int fd;
+        llvm::SmallString<128> path;
+        if (llvm::sys::fs::createUniqueFile(dir + "/dfg-spill-%%%%%%%%.run", fd, path)) {
+            return false;
+        }
+        _path = std::string(path.str());
+        _os.reset(new llvm::raw_fd_ostream(fd, true));
+        _os->SetBufferSize(SPILL_BUFFER_SIZE);
+        return true;
+    }
+
+    void append(const void* data, size_t size) {
+        _os->write((const char*)data, size);
+        _bytes += size;
+    }
+
+    // Flush the file and map it for reading; false on an I/O error
+    bool map() {
+        _os->close();
+        bool error = _os->has_error();
+        _os->clear_error();
+        _os.reset();
+        if (error) {
+            return false;
+        }
+        if (_bytes == 0) {
+            return true;
+        }
+        auto buf = llvm::MemoryBuffer::getFile(_path, false, false);
+        if (!buf) {
+            return false;
+        }
+        _buf = std::move(*buf);
+        return true;
+    }
+
+    const char* begin() { return _buf ? _buf->getBufferStart() : nullptr; }
+    const char* end() { return _buf ? _buf->getBufferEnd() : nullptr; }
+    long long getBytes() { return _bytes; }
+};
+
+#endif
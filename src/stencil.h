@@ -0,0 +1,207 @@
+#ifndef STENCIL_H_
+#define STENCIL_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "affine.h"
+#include "json_report.h"
+#include "loop_mem_pat_node.h"
+
+// Stencil nests: one written array, and reads whose subscripts are those
+// of the write plus constants. Offsets are in elements of each subscript,
+// from the outermost one.
+
+typedef std::vector<long long> stencil_offset_t;
+
+struct stencil_t {
+    bool valid = false;
+    std::string reason;               // why the nest is not a stencil, if not valid
+    std::string array;                // written array
+    std::vector<std::string> sources; // arrays read, sorted
+    int dims = 0;                     // subscripts
+    std::vector<stencil_offset_t> offsets; // distinct offsets of the reads, sorted
+    long long radius = 0;             // largest offset in any subscript
+    bool star = true;                 // every offset moves along one subscript at most
+    bool box = false;                 // the offsets fill the cube [-radius, radius]^dims
+    bool in_place = false;            // the written array is read
+    int points = 0;                   // distinct array elements read per update
+    int reads = 0;                    // read references
+
+    // "star", "box", or "general" for other offset sets
+    const char* getShape() const { return star ? "star" : box ? "box" : "general"; }
+
+    // e.g. "2D 5-point star, radius 1, in place: A <- A"
+    std::string describe() const {
+        std::ostringstream os;
+        os << dims << "D " << points << "-point " << getShape() << ", radius "
+           << radius << ", " << (in_place ? "in place" : "out of place") << ": " << array
+           << " <-";
+        for (size_t s = 0; s < sources.size(); s++) {
+            os << (s ? ", " : " ") << sources[s];
+        }
+        return os.str();
+    }
+};
+
+// Stencil formed by the references refs of a loop body, over the ind vars
+// of its nest
+inline stencil_t recognizeStencil(const std::vector<MemAcsPat*>& refs,
+                                  const std::vector<std::string>& ind_vars) {
+    stencil_t stencil;
+    std::vector<AffineExpr> base;
+    for (auto ref: refs) {
+        if (ref->getAccessMode() != WRITE) {
+            continue;
+        }
+        PatNode* pn = ref->getPatNode();
+        if (!stencil.array.empty() && stencil.array != pn->getValueName()) {
+            stencil.reason = "several written arrays";
+            return stencil;
+        }
+        std::vector<AffineExpr> subs;
+        for (auto sub: pn->getChildren()) {
+            subs.push_back(AffineExpr::fromPattern(sub));
+            if (!subs.back().isValid()) {
+                stencil.reason = "non-affine write";
+                return stencil;
+            }
+        }
+        if (!stencil.array.empty() && subs.size() != base.size()) {
+            stencil.reason = "several written elements";
+            return stencil;
+        }
+        for (size_t s = 0; s < base.size(); s++) {
+            AffineExpr diff = subs[s];
+            diff.add(base[s], -1);
+            if (!diff.isConstant() || diff.getConstant() != 0) {
+                stencil.reason = "several written elements";
+                return stencil;
+            }
+        }
+        stencil.array = pn->getValueName();
+        base = subs;
+    }
+    if (stencil.array.empty()) {
+        stencil.reason = "no write";
+        return stencil;
+    }
+    // The written element must move with the nest
+    bool moves = false;
+    for (auto& sub: base) {
+        for (auto& ind_var: ind_vars) {
+            moves = moves || sub.getCoeff(ind_var) != 0;
+        }
+    }
+    if (!moves) {
+        stencil.reason = "write invariant in the loops";
+        return stencil;
+    }
+
+    std::set<std::string> sources;
+    std::set<stencil_offset_t> offsets;
+    std::set<std::pair<std::string, stencil_offset_t>> points;
+    for (auto ref: refs) {
+        if (ref->getAccessMode() != READ) {
+            continue;
+        }
+        PatNode* pn = ref->getPatNode();
+        auto& subs = pn->getChildren();
+        if (subs.size() != base.size()) {
+            stencil.reason = "read of " + pn->getValueName() + " with another shape";
+            return stencil;
+        }
+        stencil_offset_t offset;
+        for (size_t s = 0; s < subs.size(); s++) {
+            AffineExpr diff = AffineExpr::fromPattern(subs[s]);
+            diff.add(base[s], -1);
+            if (!diff.isConstant()) {
+                stencil.reason = "read of " + pn->getValueName() + " not at a constant offset";
+                return stencil;
+            }
+            offset.push_back(diff.getConstant());
+        }
+        sources.insert(pn->getValueName());
+        offsets.insert(offset);
+        points.insert({pn->getValueName(), offset});
+        stencil.reads++;
+    }
+    if (points.size() < 2) {
+        stencil.reason = points.empty() ? "no read" : "single point read";
+        return stencil;
+    }
+    stencil.valid = true;
+    stencil.dims = base.size();
+    stencil.sources.assign(sources.begin(), sources.end());
+    stencil.offsets.assign(offsets.begin(), offsets.end());
+    stencil.in_place = sources.count(stencil.array) > 0;
+    stencil.points = points.size();
+    for (auto& offset: stencil.offsets) {
+        int moved = 0;
+        for (long long o: offset) {
+            stencil.radius = std::max(stencil.radius, std::abs(o));
+            moved += o != 0;
+        }
+        stencil.star = stencil.star && moved <= 1;
+    }
+    // The offsets are distinct and within the radius
+    long long cube = 1;
+    for (int s = 0; s < stencil.dims && cube <= (long long)stencil.offsets.size(); s++) {
+        cube *= 2 * stencil.radius + 1;
+    }
+    stencil.box = cube == (long long)stencil.offsets.size();
+    return stencil;
+}
+
+// JSON list of the stencil nests:
+//   [{"function": ..., "loops": [ind_var, ...], "file": ..., "line": n,
+//     "descriptor": ..., "array": ..., "sources": [...], "dims": n,
+//     "offsets": [[n, ...], ...], "radius": n, "shape": "star" | "box" | "general",
+//     "in_place": b, "points": n, "reads": n}, ...]
+class StencilReport : public JSONListReport {
+public:
+    // The descriptor, as object attributes
+    static void writeStencil(llvm::json::OStream& json, const stencil_t& stencil) {
+        json.attribute("descriptor", stencil.describe());
+        json.attribute("array", stencil.array);
+        json.attributeArray("sources", [&] {
+            for (auto& source: stencil.sources) {
+                json.value(source);
+            }
+        });
+        json.attribute("dims", stencil.dims);
+        json.attributeArray("offsets", [&] {
+            for (auto& offset: stencil.offsets) {
+                json.array([&] {
+                    for (long long o: offset) {
+                        json.value(o);
+                    }
+                });
+            }
+        });
+        json.attribute("radius", stencil.radius);
+        json.attribute("shape", stencil.getShape());
+        json.attribute("in_place", stencil.in_place);
+        json.attribute("points", stencil.points);
+        json.attribute("reads", stencil.reads);
+    }
+
+    void write(const std::string& func_name, const std::vector<std::string>& ind_vars,
+               const llvm::DebugLoc& loc, const stencil_t& stencil) {
+        if (!_json || !stencil.valid) {
+            return;
+        }
+        _json->object([&] {
+            writeLoopNest(func_name, ind_vars, loc);
+            writeStencil(*_json, stencil);
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef STRIDE_H_
+#define STRIDE_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+#include <vector>
+
+#include "cache_model.h"
+#include "json_report.h"
+
+// Stride of every memory access with respect to each loop of its nest, and
+// whether each loop, made innermost, would vectorize.
+
+enum stride_class_t {
+    STRIDE_INVARIANT = 0, // the same address every iteration
+    STRIDE_UNIT = 1,      // the next element
+    STRIDE_REVERSED = 2,  // the previous element
+    STRIDE_CONSTANT = 3,  // any other constant stride
+    STRIDE_IRREGULAR = 4  // not affine in the ind vars: non-affine or indirect
+};
+
+static const char* stride_class_names[] = {"invariant", "unit", "reversed", "constant",
+                                           "irregular"};
+
+inline stride_class_t classifyStride(bool affine, long long bytes, long long elem_bytes) {
+    if (!affine) {
+        return STRIDE_IRREGULAR;
+    }
+    if (bytes == 0) {
+        return STRIDE_INVARIANT;
+    }
+    if (bytes == elem_bytes) {
+        return STRIDE_UNIT;
+    }
+    if (bytes == -elem_bytes) {
+        return STRIDE_REVERSED;
+    }
+    return STRIDE_CONSTANT;
+}
+
+struct access_stride_t {
+    std::string array;
+    bool write = false;
+    long long elem_bytes = 0;
+    std::vector<stride_class_t> cls; // per loop of the nest, from the outermost
+    std::vector<long long> bytes;    // per iteration of each loop, 0 if irregular
+    const llvm::Instruction* inst = nullptr; // GEP, for its location
+};
+
+enum vector_verdict_t {
+    VEC_CONTIGUOUS = 0, // unit, reversed and invariant accesses only
+    VEC_STRIDED = 1,    // needs strided or interleaved accesses
+    VEC_IRREGULAR = 2,  // needs gathers or scatters
+    VEC_DEPENDENT = 3   // carries a memory dependence
+};
+
+static const char* vector_verdict_names[] = {"vectorizable", "strided", "irregular",
+                                             "dependent"};
+
+// Verdict for the loop at level of the nest, if it were innermost
+inline vector_verdict_t getVectorVerdict(const std::vector<access_stride_t>& strides, int level,
+                                         bool parallel) {
+    if (!parallel) {
+        return VEC_DEPENDENT;
+    }
+    vector_verdict_t verdict = VEC_CONTIGUOUS;
+    for (auto& access: strides) {
+        if (access.cls[level] == STRIDE_IRREGULAR) {
+            return VEC_IRREGULAR;
+        }
+        if (access.cls[level] == STRIDE_CONSTANT) {
+            verdict = VEC_STRIDED;
+        }
+    }
+    return verdict;
+}
+
+// JSON list of the leaf loop nests with the verdict of each loop and the
+// accesses the innermost loop does not walk with unit stride:
+//   [{"function": ..., "file": ..., "line": n,
+//     "loops": [{"ind_var": ..., "verdict": ...}, ...],
+//     "non_unit": [{"array": ..., "write": b, "stride": class,
+//                   "bytes": n, "line": n}, ...]}, ...]
+class StrideReport : public JSONListReport {
+public:
+    void write(const std::string& func_name, const std::vector<std::string>& ind_vars,
+               const llvm::DebugLoc& loc, const std::vector<vector_verdict_t>& verdicts,
+               const std::vector<access_stride_t>& strides) {
+        if (!_json) {
+            return;
+        }
+        int inner = ind_vars.size() - 1;
+        _json->object([&] {
+            _json->attribute("function", func_name);
+            if (loc) {
+                _json->attribute("file", loc->getFilename());
+                _json->attribute("line", (int64_t)loc.getLine());
+            }
+            _json->attributeArray("loops", [&] {
+                for (size_t k = 0; k < ind_vars.size(); k++) {
+                    _json->object([&] {
+                        _json->attribute("ind_var", ind_vars[k]);
+                        _json->attribute("verdict", vector_verdict_names[verdicts[k]]);
+                    });
+                }
+            });
+            _json->attributeArray("non_unit", [&] {
+                for (auto& access: strides) {
+                    stride_class_t cls = access.cls[inner];
+                    if (cls == STRIDE_UNIT || cls == STRIDE_INVARIANT) {
+                        continue;
+                    }
+                    _json->object([&] {
+                        _json->attribute("array", access.array);
+                        _json->attribute("write", access.write);
+                        _json->attribute("stride", stride_class_names[cls]);
+                        _json->attribute("bytes", access.bytes[inner]);
+                        auto& access_loc = access.inst->getDebugLoc();
+                        if (access_loc) {
+                            _json->attribute("line", (int64_t)access_loc.getLine());
+                        }
+                    });
+                }
+            });
+        });
+    }
+};
+
+#endif
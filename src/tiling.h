@@ -0,0 +1,172 @@
+#ifndef TILING_H_
+#define TILING_H_
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "affine.h"
+#include "cache_model.h"
+#include "json_report.h"
+#include "pattern.h"
+#include "wavefront.h"
+
+// Tile sizes of the outermost fully permutable band of a perfect leaf loop
+// nest, for each cache level. The working set of a tile is the bounding
+// box of the elements each array is accessed at, the innermost subscript
+// rounded up to cache lines.
+
+struct tile_level_t {
+    std::vector<long long> sizes; // iterations per tile, from the outermost loop
+    long long bytes = 0;          // working set of one tile
+};
+
+struct tiling_advice_t {
+    bool valid = false;
+    std::string reason;     // why there is no advice, if not valid
+    int band = 0;           // loops of the permutable band, from the outermost
+    long long nest_bytes = 0; // working set of the whole nest
+    tile_level_t levels[NUM_CACHE_LEVELS];
+};
+
+// Subscripts of the references to one array
+struct tile_array_t {
+    long long elem_bytes = 0;
+    std::vector<std::vector<AffineExpr>> refs;
+};
+
+// Loops, from the outermost one, that the dependences distances allow to
+// permute: every distance is nonnegative in each of them
+inline int getPermutableBand(const std::set<dist_vec_t>& deps, int depth) {
+    int band = depth;
+    for (auto& d: deps) {
+        for (int k = 0; k < band; k++) {
+            if (d[k] < 0) {
+                band = k;
+                break;
+            }
+        }
+    }
+    return band;
+}
+
+// Bytes touched by a tile of sizes iterations at the start of every loop;
+// -1 if a subscript is not affine in the ind vars of the nest
+inline long long getTileBytes(const std::map<std::string, tile_array_t>& arrays,
+                              const std::vector<std::string>& ind_vars,
+                              const std::vector<int>& start, const std::vector<int>& step,
+                              const std::vector<long long>& sizes, int line_bytes) {
+    std::map<std::string, Interval> ranges;
+    for (size_t k = 0; k < ind_vars.size(); k++) {
+        long long last = start[k] + (long long)step[k] * (sizes[k] - 1);
+        ranges[ind_vars[k]] = Interval(std::min<long long>(start[k], last),
+                                       std::max<long long>(start[k], last));
+    }
+    long long bytes = 0;
+    for (auto& array: arrays) {
+        std::vector<Interval> box;
+        for (auto& subs: array.second.refs) {
+            box.resize(subs.size());
+            for (size_t s = 0; s < subs.size(); s++) {
+                Interval range = subs[s].getRange(ranges);
+                if (!range.known) {
+                    return -1;
+                }
+                if (!box[s].known) {
+                    box[s] = range;
+                }
+                box[s].lo = std::min(box[s].lo, range.lo);
+                box[s].hi = std::max(box[s].hi, range.hi);
+            }
+        }
+        long long elems = 1;
+        for (size_t s = 0; s + 1 < box.size(); s++) {
+            elems *= box[s].hi - box[s].lo + 1;
+        }
+        long long inner = box.empty() ? 1 : box.back().hi - box.back().lo + 1;
+        long long lines = (inner * array.second.elem_bytes + line_bytes - 1) / line_bytes;
+        bytes += elems * lines * line_bytes;
+    }
+    return bytes;
+}
+
+// Largest tile of the band that fits in capacity bytes: the band loops
+// are doubled in turn, innermost first, while the tile fits; the loops
+// below the band run whole
+inline tile_level_t fitTile(const std::map<std::string, tile_array_t>& arrays,
+                            const std::vector<std::string>& ind_vars,
+                            const std::vector<int>& start, const std::vector<int>& step,
+                            const std::vector<long long>& trip, int band, long long capacity,
+                            int line_bytes) {
+    tile_level_t tile;
+    tile.sizes = trip;
+    for (int k = 0; k < band; k++) {
+        tile.sizes[k] = 1;
+    }
+    tile.bytes = getTileBytes(arrays, ind_vars, start, step, tile.sizes, line_bytes);
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (int k = band - 1; k >= 0; k--) {
+            if (tile.sizes[k] >= trip[k]) {
+                continue;
+            }
+            std::vector<long long> sizes = tile.sizes;
+            sizes[k] = std::min(trip[k], sizes[k] * 2);
+            long long bytes = getTileBytes(arrays, ind_vars, start, step, sizes, line_bytes);
+            if (bytes <= capacity) {
+                tile.sizes = sizes;
+                tile.bytes = bytes;
+                grown = true;
+            }
+        }
+    }
+    return tile;
+}
+
+// JSON list of the tiling advice of every leaf loop nest:
+//   [{"function": ..., "loops": [ind_var, ...], "file": ..., "line": n,
+//     "legal": b, "band": n, "nest_bytes": n,
+//     "tiles": {"L1": {"sizes": [n, ...], "bytes": n}, ...}}, ...]
+class TilingReport : public JSONListReport {
+public:
+    // Sizes and bytes of each cache level, as an object attribute
+    static void writeTiles(llvm::json::OStream& json, const tiling_advice_t& advice) {
+        json.attributeObject("tiles", [&] {
+            for (int c = 0; c < NUM_CACHE_LEVELS; c++) {
+                json.attributeObject(cache_level_names[c], [&] {
+                    json.attributeArray("sizes", [&] {
+                        for (long long size: advice.levels[c].sizes) {
+                            json.value(size);
+                        }
+                    });
+                    json.attribute("bytes", advice.levels[c].bytes);
+                });
+            }
+        });
+    }
+
+    void write(const std::string& func_name, const std::vector<std::string>& ind_vars,
+               const llvm::DebugLoc& loc, const tiling_advice_t& advice) {
+        if (!_json) {
+            return;
+        }
+        _json->object([&] {
+            writeLoopNest(func_name, ind_vars, loc);
+            _json->attribute("legal", advice.valid);
+            if (!advice.valid) {
+                _json->attribute("reason", advice.reason);
+                return;
+            }
+            _json->attribute("band", advice.band);
+            _json->attribute("nest_bytes", advice.nest_bytes);
+            writeTiles(*_json, advice);
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef UNROLL_H_
+#define UNROLL_H_
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "affine.h"
+#include "pattern.h"
+
+// Unroll and unroll-and-jam factors of a leaf loop nest. Legality of
+// jamming the loop around the leaf loop comes from the distance vectors of
+// every pair of references to the same array with at least one write; the
+// factors are chosen from the dependence distances enumerated by
+// LoopUnrollAnalysis.
+
+// Component of a distance vector, in iterations: a value, or any value
+struct dist_t {
+    bool any = true;
+    long long val = 0;
+};
+
+enum dep_dist_kind_t {
+    DEP_NONE = 0,    // the references never touch the same element
+    DEP_DIST = 1,    // distance vectors given by dist_t components
+    DEP_UNKNOWN = 2  // not separable, anything is possible
+};
+
+// Distance y - x between iterations x and y of the loops ind_vars (from
+// the outermost one) where subscripts a_subs (at x) and b_subs (at y) give
+// the same element. Separable subscripts only: each one constant, or
+// c + coeff * iv for a single ind var iv, with the same coefficient on both
+// sides. The first fixed loops are at the same iteration in x and y, so
+// their terms must be the same on both sides and their distance is 0. With
+// ignore_inner, subscripts over other ind vars (of inner loops) constrain
+// nothing; otherwise they are not separable. trip 0 means unknown.
+inline dep_dist_kind_t getSeparableDistance(const std::vector<AffineExpr>& a_subs,
+                                            const std::vector<AffineExpr>& b_subs,
+                                            const std::vector<std::string>& ind_vars,
+                                            const std::vector<int>& step,
+                                            const std::vector<long long>& trip, int fixed,
+                                            bool ignore_inner, std::vector<dist_t>& dist) {
+    if (a_subs.size() != b_subs.size()) {
+        return DEP_UNKNOWN;
+    }
+    int depth = ind_vars.size();
+    dist.assign(depth, dist_t());
+    for (int k = 0; k < fixed; k++) {
+        dist[k].any = false;
+    }
+    for (size_t s = 0; s < a_subs.size(); s++) {
+        AffineExpr ea = a_subs[s];
+        AffineExpr eb = b_subs[s];
+        if (!ea.isValid() || !eb.isValid()) {
+            return DEP_UNKNOWN;
+        }
+        for (int k = 0; k < fixed; k++) {
+            long long c = ea.getCoeff(ind_vars[k]);
+            if (eb.getCoeff(ind_vars[k]) != c) {
+                return DEP_UNKNOWN;
+            }
+            ea.add(AffineExpr::indVar(ind_vars[k]), -c);
+            eb.add(AffineExpr::indVar(ind_vars[k]), -c);
+        }
+        if (ea.getCoeffs().size() > 1 || eb.getCoeffs().size() > 1) {
+            return DEP_UNKNOWN;
+        }
+        auto getLevel = [&](const AffineExpr& e) {
+            for (int k = fixed; k < depth; k++) {
+                if (e.getCoeff(ind_vars[k]) != 0) {
+                    return k;
+                }
+            }
+            return e.isConstant() ? -1 : -2; // -2: other ind var
+        };
+        int k_a = getLevel(ea);
+        int k_b = getLevel(eb);
+        if (k_a == -2 || k_b == -2) {
+            if (ignore_inner) {
+                continue;
+            }
+            return DEP_UNKNOWN;
+        }
+        long long diff = ea.getConstant() - eb.getConstant();
+        if (k_a < 0 && k_b < 0) {
+            if (diff != 0) {
+                return DEP_NONE;
+            }
+            continue;
+        }
+        if (k_a != k_b) {
+            return DEP_UNKNOWN;
+        }
+        long long coeff = ea.getCoeff(ind_vars[k_a]);
+        if (eb.getCoeff(ind_vars[k_b]) != coeff) {
+            return DEP_UNKNOWN;
+        }
+        // coeff * x + const_a = coeff * y + const_b
+        if (diff % coeff != 0 || (diff / coeff) % step[k_a] != 0) {
+            return DEP_NONE;
+        }
+        long long d = diff / coeff / step[k_a];
+        if ((trip[k_a] > 0 && std::abs(d) >= trip[k_a]) ||
+            (!dist[k_a].any && dist[k_a].val != d)) {
+            return DEP_NONE;
+        }
+        dist[k_a].any = false;
+        dist[k_a].val = d;
+    }
+    return DEP_DIST;
+}
+
+// Affine forms of the subscripts of a reference
+inline std::vector<AffineExpr> getAffineSubscripts(PatNode* pn) {
+    std::vector<AffineExpr> subs;
+    for (auto sub: pn->getChildren()) {
+        subs.push_back(AffineExpr::fromPattern(sub));
+    }
+    return subs;
+}
+
+// The same, between references a and b
+inline dep_dist_kind_t getSeparableDistance(PatNode* a, PatNode* b,
+                                            const std::vector<std::string>& ind_vars,
+                                            const std::vector<int>& step,
+                                            const std::vector<long long>& trip, int fixed,
+                                            bool ignore_inner, std::vector<dist_t>& dist) {
+    if (a->getValueName() != b->getValueName()) {
+        return DEP_NONE;
+    }
+    return getSeparableDistance(getAffineSubscripts(a), getAffineSubscripts(b), ind_vars,
+                                step, trip, fixed, ignore_inner, dist);
+}
+
+// Whether every subscript of references a and b may take the same value,
+// over the ind var ranges of the loops of each
+inline bool mayOverlap(PatNode* a, PatNode* b, const std::map<std::string, Interval>& a_ranges,
+                       const std::map<std::string, Interval>& b_ranges) {
+    auto& a_subs = a->getChildren();
+    auto& b_subs = b->getChildren();
+    for (size_t s = 0; s < a_subs.size() && s < b_subs.size(); s++) {
+        if (!getPatternRange(a_subs[s], a_ranges)
+                 .intersects(getPatternRange(b_subs[s], b_ranges))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Largest unroll-and-jam factor of loop depth - 2 that keeps the
+// dependences with distances dist or -dist, up to limit. Jamming by u runs
+// iterations u apart of the outer loop in the same inner iteration, which
+// reverses dependences carried by the outer loop with an outer distance
+// below u and a negative inner distance.
+inline long long getMaxLegalJam(const std::vector<dist_t>& dist, long long limit) {
+    int depth = dist.size();
+    int outer = depth - 2;
+    for (int sign: {1, -1}) {
+        bool possible = true;
+        for (int k = 0; k < outer; k++) {
+            possible = possible && (dist[k].any || dist[k].val == 0);
+        }
+        const dist_t& inner = dist[depth - 1];
+        possible = possible && (inner.any || sign * inner.val < 0);
+        if (!possible) {
+            continue;
+        }
+        if (dist[outer].any) {
+            return 1;
+        }
+        long long d = sign * dist[outer].val;
+        if (d >= 1) {
+            limit = std::min(limit, d);
+        }
+    }
+    return limit;
+}
+
+// Largest power of two up to limit that divides trip, 1 if none above 1
+inline long long getDividingFactor(long long limit, long long trip) {
+    long long factor = 1;
+    while (factor * 2 <= limit && trip % (factor * 2) == 0) {
+        factor *= 2;
+    }
+    return factor;
+}
+
+struct unroll_advice_t {
+    bool valid = false;      // false: nothing is recommended
+    int unroll = 1;          // innermost loop
+    int unroll_and_jam = 1;  // loop around it
+    long long max_legal_jam = 1;
+    long long inner_dist = 0; // smallest innermost-carried flow distance, 0 = none
+    long long outer_reuse = 0; // smallest outer distance of reused elements, 0 = none
+};
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef WAVEFRONT_H_
+#define WAVEFRONT_H_
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "unroll.h"
+
+// Hyperplane (wavefront) schedules of perfect loop nests whose loops all
+// carry dependences. Iterations are numbered from 0 in every loop, x_k =
+// (iv_k - start_k) / step_k; the schedule runs wavefront t = h . x at time
+// t, and the iterations of one wavefront in parallel. It is legal when
+// h . d >= 1 for every dependence distance d.
+
+// Largest |h_k| tried
+static const int WAVEFRONT_MAX_COEFF = 3;
+// Deepest nest searched, (2 * WAVEFRONT_MAX_COEFF + 1)^depth candidates
+static const int WAVEFRONT_MAX_DEPTH = 6;
+// Distinct distance vectors kept before giving up
+static const size_t WAVEFRONT_MAX_DISTANCES = 4096;
+
+typedef std::vector<long long> dist_vec_t;
+
+struct wavefront_t {
+    bool valid = false;
+    std::string reason;        // why there is no schedule, if not valid
+    std::vector<int> hyperplane;
+    int time_level = -1;       // loop replaced by the time loop, |h| = 1
+    int num_distances = 0;     // distinct distance vectors constraining h
+    long long num_wavefronts = 0;
+    long long max_parallelism = 0;
+    double avg_parallelism = 0;
+    std::vector<std::string> schedule; // transformed nest, one line each
+};
+
+// Lexicographically positive distances of the dependence dist (or -dist,
+// which is the same pair of references the other way round) that bound
+// h . d from below: the corners of the boxes of distances with a given
+// leading level, any components ranging over the trip counts
+inline void addDistanceCorners(const std::vector<dist_t>& dist, const std::vector<long long>& trip,
+                               std::set<dist_vec_t>& deps) {
+    int depth = dist.size();
+    for (int sign: {1, -1}) {
+        for (int lead = 0; lead < depth; lead++) {
+            const dist_t& c = dist[lead];
+            if (!c.any && sign * c.val < 0) {
+                break;
+            }
+            if (!c.any && c.val == 0) {
+                continue;
+            }
+            // Components are 0 before lead, >= 1 at lead
+            std::vector<std::pair<long long, long long>> box(depth, {0, 0});
+            for (int k = lead; k < depth; k++) {
+                if (!dist[k].any) {
+                    box[k] = {sign * dist[k].val, sign * dist[k].val};
+                } else {
+                    box[k] = {k == lead ? 1 : 1 - trip[k], trip[k] - 1};
+                }
+            }
+            if (box[lead].first <= box[lead].second) {
+                for (long long corner = 0; corner < (1LL << depth); corner++) {
+                    dist_vec_t d(depth);
+                    for (int k = 0; k < depth; k++) {
+                        d[k] = (corner >> k) & 1 ? box[k].second : box[k].first;
+                    }
+                    deps.insert(d);
+                }
+            }
+            if (!c.any) {
+                break;
+            }
+        }
+    }
+}
+
+// Number of wavefronts of h over the trip counts
+inline long long getNumWavefronts(const std::vector<int>& h, const std::vector<long long>& trip) {
+    long long num = 1;
+    for (size_t k = 0; k < h.size(); k++) {
+        num += std::abs((long long)h[k]) * (trip[k] - 1);
+    }
+    return num;
+}
+
+// Legal hyperplane with the fewest wavefronts, one coefficient of which is
+// +-1 so that the time loop can replace that loop; false if none has
+// coefficients up to WAVEFRONT_MAX_COEFF
+inline bool findHyperplane(const std::set<dist_vec_t>& deps, const std::vector<long long>& trip,
+                           std::vector<int>& best) {
+    int depth = trip.size();
+    std::vector<int> h(depth, 0);
+    long long best_num = -1;
+    std::function<void(int)> search = [&](int k) {
+        if (k == depth) {
+            bool unit = false;
+            for (int c: h) {
+                unit = unit || std::abs(c) == 1;
+            }
+            if (!unit) {
+                return;
+            }
+            for (auto& d: deps) {
+                long long dot = 0;
+                for (int l = 0; l < depth; l++) {
+                    dot += h[l] * d[l];
+                }
+                if (dot < 1) {
+                    return;
+                }
+            }
+            long long num = getNumWavefronts(h, trip);
+            if (best_num < 0 || num < best_num) {
+                best_num = num;
+                best = h;
+            }
+            return;
+        }
+        // 0, 1, -1, 2, -2, ...: ties go to the smaller coefficients
+        for (int c = 0; c <= 2 * WAVEFRONT_MAX_COEFF; c++) {
+            h[k] = c % 2 ? (c + 1) / 2 : -c / 2;
+            search(k + 1);
+        }
+    };
+    search(0);
+    return best_num >= 0;
+}
+
+// Iterations per wavefront: counts[t - t_min], by adding one loop at a
+// time with prefix sums along each stride
+inline std::vector<long long> getWavefrontSizes(const std::vector<int>& h,
+                                                const std::vector<long long>& trip) {
+    long long t_min = 0, t_max = 0;
+    for (size_t k = 0; k < h.size(); k++) {
+        t_min += std::min(0LL, h[k] * (trip[k] - 1));
+        t_max += std::max(0LL, h[k] * (trip[k] - 1));
+    }
+    long long size = t_max - t_min + 1;
+    std::vector<long long> counts(size, 0), prefix(size);
+    counts[-t_min] = 1;
+    for (size_t k = 0; k < h.size(); k++) {
+        long long c = h[k];
+        if (c == 0) {
+            for (auto& n: counts) {
+                n *= trip[k];
+            }
+            continue;
+        }
+        auto get = [&](std::vector<long long>& v, long long i) {
+            return i >= 0 && i < size ? v[i] : 0;
+        };
+        // prefix[i] = counts[i] + counts[i - c] + counts[i - 2c] + ...
+        for (long long n = 0; n < size; n++) {
+            long long i = c > 0 ? n : size - 1 - n;
+            prefix[i] = counts[i] + get(prefix, i - c);
+        }
+        for (long long i = 0; i < size; i++) {
+            counts[i] = prefix[i] - get(prefix, i - c * trip[k]);
+        }
+    }
+    return counts;
+}
+
+// sum of coeff * name, plus c
+inline std::string linearToString(const std::vector<std::pair<long long, std::string>>& terms,
+                                  long long c) {
+    std::ostringstream os;
+    bool first = true;
+    for (auto& term: terms) {
+        if (term.first == 0) {
+            continue;
+        }
+        long long a = term.first;
+        os << (first ? (a < 0 ? "-" : "") : (a < 0 ? " - " : " + "));
+        if (std::abs(a) != 1) {
+            os << std::abs(a) << "*";
+        }
+        os << term.second;
+        first = false;
+    }
+    if (first) {
+        os << c;
+    } else if (c != 0) {
+        os << (c < 0 ? " - " : " + ") << std::abs(c);
+    }
+    return os.str();
+}
+
+// Transformed loop nest: the time loop, then the other loops in their
+// order, in parallel; the last of them is bounded by the wavefront. x_k
+// of the replaced loop follows from t.
+inline std::vector<std::string> describeSchedule(const std::vector<int>& h, int time_level,
+                                                 const std::vector<std::string>& ind_vars,
+                                                 const std::vector<int>& start,
+                                                 const std::vector<int>& step,
+                                                 const std::vector<long long>& trip) {
+    int depth = h.size();
+    std::vector<std::string> lines;
+    std::vector<int> others;
+    for (int k = 0; k < depth; k++) {
+        if (k != time_level) {
+            others.push_back(k);
+        }
+    }
+    auto x = [&](int k) { return "x_" + ind_vars[k]; };
+    long long t_min = 0, t_max = 0;
+    for (int k = 0; k < depth; k++) {
+        t_min += std::min(0LL, h[k] * (trip[k] - 1));
+        t_max += std::max(0LL, h[k] * (trip[k] - 1));
+    }
+    std::string indent;
+    lines.push_back("for t = " + std::to_string(t_min) + " .. " + std::to_string(t_max) + ":");
+    // u = t - sum of h_j * x_j over the loops other than the time loop
+    // and the last one; s * (u - h_v * x_v) must be in [0, trip - 1]
+    int s = h[time_level];
+    long long last_trip = trip[time_level] - 1;
+    std::vector<std::pair<long long, std::string>> u = {{1, "t"}};
+    for (size_t o = 0; o < others.size(); o++) {
+        int v = others[o];
+        indent += "  ";
+        std::string lo = "0", hi = std::to_string(trip[v] - 1);
+        if (o + 1 == others.size() && h[v] != 0) {
+            // h_v * x_v in [a, b]
+            long long a_c = s > 0 ? -last_trip : 0;
+            long long b_c = s > 0 ? 0 : last_trip;
+            long long hv = h[v];
+            std::string a = linearToString(u, a_c), b = linearToString(u, b_c);
+            if (hv < 0) {
+                std::swap(a, b);
+            }
+            auto div = [&](const std::string& e, const char* round) {
+                if (std::abs(hv) == 1) {
+                    return hv > 0 ? e : "-(" + e + ")";
+                }
+                std::string n = e.find(' ') == std::string::npos ? e : "(" + e + ")";
+                return std::string(round) + "(" + n + " / " + std::to_string(hv) + ")";
+            };
+            lo = "max(0, " + div(a, "ceil") + ")";
+            hi = "min(" + hi + ", " + div(b, "floor") + ")";
+        }
+        lines.push_back(indent + "parallel for " + x(v) + " = " + lo + " .. " + hi + ":");
+        u.push_back({-h[v], x(v)});
+    }
+    indent += "  ";
+    std::vector<std::pair<long long, std::string>> xk;
+    for (auto& term: u) {
+        xk.push_back({s * term.first, term.second});
+    }
+    lines.push_back(indent + x(time_level) + " = " + linearToString(xk, 0));
+    if (others.empty() || h[others.back()] == 0) {
+        lines.push_back(indent + "skip unless 0 <= " + x(time_level) + " <= " +
+                        std::to_string(last_trip));
+    }
+    for (int k = 0; k < depth; k++) {
+        lines.push_back(ind_vars[k] + " = " +
+                        linearToString({{step[k], x(k)}}, start[k]));
+    }
+    return lines;
+}
+
+#endif
@@ -0,0 +1,127 @@
+// Tests of the memory-mapped GML / DOT reader of Graph (graph.cpp). Each
+// test writes its input to a temporary file, reads it back and checks the
+// graph; the program exits with 1 if any test fails.
+//
+//   graph_test
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "graph.h"
+
+using namespace depdetector;
+
+static int num_failed = 0;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond);                      \
+      ok = false;                                                              \
+    }                                                                          \
+  } while (0)
+
+/** Write text to a new temporary file, return its name */
+static std::string WriteTempFile(const std::string &text, const char *suffix) {
+  char name[] = "/tmp/graph_testXXXXXX";
+  int fd = mkstemp(name);
+  if (fd < 0 || write(fd, text.data(), text.size()) != (ssize_t)text.size()) {
+    perror("graph_test");
+    exit(1);
+  }
+  close(fd);
+  std::string file = std::string(name) + suffix;
+  rename(name, file.c_str());
+  return file;
+}
+
+static void Report(const char *test, bool ok) {
+  printf("%-24s %s\n", test, ok ? "ok" : "FAILED");
+  num_failed += ok ? 0 : 1;
+}
+
+/** DOT with sparse vertex ids, and a vertex only named by an edge */
+static void TestDotSparseIds() {
+  const char *dot = "digraph {\n"
+                    "  10 [\n"
+                    "    name=\"a\"\n"
+                    "  ];\n"
+                    "  30;\n"
+                    "  10 -> 20;\n"
+                    "  20 -> 30 [\n"
+                    "    weight=2\n"
+                    "  ];\n"
+                    "}\n";
+  std::string file = WriteTempFile(dot, ".dot");
+  Graph g;
+  g.ReadGraphDot(file.c_str());
+  unlink(file.c_str());
+
+  // 10 and 30 are declared, 20 is added after them
+  bool ok = true;
+  CHECK(g.GetCurVertexNum() == 3);
+  if (ok) {
+    CHECK(g.GetEdgeSrc(0) == 0 && g.GetEdgeDest(0) == 2);
+    CHECK(g.GetEdgeSrc(1) == 2 && g.GetEdgeDest(1) == 1);
+    const char *name = g.GetVertexAttributeString("name", 0);
+    CHECK(name && strcmp(name, "a") == 0);
+    CHECK(g.GetEdgeAttributeNum("weight", 1) == 2);
+  }
+  Report("dot_sparse_ids", ok);
+}
+
+/** GML large enough to be split on a machine with several hardware threads,
+ * with a multi-line string whose lines look like node keys. The string ends
+ * like an attribute key, so that pieces split inside it would still parse,
+ * into the wrong graph. */
+static void TestGMLMultiLineString() {
+  std::string label;
+  while (label.size() < (16 << 20)) {
+    label += "    node [ id 5 ]\n";
+  }
+  label += "    label ";
+  std::string gml = "graph\n"
+                    "[\n"
+                    "  directed 1\n"
+                    "  node\n"
+                    "  [\n"
+                    "    id 0\n"
+                    "    label \"" +
+                    label +
+                    "\"\n"
+                    "  ]\n"
+                    "  node\n"
+                    "  [\n"
+                    "    id 1\n"
+                    "    name \"b\"\n"
+                    "  ]\n"
+                    "  edge\n"
+                    "  [\n"
+                    "    source 0\n"
+                    "    target 1\n"
+                    "  ]\n"
+                    "]\n";
+  std::string file = WriteTempFile(gml, ".gml");
+  Graph g;
+  g.ReadGraphGML(file.c_str());
+  unlink(file.c_str());
+
+  bool ok = true;
+  CHECK(g.GetCurVertexNum() == 2);
+  if (ok) {
+    CHECK(g.GetEdgeSrc(0) == 0 && g.GetEdgeDest(0) == 1);
+    const char *read_label = g.GetVertexAttributeString("label", 0);
+    CHECK(read_label && read_label == label);
+    const char *name = g.GetVertexAttributeString("name", 1);
+    CHECK(name && strcmp(name, "b") == 0);
+  }
+  Report("gml_multi_line_string", ok);
+}
+
+int main() {
+  TestDotSparseIds();
+  TestGMLMultiLineString();
+  return num_failed > 0 ? 1 : 0;
+}